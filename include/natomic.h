@@ -0,0 +1,514 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file natomic.h
+ * @brief Neptune library - Atomic operations.
+ *
+ * A single set of atomic operations on 32-bit, 64-bit and pointer sized
+ * values, mapped to C11 `<stdatomic.h>` with GCC and Clang, to the
+ * Interlocked functions with MSVC and to `atomic_t`/`atomic64_t` in the
+ * kernel. Every operation takes one of the NATOMIC_* memory orders, which
+ * mean what their C11 counterparts do; backends without an exact match
+ * use a stronger order.
+ *
+ * Values must be declared with the natomic types and only accessed
+ * through these functions. Initialize them with the NATOMIC*_INIT macros
+ * or a store. Compare-and-swap functions store the current value into
+ * `expected` when they fail.
+ */
+
+#ifndef __NATOMIC_H__
+#define __NATOMIC_H__
+
+#include "neptune.h"
+
+#ifdef MODULE
+
+#include <linux/atomic.h>
+
+typedef atomic_t natomic32_t;
+typedef atomic64_t natomic64_t;
+typedef void *natomic_ptr_t;
+
+#define NATOMIC32_INIT(value) ATOMIC_INIT(value)
+#define NATOMIC64_INIT(value) ATOMIC64_INIT(value)
+#define NATOMIC_PTR_INIT(value) (value)
+
+#define NATOMIC_RELAXED 0
+#define NATOMIC_ACQUIRE 1
+#define NATOMIC_RELEASE 2
+#define NATOMIC_ACQ_REL 3
+#define NATOMIC_SEQ_CST 4
+
+#define NATOMIC_PAUSE() cpu_relax()
+
+// Picks the _relaxed, _acquire or _release variant of a kernel atomic
+#define NATOMIC_ORDERED(order, op, ...)                               \
+	((order) == NATOMIC_RELAXED ? op##_relaxed(__VA_ARGS__) :     \
+	 (order) == NATOMIC_ACQUIRE ? op##_acquire(__VA_ARGS__) :     \
+	 (order) == NATOMIC_RELEASE ? op##_release(__VA_ARGS__) :     \
+				      op(__VA_ARGS__))
+
+static inline void natomic_fence(int order)
+{
+	if (order != NATOMIC_RELAXED)
+		smp_mb();
+}
+
+static inline uint32_t natomic32_load(natomic32_t *atomic, int order)
+{
+	if (order == NATOMIC_RELAXED)
+		return (uint32_t)atomic_read(atomic);
+
+	if (order == NATOMIC_SEQ_CST)
+		smp_mb();
+
+	return (uint32_t)atomic_read_acquire(atomic);
+}
+
+static inline void natomic32_store(natomic32_t *atomic, uint32_t value,
+				   int order)
+{
+	if (order == NATOMIC_RELAXED) {
+		atomic_set(atomic, (int)value);
+		return;
+	}
+
+	atomic_set_release(atomic, (int)value);
+	if (order == NATOMIC_SEQ_CST)
+		smp_mb();
+}
+
+static inline uint32_t natomic32_exchange(natomic32_t *atomic, uint32_t value,
+					  int order)
+{
+	return (uint32_t)NATOMIC_ORDERED(order, atomic_xchg, atomic,
+					 (int)value);
+}
+
+static inline bool natomic32_cas(natomic32_t *atomic, uint32_t *expected,
+				 uint32_t desired, int order)
+{
+	return NATOMIC_ORDERED(order, atomic_try_cmpxchg, atomic,
+			       (int *)expected, (int)desired);
+}
+
+static inline uint32_t natomic32_fetch_add(natomic32_t *atomic,
+					   uint32_t value, int order)
+{
+	return (uint32_t)NATOMIC_ORDERED(order, atomic_fetch_add, (int)value,
+					 atomic);
+}
+
+static inline uint64_t natomic64_load(natomic64_t *atomic, int order)
+{
+	if (order == NATOMIC_RELAXED)
+		return (uint64_t)atomic64_read(atomic);
+
+	if (order == NATOMIC_SEQ_CST)
+		smp_mb();
+
+	return (uint64_t)atomic64_read_acquire(atomic);
+}
+
+static inline void natomic64_store(natomic64_t *atomic, uint64_t value,
+				   int order)
+{
+	if (order == NATOMIC_RELAXED) {
+		atomic64_set(atomic, (s64)value);
+		return;
+	}
+
+	atomic64_set_release(atomic, (s64)value);
+	if (order == NATOMIC_SEQ_CST)
+		smp_mb();
+}
+
+static inline uint64_t natomic64_exchange(natomic64_t *atomic, uint64_t value,
+					  int order)
+{
+	return (uint64_t)NATOMIC_ORDERED(order, atomic64_xchg, atomic,
+					 (s64)value);
+}
+
+static inline bool natomic64_cas(natomic64_t *atomic, uint64_t *expected,
+				 uint64_t desired, int order)
+{
+	return NATOMIC_ORDERED(order, atomic64_try_cmpxchg, atomic,
+			       (s64 *)expected, (s64)desired);
+}
+
+static inline uint64_t natomic64_fetch_add(natomic64_t *atomic,
+					   uint64_t value, int order)
+{
+	return (uint64_t)NATOMIC_ORDERED(order, atomic64_fetch_add,
+					 (s64)value, atomic);
+}
+
+static inline void *natomic_ptr_load(natomic_ptr_t *atomic, int order)
+{
+	if (order == NATOMIC_RELAXED)
+		return READ_ONCE(*atomic);
+
+	if (order == NATOMIC_SEQ_CST)
+		smp_mb();
+
+	return smp_load_acquire(atomic);
+}
+
+static inline void natomic_ptr_store(natomic_ptr_t *atomic, void *value,
+				     int order)
+{
+	if (order == NATOMIC_RELAXED) {
+		WRITE_ONCE(*atomic, value);
+		return;
+	}
+
+	smp_store_release(atomic, value);
+	if (order == NATOMIC_SEQ_CST)
+		smp_mb();
+}
+
+static inline void *natomic_ptr_exchange(natomic_ptr_t *atomic, void *value,
+					 int order)
+{
+	return xchg(atomic, value);
+}
+
+static inline bool natomic_ptr_cas(natomic_ptr_t *atomic, void **expected,
+				   void *desired, int order)
+{
+	return try_cmpxchg(atomic, expected, desired);
+}
+
+#elif defined(_MSC_VER) // !MODULE
+
+typedef volatile LONG natomic32_t;
+typedef volatile LONG64 natomic64_t;
+typedef void *volatile natomic_ptr_t;
+
+#define NATOMIC32_INIT(value) (value)
+#define NATOMIC64_INIT(value) (value)
+#define NATOMIC_PTR_INIT(value) (value)
+
+#define NATOMIC_RELAXED 0
+#define NATOMIC_ACQUIRE 1
+#define NATOMIC_RELEASE 2
+#define NATOMIC_ACQ_REL 3
+#define NATOMIC_SEQ_CST 4
+
+#define NATOMIC_PAUSE() YieldProcessor()
+
+// x86 orders plain loads and stores, only the compiler needs holding back
+#if defined(_M_IX86) || defined(_M_X64)
+#define NATOMIC_BARRIER() _ReadWriteBarrier()
+#else // !_M_IX86 && !_M_X64
+#define NATOMIC_BARRIER() MemoryBarrier()
+#endif // !_M_IX86 && !_M_X64
+
+static inline void natomic_fence(int order)
+{
+	if (order == NATOMIC_SEQ_CST)
+		MemoryBarrier();
+	else if (order != NATOMIC_RELAXED)
+		NATOMIC_BARRIER();
+}
+
+static inline uint32_t natomic32_load(natomic32_t *atomic, int order)
+{
+	uint32_t value = (uint32_t)*atomic;
+	if (order != NATOMIC_RELAXED)
+		NATOMIC_BARRIER();
+
+	return value;
+}
+
+static inline void natomic32_store(natomic32_t *atomic, uint32_t value,
+				   int order)
+{
+	if (order == NATOMIC_SEQ_CST) {
+		InterlockedExchange(atomic, (LONG)value);
+		return;
+	}
+
+	if (order != NATOMIC_RELAXED)
+		NATOMIC_BARRIER();
+
+	*atomic = (LONG)value;
+}
+
+static inline uint32_t natomic32_exchange(natomic32_t *atomic, uint32_t value,
+					  int order)
+{
+	return (uint32_t)InterlockedExchange(atomic, (LONG)value);
+}
+
+static inline bool natomic32_cas(natomic32_t *atomic, uint32_t *expected,
+				 uint32_t desired, int order)
+{
+	LONG prev = InterlockedCompareExchange(atomic, (LONG)desired,
+					       (LONG)*expected);
+	if ((uint32_t)prev == *expected)
+		return true;
+
+	*expected = (uint32_t)prev;
+	return false;
+}
+
+static inline uint32_t natomic32_fetch_add(natomic32_t *atomic,
+					   uint32_t value, int order)
+{
+	return (uint32_t)InterlockedExchangeAdd(atomic, (LONG)value);
+}
+
+static inline uint64_t natomic64_load(natomic64_t *atomic, int order)
+{
+#ifdef _M_IX86
+	// Plain 64-bit loads may tear on 32-bit x86
+	return (uint64_t)InterlockedCompareExchange64(atomic, 0, 0);
+#else // !_M_IX86
+	uint64_t value = (uint64_t)*atomic;
+	if (order != NATOMIC_RELAXED)
+		NATOMIC_BARRIER();
+
+	return value;
+#endif // !_M_IX86
+}
+
+static inline void natomic64_store(natomic64_t *atomic, uint64_t value,
+				   int order)
+{
+#ifdef _M_IX86
+	InterlockedExchange64(atomic, (LONG64)value);
+#else // !_M_IX86
+	if (order == NATOMIC_SEQ_CST) {
+		InterlockedExchange64(atomic, (LONG64)value);
+		return;
+	}
+
+	if (order != NATOMIC_RELAXED)
+		NATOMIC_BARRIER();
+
+	*atomic = (LONG64)value;
+#endif // !_M_IX86
+}
+
+static inline uint64_t natomic64_exchange(natomic64_t *atomic, uint64_t value,
+					  int order)
+{
+	return (uint64_t)InterlockedExchange64(atomic, (LONG64)value);
+}
+
+static inline bool natomic64_cas(natomic64_t *atomic, uint64_t *expected,
+				 uint64_t desired, int order)
+{
+	LONG64 prev = InterlockedCompareExchange64(atomic, (LONG64)desired,
+						   (LONG64)*expected);
+	if ((uint64_t)prev == *expected)
+		return true;
+
+	*expected = (uint64_t)prev;
+	return false;
+}
+
+static inline uint64_t natomic64_fetch_add(natomic64_t *atomic,
+					   uint64_t value, int order)
+{
+	return (uint64_t)InterlockedExchangeAdd64(atomic, (LONG64)value);
+}
+
+static inline void *natomic_ptr_load(natomic_ptr_t *atomic, int order)
+{
+	void *value = *atomic;
+	if (order != NATOMIC_RELAXED)
+		NATOMIC_BARRIER();
+
+	return value;
+}
+
+static inline void natomic_ptr_store(natomic_ptr_t *atomic, void *value,
+				     int order)
+{
+	if (order == NATOMIC_SEQ_CST) {
+		InterlockedExchangePointer(atomic, value);
+		return;
+	}
+
+	if (order != NATOMIC_RELAXED)
+		NATOMIC_BARRIER();
+
+	*atomic = value;
+}
+
+static inline void *natomic_ptr_exchange(natomic_ptr_t *atomic, void *value,
+					 int order)
+{
+	return InterlockedExchangePointer(atomic, value);
+}
+
+static inline bool natomic_ptr_cas(natomic_ptr_t *atomic, void **expected,
+				   void *desired, int order)
+{
+	void *prev = InterlockedCompareExchangePointer(atomic, desired,
+						       *expected);
+	if (prev == *expected)
+		return true;
+
+	*expected = prev;
+	return false;
+}
+
+#else // !MODULE && !_MSC_VER
+
+#include <stdatomic.h>
+
+typedef _Atomic uint32_t natomic32_t;
+typedef _Atomic uint64_t natomic64_t;
+typedef _Atomic(void *) natomic_ptr_t;
+
+#define NATOMIC32_INIT(value) (value)
+#define NATOMIC64_INIT(value) (value)
+#define NATOMIC_PTR_INIT(value) (value)
+
+#define NATOMIC_RELAXED memory_order_relaxed
+#define NATOMIC_ACQUIRE memory_order_acquire
+#define NATOMIC_RELEASE memory_order_release
+#define NATOMIC_ACQ_REL memory_order_acq_rel
+#define NATOMIC_SEQ_CST memory_order_seq_cst
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NATOMIC_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define NATOMIC_PAUSE() __asm__ __volatile__("yield")
+#else // !__x86_64__ && !__i386__ && !__aarch64__ && !__arm__
+#define NATOMIC_PAUSE() atomic_signal_fence(memory_order_seq_cst)
+#endif // !__x86_64__ && !__i386__ && !__aarch64__ && !__arm__
+
+// The order a failed compare-and-swap may use, it performs no store
+static inline int natomic_failure_order(int order)
+{
+	if (order == NATOMIC_ACQ_REL)
+		return NATOMIC_ACQUIRE;
+
+	if (order == NATOMIC_RELEASE)
+		return NATOMIC_RELAXED;
+
+	return order;
+}
+
+static inline void natomic_fence(int order)
+{
+	atomic_thread_fence((memory_order)order);
+}
+
+static inline uint32_t natomic32_load(natomic32_t *atomic, int order)
+{
+	return atomic_load_explicit(atomic, (memory_order)order);
+}
+
+static inline void natomic32_store(natomic32_t *atomic, uint32_t value,
+				   int order)
+{
+	atomic_store_explicit(atomic, value, (memory_order)order);
+}
+
+static inline uint32_t natomic32_exchange(natomic32_t *atomic, uint32_t value,
+					  int order)
+{
+	return atomic_exchange_explicit(atomic, value, (memory_order)order);
+}
+
+static inline bool natomic32_cas(natomic32_t *atomic, uint32_t *expected,
+				 uint32_t desired, int order)
+{
+	return atomic_compare_exchange_strong_explicit(
+		atomic, expected, desired, (memory_order)order,
+		(memory_order)natomic_failure_order(order));
+}
+
+static inline uint32_t natomic32_fetch_add(natomic32_t *atomic,
+					   uint32_t value, int order)
+{
+	return atomic_fetch_add_explicit(atomic, value, (memory_order)order);
+}
+
+static inline uint64_t natomic64_load(natomic64_t *atomic, int order)
+{
+	return atomic_load_explicit(atomic, (memory_order)order);
+}
+
+static inline void natomic64_store(natomic64_t *atomic, uint64_t value,
+				   int order)
+{
+	atomic_store_explicit(atomic, value, (memory_order)order);
+}
+
+static inline uint64_t natomic64_exchange(natomic64_t *atomic, uint64_t value,
+					  int order)
+{
+	return atomic_exchange_explicit(atomic, value, (memory_order)order);
+}
+
+static inline bool natomic64_cas(natomic64_t *atomic, uint64_t *expected,
+				 uint64_t desired, int order)
+{
+	return atomic_compare_exchange_strong_explicit(
+		atomic, expected, desired, (memory_order)order,
+		(memory_order)natomic_failure_order(order));
+}
+
+static inline uint64_t natomic64_fetch_add(natomic64_t *atomic,
+					   uint64_t value, int order)
+{
+	return atomic_fetch_add_explicit(atomic, value, (memory_order)order);
+}
+
+static inline void *natomic_ptr_load(natomic_ptr_t *atomic, int order)
+{
+	return atomic_load_explicit(atomic, (memory_order)order);
+}
+
+static inline void natomic_ptr_store(natomic_ptr_t *atomic, void *value,
+				     int order)
+{
+	atomic_store_explicit(atomic, value, (memory_order)order);
+}
+
+static inline void *natomic_ptr_exchange(natomic_ptr_t *atomic, void *value,
+					 int order)
+{
+	return atomic_exchange_explicit(atomic, value, (memory_order)order);
+}
+
+static inline bool natomic_ptr_cas(natomic_ptr_t *atomic, void **expected,
+				   void *desired, int order)
+{
+	return atomic_compare_exchange_strong_explicit(
+		atomic, expected, desired, (memory_order)order,
+		(memory_order)natomic_failure_order(order));
+}
+
+#endif // !MODULE && !_MSC_VER
+#endif // !__NATOMIC_H__
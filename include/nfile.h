@@ -33,23 +33,32 @@
 	do {               \
 	} while (0)
 
-void nfile_close(nfile_t nfile);
-
 #define NFILE_CLOSE(nfile) nfile_close(nfile)
 
 #else // !MODULE
 
 #define NFILE_FLUSH(nfile) fflush(nfile)
+
+#ifdef NFILE_STAT_CACHE_SIZE
+#define NFILE_CLOSE(nfile) nfile_close(nfile)
+#else // !NFILE_STAT_CACHE_SIZE
 #define NFILE_CLOSE(nfile) fclose(nfile)
+#endif // !NFILE_STAT_CACHE_SIZE
 
 #endif // !MODULE
 
 #include "neptune.h"
+#include "nmem.h"
+#include "ntime.h"
 
 #ifndef NFILE_API
 #define NFILE_API NEPTUNE_API
 #endif // !NFILE_API
 
+#if defined(MODULE) || defined(NFILE_STAT_CACHE_SIZE)
+NFILE_API void nfile_close(nfile_t nfile);
+#endif // defined(MODULE) || defined(NFILE_STAT_CACHE_SIZE)
+
 #ifdef _WIN32
 #define NFILE_PATH_GET_LENGTH(nfile_path) ((size_t)wcslen(nfile_path))
 #else // !_WIN32
@@ -67,6 +76,18 @@ void nfile_close(nfile_t nfile);
 
 NFILE_API nfile_t nfile_open_r(const nfile_path_t pathname);
 
+/**
+ * @brief Read from an offset without using the stream position.
+ *
+ * Reads the OS handle directly (pread, ReadFile with an offset,
+ * kernel_read), so threads may read one handle concurrently.
+ *
+ * @param nfile Open file.
+ * @param offset File offset to read from.
+ * @param buffer Destination buffer.
+ * @param length Maximum number of bytes to read.
+ * @return Number of bytes read, 0 at the end of the file, -1 on error.
+ */
 NFILE_API ssize_t nfile_read_o(nfile_t nfile, ssize_t offset, void *buffer,
 			       ssize_t length);
 
@@ -79,6 +100,53 @@ NFILE_API ssize_t nfile_read(nfile_t nfile, void *buffer, ssize_t length);
 
 #define NFILE_READ(nfile, buffer, length) nfile_read(nfile, buffer, length)
 
+#ifndef NFILE_READ_ALL_MAP_SIZE
+#define NFILE_READ_ALL_MAP_SIZE (4 * 1024 * 1024)
+#endif // !NFILE_READ_ALL_MAP_SIZE
+
+#ifndef NFILE_READ_ALL_CHUNK_SIZE
+#define NFILE_READ_ALL_CHUNK_SIZE (64 * 1024)
+#endif // !NFILE_READ_ALL_CHUNK_SIZE
+
+// Whole-file contents returned by nfile_read_all
+struct nfile_data {
+	void *data; // File contents, not NUL-terminated
+	size_t size; // Number of valid bytes in data
+	bool mapped; // true if data is a read-only file mapping
+};
+
+typedef struct nfile_data nfile_data_t;
+
+/**
+ * @brief Load a whole file into memory.
+ *
+ * The size is taken from one stat call and the buffer is allocated once,
+ * then filled with large positional reads. Regular files of at least
+ * `NFILE_READ_ALL_MAP_SIZE` bytes are mapped instead of copied (user mode,
+ * non-Windows; define it to 0 to disable). Files that report no size, such
+ * as pipes and procfs entries, are read in `NFILE_READ_ALL_CHUNK_SIZE`
+ * steps with geometric buffer growth.
+ *
+ * @param path Path of the file to load.
+ * @param allocator Allocator for the buffer, NULL for N_ALLOC.
+ * @param out Receives the contents.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_read_all(const nfile_path_t path,
+				  const nmem_allocator_t *allocator,
+				  nfile_data_t *out);
+
+/**
+ * @brief Release contents returned by nfile_read_all.
+ * @param data Contents to release.
+ * @param allocator Allocator that was passed to nfile_read_all.
+ */
+NFILE_API void nfile_data_release(nfile_data_t *data,
+				  const nmem_allocator_t *allocator);
+
+#define NFILE_READ_ALL(path, allocator, out) \
+	nfile_read_all(path, allocator, out)
+
 #endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
 
 #if !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
@@ -102,8 +170,32 @@ NFILE_API ssize_t nfile_printf_v(nfile_t nfile, const char *format,
 
 NFILE_API ssize_t nfile_printf(nfile_t nfile, const char *format, ...);
 
+/**
+ * @brief Open a file for appending, creating it if needed.
+ * @param pathname Path of the file.
+ * @return Opened file or NULL.
+ */
+NFILE_API nfile_t nfile_open_a(const nfile_path_t pathname);
+
+/**
+ * @brief Write buffered data through to stable storage.
+ *
+ * Flushes the stream, then calls fdatasync (data_only) or fsync;
+ * FlushFileBuffers on Windows and vfs_fsync in kernel mode. Unlike
+ * NFILE_FLUSH this survives a power loss.
+ *
+ * @param nfile Open file.
+ * @param data_only true to skip metadata not needed to read the data back.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_sync(nfile_t nfile, bool data_only);
+
 #define NFILE_OPEN_W(pathname) nfile_open_w(pathname)
 
+#define NFILE_OPEN_A(pathname) nfile_open_a(pathname)
+
+#define NFILE_SYNC(nfile, data_only) nfile_sync(nfile, data_only)
+
 #define NFILE_WRITE_O(nfile, buffer, length, offset) \
 	nfile_write_o(nfile, buffer, length, offset)
 
@@ -120,6 +212,26 @@ NFILE_API ssize_t nfile_printf(nfile_t nfile, const char *format, ...);
 #define NFILE_PRINTF(nfile, format, ...) \
 	nfile_printf_v(nfile, format, ##__VA_ARGS__)
 
+/**
+ * @brief Reserve disk space for a range of a file.
+ *
+ * Uses fallocate (vfs_fallocate in kernel mode), so a writer that appends
+ * into the reserved range gets contiguous extents and avoids a metadata
+ * update on every append. On Windows the allocation size is raised, never
+ * lowered, so existing data is not truncated.
+ *
+ * @param nfile Open file.
+ * @param offset Start of the range.
+ * @param length Length of the range.
+ * @param keep_size true to leave the visible file size unchanged.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_prealloc(nfile_t nfile, ssize_t offset,
+				  ssize_t length, bool keep_size);
+
+#define NFILE_PREALLOC(nfile, offset, length, keep_size) \
+	nfile_prealloc(nfile, offset, length, keep_size)
+
 #endif // !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
 
 #if !defined(NFILE_DISABLE_RDWR) || NFILE_DISABLE_RDWR != 1
@@ -128,8 +240,102 @@ NFILE_API nfile_t nfile_open_rw(const nfile_path_t pathname);
 
 NFILE_API nfile_t nfile_open_wr(const nfile_path_t pathname);
 
+#ifndef NFILE_COPY_CHUNK_SIZE
+#define NFILE_COPY_CHUNK_SIZE (64 * 1024)
+#endif // !NFILE_COPY_CHUNK_SIZE
+
+/**
+ * @brief Copy a byte range between two files without a user-space copy.
+ *
+ * Uses copy_file_range in user mode (vfs_copy_file_range in kernel mode),
+ * which lets reflink-capable filesystems share extents instead of copying.
+ * Falls back to positional read/write through a `NFILE_COPY_CHUNK_SIZE`
+ * buffer when the zero-copy path is not available. Stream positions of
+ * both files are left unchanged.
+ *
+ * @param in Source file.
+ * @param in_offset Offset in the source file.
+ * @param out Destination file.
+ * @param out_offset Offset in the destination file.
+ * @param length Number of bytes to copy.
+ * @return Number of bytes copied, short on end of file or on an error after
+ * some bytes were copied, -1 if an error occurred before any byte was.
+ */
+NFILE_API ssize_t nfile_copy_range(nfile_t in, ssize_t in_offset, nfile_t out,
+				   ssize_t out_offset, size_t length);
+
+/**
+ * @brief Send a byte range of a file to a connected socket.
+ *
+ * Uses sendfile in user mode with a read/send fallback. In kernel mode
+ * the data is read into a bounce buffer and passed to kernel_sendmsg.
+ *
+ * @param in Source file.
+ * @param offset Offset in the source file.
+ * @param sock Destination socket.
+ * @param length Number of bytes to send.
+ * @return Number of bytes sent, short on end of file or on an error after
+ * some bytes were sent, -1 if an error occurred before any byte was.
+ */
+NFILE_API ssize_t nfile_send(nfile_t in, ssize_t offset, nfile_sock_t sock,
+			     size_t length);
+
+#define NFILE_COPY_RANGE(in, in_offset, out, out_offset, length) \
+	nfile_copy_range(in, in_offset, out, out_offset, length)
+
+#define NFILE_SEND(in, offset, sock, length) \
+	nfile_send(in, offset, sock, length)
+
 #endif // !defined(NFILE_DISABLE_RDWR) || NFILE_DISABLE_RDWR != 1
 
+/**
+ * @brief Get the OS-level handle behind an nfile.
+ *
+ * Pending buffered output is flushed first so the handle sees every byte
+ * written through the stream. Returns a descriptor on POSIX, a HANDLE on
+ * Windows and the `struct file` itself in kernel mode.
+ *
+ * @param nfile Open file.
+ * @return OS-level handle.
+ */
+NFILE_API nfile_handle_t nfile_get_handle(nfile_t nfile);
+
+/**
+ * @brief Tell the OS how a range of a file is going to be accessed.
+ *
+ * Maps to posix_fadvise in user mode and vfs_fadvise in kernel mode. A
+ * scanner can drop pages it has consumed with `NFILE_ADVICE_DONTNEED`
+ * (only clean pages are dropped). Windows has no per-handle equivalent,
+ * so the call succeeds without effect there.
+ *
+ * @param nfile Open file.
+ * @param offset Start of the range.
+ * @param length Length of the range, 0 for up to end of file.
+ * @param advice One of the NFILE_ADVICE_* values.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_advise(nfile_t nfile, ssize_t offset, ssize_t length,
+				nfile_advice_t advice);
+
+/**
+ * @brief Start reading a range of a file into the page cache.
+ *
+ * Does not wait for the I/O to finish.
+ *
+ * @param nfile Open file.
+ * @param offset Start of the range.
+ * @param length Length of the range.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_readahead(nfile_t nfile, ssize_t offset,
+				   ssize_t length);
+
+#define NFILE_ADVISE(nfile, offset, length, advice) \
+	nfile_advise(nfile, offset, length, advice)
+
+#define NFILE_READAHEAD(nfile, offset, length) \
+	nfile_readahead(nfile, offset, length)
+
 NFILE_API void nfile_delete(const nfile_path_t path);
 
 #define NFILE_DELETE(nfile) nfile_delete(nfile)
@@ -138,5 +344,70 @@ NFILE_API ssize_t nfile_get_length(nfile_t nfile);
 
 #define NFILE_GET_LENGTH(nfile) nfile_get_length(nfile)
 
+// File metadata returned by nfile_stat
+struct nfile_stat {
+	uint64_t size; // File size in bytes
+	uint64_t inode; // Inode (or file index on Windows)
+	uint32_t block_size; // Preferred I/O block size
+	uint32_t mtime_nsec; // Nanosecond part of the modification time
+	ntime_t mtime; // Modification time as a Unix timestamp
+};
+
+typedef struct nfile_stat nfile_stat_t;
+
+/**
+ * @brief Query size, block size, modification time and inode of a file.
+ *
+ * Uses a single fstat (GetFileInformationByHandle on Windows, vfs_getattr
+ * in kernel mode). When `NFILE_STAT_CACHE_SIZE` is defined the result is
+ * cached per handle until the handle is written through nfile or closed.
+ *
+ * @param nfile Open file.
+ * @param stat Output metadata.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_stat(nfile_t nfile, nfile_stat_t *stat);
+
+/**
+ * @brief Query the metadata of a file by path, without opening a stream.
+ * @param path Path of the file; symbolic links are followed.
+ * @param stat Output metadata.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_stat_path(const nfile_path_t path, nfile_stat_t *stat);
+
+#define NFILE_STAT(nfile, stat) nfile_stat(nfile, stat)
+
+#define NFILE_STAT_PATH(path, stat) nfile_stat_path(path, stat)
+
+#ifdef NFILE_STAT_CACHE_SIZE
+
+/**
+ * @brief Drop the cached metadata of a handle.
+ * @param nfile File whose cache entry should be removed.
+ */
+NFILE_API void nfile_stat_invalidate(nfile_t nfile);
+
+/**
+ * @brief Initialize the nfile metadata cache.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_init(void);
+
+/**
+ * @brief Release the nfile metadata cache.
+ */
+NFILE_API void nfile_destroy(void);
+
+#define NFILE_STAT_INVALIDATE(nfile) nfile_stat_invalidate(nfile)
+
+#else // !NFILE_STAT_CACHE_SIZE
+
+#define NFILE_STAT_INVALIDATE(nfile) \
+	do {                         \
+	} while (0)
+
+#endif // !NFILE_STAT_CACHE_SIZE
+
 #endif // !defined(NFILE_DISABLE) || NFILE_DISABLE != 1
 #endif // !__NFILE_H__
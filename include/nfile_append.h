@@ -0,0 +1,95 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nfile_append.h
+ * @brief Neptune library - Durable append-only writer.
+ *
+ * An appender serializes records onto the end of a file. Records written
+ * with `durable` set are on stable storage when `nfile_append` returns.
+ * Concurrent durable appends are group-committed: the first waiter syncs
+ * everything written so far and every appender whose record was covered
+ * by that sync returns without issuing its own fdatasync.
+ */
+
+#ifndef __NFILE_APPEND_H__
+#define __NFILE_APPEND_H__
+
+#include "nfile.h"
+
+#if !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
+
+#include "nmutex.h"
+
+// Append-only writer state
+struct nfile_appender {
+	nfile_t file; // Underlying file, opened in append mode
+	uint64_t size; // End offset of the last record, guarded by write_mutex
+	uint64_t synced; // End offset known to be durable, guarded by sync_mutex
+	NMUTEX write_mutex; // Serializes record writes
+	NMUTEX sync_mutex; // Elects the group commit leader
+};
+
+typedef struct nfile_appender nfile_appender_t;
+
+/**
+ * @brief Open (or create) a file for durable appending.
+ * @param appender Appender to initialize.
+ * @param path Path of the file.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_appender_open(nfile_appender_t *appender,
+				       const nfile_path_t path);
+
+/**
+ * @brief Sync outstanding records and close the file.
+ * @param appender Appender to close.
+ */
+NFILE_API void nfile_appender_close(nfile_appender_t *appender);
+
+/**
+ * @brief Append a record to the file.
+ * @param appender Open appender.
+ * @param buffer Record data.
+ * @param length Record length in bytes.
+ * @param durable true to return only once the record is on stable storage.
+ *                Non-durable records become durable with the next durable
+ *                append, nfile_appender_sync or nfile_appender_close.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_append(nfile_appender_t *appender, const void *buffer,
+				size_t length, bool durable);
+
+/**
+ * @brief Make every record appended so far durable.
+ * @param appender Open appender.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_appender_sync(nfile_appender_t *appender);
+
+#define NFILE_APPEND(appender, buffer, length, durable) \
+	nfile_append(appender, buffer, length, durable)
+
+#endif // !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
+#endif // !__NFILE_APPEND_H__
@@ -0,0 +1,117 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nfile_cache.h
+ * @brief Neptune library - Bounded cache of open read-only file handles.
+ *
+ * Keeps files that are reopened over and over open between uses. Entries
+ * are keyed by path, reference counted and evicted least recently used
+ * first once the cache holds more than its capacity. On every acquire the
+ * path is stat'ed and compared with the inode, size and modification time
+ * recorded at open; a replaced or modified file gets a fresh handle.
+ *
+ * A cached handle is shared by every thread that acquires it. Concurrent
+ * reads are only safe through `nfile_read_o`, which reads the OS handle at
+ * an offset on every platform (pread, ReadFile with an OVERLAPPED offset)
+ * and never touches the stream. Stream reads, seeks and writes on a shared
+ * handle race with the other holders.
+ */
+
+#ifndef __NFILE_CACHE_H__
+#define __NFILE_CACHE_H__
+
+#include "nfile.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#include "nmutex.h"
+
+// A cached handle, treat everything but file as private
+struct nfile_cache_entry {
+	nfile_t file; // Open file, read it with nfile_read_o only
+	nfile_stat_t stat; // Identity of the file when it was opened
+
+	size_t refs; // Acquired references
+	bool linked; // Still reachable through the cache
+	uint32_t hash; // Hash of path
+	size_t size; // Size of path in bytes, including the terminator
+
+	struct nfile_cache_entry *hash_next; // Bucket chain
+	struct nfile_cache_entry *lru_prev; // More recently used neighbor
+	struct nfile_cache_entry *lru_next; // Less recently used neighbor
+
+	nfile_char_t path[]; // Owned copy of the key
+};
+
+typedef struct nfile_cache_entry nfile_cache_entry_t;
+
+struct nfile_cache {
+	nfile_cache_entry_t **buckets; // Hash table of linked entries
+	size_t bucket_count; // Power of two
+	nfile_cache_entry_t *lru_head; // Most recently used entry
+	nfile_cache_entry_t *lru_tail; // Least recently used entry
+	size_t count; // Linked entries
+	size_t capacity; // Entries kept open when unused
+	NMUTEX mutex;
+};
+
+typedef struct nfile_cache nfile_cache_t;
+
+/**
+ * @brief Initialize a handle cache.
+ * @param cache Cache to initialize.
+ * @param capacity Maximum number of handles kept open.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_cache_init(nfile_cache_t *cache, size_t capacity);
+
+/**
+ * @brief Close every cached handle and free the cache.
+ *
+ * All entries must have been released.
+ *
+ * @param cache Cache to destroy.
+ */
+NFILE_API void nfile_cache_destroy(nfile_cache_t *cache);
+
+/**
+ * @brief Get an open handle for a path, opening it on a miss.
+ * @param cache Cache.
+ * @param path Path of the file.
+ * @return Entry holding the handle, or NULL if the file cannot be opened.
+ */
+NFILE_API nfile_cache_entry_t *nfile_cache_acquire(nfile_cache_t *cache,
+						   const nfile_path_t path);
+
+/**
+ * @brief Drop a reference taken by nfile_cache_acquire.
+ * @param cache Cache.
+ * @param entry Entry to release.
+ */
+NFILE_API void nfile_cache_release(nfile_cache_t *cache,
+				   nfile_cache_entry_t *entry);
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+#endif // !__NFILE_CACHE_H__
@@ -0,0 +1,101 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nfile_chunk.h
+ * @brief Neptune library - Parallel chunked file processing.
+ *
+ * Splits a file into ranges that start right after a delimiter, so no
+ * record is cut in half, and processes the ranges on worker threads. Each
+ * worker gets its own view of its range: a private mapping on POSIX user
+ * mode for chunks of at least `NFILE_CHUNK_MAP_SIZE` bytes, or a buffer
+ * filled with nfile_read_o, which is positional on every platform, so no
+ * stream position is shared between workers. Per-chunk results are handed
+ * to the merge callback in file order once every chunk is done.
+ *
+ * Kernel mode processes the chunks one after another on the caller.
+ */
+
+#ifndef __NFILE_CHUNK_H__
+#define __NFILE_CHUNK_H__
+
+#include "nfile.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#ifndef NFILE_CHUNK_PER_THREAD
+#define NFILE_CHUNK_PER_THREAD 4
+#endif // !NFILE_CHUNK_PER_THREAD
+
+#ifndef NFILE_CHUNK_MAX_THREADS
+#define NFILE_CHUNK_MAX_THREADS 256
+#endif // !NFILE_CHUNK_MAX_THREADS
+
+// Smaller chunks are copied, a mapping costs more than reading them
+#ifndef NFILE_CHUNK_MAP_SIZE
+#define NFILE_CHUNK_MAP_SIZE (256 * 1024)
+#endif // !NFILE_CHUNK_MAP_SIZE
+
+/**
+ * @brief Process one chunk; runs on a worker thread.
+ * @param ctx User context.
+ * @param data Chunk contents, valid only during the call.
+ * @param length Chunk length; may be 0 for tiny files.
+ * @param index Chunk index in file order.
+ * @return Per-chunk result passed to the merge callback.
+ */
+typedef void *(*nfile_chunk_fn)(void *ctx, const char *data, size_t length,
+				size_t index);
+
+/**
+ * @brief Merge one chunk result; runs on the caller in file order.
+ * @param ctx User context.
+ * @param result Value returned by the chunk callback.
+ * @param index Chunk index in file order.
+ */
+typedef void (*nfile_chunk_merge_fn)(void *ctx, void *result, size_t index);
+
+/**
+ * @brief Process a file in parallel, split on record boundaries.
+ *
+ * The file is cut into `thread_count * NFILE_CHUNK_PER_THREAD` ranges which
+ * the workers pick up as they become free. If a chunk cannot be read the
+ * remaining chunks are skipped, merge still runs for every chunk (with NULL
+ * for skipped ones) so results can be released, and an error is returned.
+ *
+ * @param path Path of the file.
+ * @param thread_count Number of worker threads, at most NFILE_CHUNK_MAX_THREADS.
+ * @param delim Record delimiter.
+ * @param process Chunk callback.
+ * @param merge Merge callback, may be NULL.
+ * @param ctx User context for both callbacks.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_chunk_process(const nfile_path_t path,
+				       size_t thread_count, char delim,
+				       nfile_chunk_fn process,
+				       nfile_chunk_merge_fn merge, void *ctx);
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+#endif // !__NFILE_CHUNK_H__
@@ -33,15 +33,30 @@
 #define NFILE_MAX_PRINTF_LENGTH 256
 #define NFILE_MAX_PATH_LENGTH 256
 
+struct socket;
+
 typedef struct file *nfile_t;
+typedef struct file *nfile_handle_t;
+typedef struct socket *nfile_sock_t;
 
 #else // !MODULE
 
+#include <stdint.h>
 #include <stdio.h>
 #include <wchar.h>
 
 typedef FILE *nfile_t;
 
+#ifdef _WIN32
+#include <windows.h>
+
+typedef HANDLE nfile_handle_t;
+typedef SOCKET nfile_sock_t;
+#else // !_WIN32
+typedef int nfile_handle_t;
+typedef int nfile_sock_t;
+#endif // !_WIN32
+
 #endif // !MODULE
 
 #ifdef _WIN32
@@ -57,6 +72,28 @@ typedef char nfile_char_t;
 
 typedef nfile_char_t *nfile_path_t;
 
+// Access pattern hints for nfile_advise
+typedef int8_t nfile_advice_t;
+
+#define NFILE_ADVICE_NORMAL 0x00
+#define NFILE_ADVICE_SEQUENTIAL 0x01
+#define NFILE_ADVICE_RANDOM 0x02
+#define NFILE_ADVICE_WILLNEED 0x03
+#define NFILE_ADVICE_DONTNEED 0x04
+
+#define NFILE_ERROR_S 0x6200
+
+#define NFILE_STAT_ERROR 0x6201
+#define NFILE_OPEN_ERROR 0x6202
+#define NFILE_READ_ERROR 0x6203
+#define NFILE_ALLOC_ERROR 0x6204
+#define NFILE_WRITE_ERROR 0x6205
+#define NFILE_ADVISE_ERROR 0x6206
+#define NFILE_PREALLOC_ERROR 0x6207
+#define NFILE_SYNC_ERROR 0x6208
+
+#define NFILE_ERROR_E NFILE_SYNC_ERROR
+
 #if defined(NFILE_DISABLE_READ) && defined(NFILE_DISABLE_WRITE)
 #if NFILE_DISABLE_READ == 1 && NFILE_DISABLE_WRITE == 1
 
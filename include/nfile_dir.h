@@ -0,0 +1,120 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nfile_dir.h
+ * @brief Neptune library - Batched and parallel directory traversal.
+ *
+ * Directories are read in large batches straight from the kernel
+ * (`getdents64` on Linux user mode, `iterate_dir` in kernel mode and
+ * large-fetch `FindFirstFileExW` on Windows) and every entry carries the
+ * file type the filesystem stored with it, so walking a tree needs no stat
+ * call for most entries. Only entries whose type the filesystem does not
+ * record are stat'ed, and only in user mode.
+ *
+ * `nfile_dir_walk` fans subdirectories out to a pool of worker threads so
+ * many directories are being read at once. Kernel mode walks on the caller.
+ */
+
+#ifndef __NFILE_DIR_H__
+#define __NFILE_DIR_H__
+
+#include "nfile.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#ifndef NFILE_DIR_BUFFER_SIZE
+#define NFILE_DIR_BUFFER_SIZE (64 * 1024)
+#endif // !NFILE_DIR_BUFFER_SIZE
+
+#ifndef NFILE_DIR_MAX_THREADS
+#define NFILE_DIR_MAX_THREADS 256
+#endif // !NFILE_DIR_MAX_THREADS
+
+typedef uint8_t nfile_dir_type_t;
+
+#define NFILE_DIR_TYPE_UNKNOWN 0x00
+#define NFILE_DIR_TYPE_FILE 0x01
+#define NFILE_DIR_TYPE_DIR 0x02
+#define NFILE_DIR_TYPE_LINK 0x03
+#define NFILE_DIR_TYPE_OTHER 0x04
+
+struct nfile_dir_entry {
+	const nfile_char_t *name; // Null terminated, valid during the callback
+	size_t name_length; // Characters in name
+	uint64_t inode; // 0 where the platform does not report it
+	nfile_dir_type_t type;
+};
+
+typedef struct nfile_dir_entry nfile_dir_entry_t;
+
+/**
+ * @brief Visit one directory entry; "." and ".." are never passed.
+ *
+ * For nfile_dir_read returning false stops the listing. For nfile_dir_walk
+ * returning false on a directory skips its subtree, and the return value is
+ * ignored for other entries.
+ *
+ * @param ctx User context.
+ * @param dir Path of the directory holding the entry.
+ * @param entry Entry.
+ * @return Whether to continue.
+ */
+typedef bool (*nfile_dir_fn)(void *ctx, const nfile_char_t *dir,
+			     const nfile_dir_entry_t *entry);
+
+/**
+ * @brief List the entries of one directory.
+ *
+ * In kernel mode the callback runs with the directory locked and must not
+ * modify it.
+ *
+ * @param path Path of the directory.
+ * @param fn Entry callback.
+ * @param ctx User context.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_dir_read(const nfile_path_t path, nfile_dir_fn fn,
+				  void *ctx);
+
+/**
+ * @brief Walk a directory tree with a pool of worker threads.
+ *
+ * The callback is called concurrently from every worker, in no particular
+ * order. Symbolic links are reported but never followed. A subdirectory
+ * that cannot be read does not stop the walk, the rest of the tree is still
+ * visited and an error is returned at the end.
+ *
+ * @param path Path of the root directory, not passed to the callback.
+ * @param thread_count Number of workers, at most NFILE_DIR_MAX_THREADS.
+ * @param fn Entry callback.
+ * @param ctx User context.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_dir_walk(const nfile_path_t path,
+				  size_t thread_count, nfile_dir_fn fn,
+				  void *ctx);
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+#endif // !__NFILE_DIR_H__
@@ -0,0 +1,152 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nfile_line.h
+ * @brief Neptune library - Zero-copy line and record iterator.
+ *
+ * Splits a memory block, a whole loaded file or a file read through a large
+ * buffer into records separated by a delimiter byte. Records are returned
+ * as slices pointing into the iterator's storage; nothing is copied or
+ * NUL-terminated. The delimiter search uses SSE2/AVX2 on x86 (AVX2 is
+ * picked at run time) and falls back to a scalar scan elsewhere and in
+ * kernel mode. Define `NFILE_LINE_DISABLE_SIMD` to force the scalar path.
+ */
+
+#ifndef __NFILE_LINE_H__
+#define __NFILE_LINE_H__
+
+#include "nfile.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#ifndef NFILE_LINE_BUFFER_SIZE
+#define NFILE_LINE_BUFFER_SIZE (1024 * 1024)
+#endif // !NFILE_LINE_BUFFER_SIZE
+
+// A record inside the iterator's storage, without its delimiter
+struct nfile_slice {
+	const char *data; // First byte of the record
+	size_t length; // Record length in bytes
+};
+
+typedef struct nfile_slice nfile_slice_t;
+
+// Iterator state, treat as opaque
+struct nfile_line_iter {
+	const char *cur; // Start of the next record
+	const char *scan; // Where the delimiter search resumes
+	const char *end; // End of valid data
+	char delim; // Record delimiter
+
+	nfile_t file; // Source for buffered mode, NULL otherwise
+	char *buffer; // Read buffer for buffered mode
+	size_t capacity; // Size of buffer
+	uint64_t offset; // Next file offset to read in buffered mode
+	bool eof; // No more data to read
+	nerror_t error; // Read or allocation failure in buffered mode
+
+	nfile_data_t data; // Owned contents for nfile_line_iter_open
+};
+
+typedef struct nfile_line_iter nfile_line_iter_t;
+
+/**
+ * @brief Find the first occurrence of a byte in a memory range.
+ * @param data Start of the range.
+ * @param length Length of the range.
+ * @param delim Byte to search for.
+ * @return Pointer to the byte or NULL.
+ */
+NFILE_API const char *nfile_line_find(const char *data, size_t length,
+				      char delim);
+
+/**
+ * @brief Iterate records of a memory block.
+ * @param iter Iterator to initialize.
+ * @param data Memory block; must outlive the iterator.
+ * @param length Length of the block.
+ * @param delim Record delimiter, usually '\n'.
+ */
+NFILE_API void nfile_line_iter_init(nfile_line_iter_t *iter, const void *data,
+				    size_t length, char delim);
+
+/**
+ * @brief Load a file with nfile_read_all (mapped when large) and iterate it.
+ * @param iter Iterator to initialize.
+ * @param path Path of the file.
+ * @param delim Record delimiter.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_line_iter_open(nfile_line_iter_t *iter,
+					const nfile_path_t path, char delim);
+
+/**
+ * @brief Iterate records of an open file through a read buffer.
+ *
+ * The file is read with nfile_read_o from offset 0, which is positional on
+ * every platform, so the stream position is neither used nor moved. A
+ * failed read stops the iterator with NFILE_READ_ERROR instead of looking
+ * like the end, see nfile_line_iter_error. Slices stay valid until the next
+ * call to nfile_line_next. The buffer grows when a record does not fit.
+ *
+ * @param iter Iterator to initialize.
+ * @param file Open file.
+ * @param buffer_size Initial buffer size, 0 for NFILE_LINE_BUFFER_SIZE.
+ * @param delim Record delimiter.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_line_iter_init_file(nfile_line_iter_t *iter,
+					     nfile_t file, size_t buffer_size,
+					     char delim);
+
+/**
+ * @brief Get the next record.
+ *
+ * A final record without a trailing delimiter is returned as well. When a
+ * read or buffer growth fails the partial record is dropped and false is
+ * returned; use nfile_line_iter_error to tell that apart from the end.
+ *
+ * @param iter Iterator.
+ * @param line Receives the record.
+ * @return true if a record was returned, false at the end or on error.
+ */
+NFILE_API bool nfile_line_next(nfile_line_iter_t *iter, nfile_slice_t *line);
+
+/**
+ * @brief Get the error that stopped the iterator.
+ * @param iter Iterator.
+ * @return N_OK at a clean end, NFILE_READ_ERROR or NFILE_ALLOC_ERROR
+ * otherwise.
+ */
+NFILE_API nerror_t nfile_line_iter_error(const nfile_line_iter_t *iter);
+
+/**
+ * @brief Release buffers owned by the iterator.
+ * @param iter Iterator.
+ */
+NFILE_API void nfile_line_iter_release(nfile_line_iter_t *iter);
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+#endif // !__NFILE_LINE_H__
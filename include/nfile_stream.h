@@ -0,0 +1,109 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nfile_stream.h
+ * @brief Neptune library - Streaming writer with bounded dirty memory.
+ *
+ * Writing a large file through the page cache lets the kernel accumulate
+ * dirty pages until it has to write them all back at once, stalling every
+ * writer on the host. A stream writer starts writeback on each full window
+ * behind the write head as soon as it fills, and once more than the dirty
+ * bound is outstanding waits for the oldest window and drops it from the
+ * page cache. Outstanding dirty data stays around `dirty_limit` bytes and
+ * the output does not push other files out of the cache.
+ *
+ * Uses `sync_file_range` on Linux user mode and the mapping writeback
+ * helpers in kernel mode. Windows has no ranged writeback, the bound is
+ * kept by flushing the file each time it is exceeded.
+ *
+ * Writeback is not a durability guarantee; use `nfile_sync` for that. A
+ * stream is not thread safe.
+ */
+
+#ifndef __NFILE_STREAM_H__
+#define __NFILE_STREAM_H__
+
+#include "nfile.h"
+
+#if !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
+
+#ifndef NFILE_STREAM_WINDOW_SIZE
+#define NFILE_STREAM_WINDOW_SIZE (8 * 1024 * 1024)
+#endif // !NFILE_STREAM_WINDOW_SIZE
+
+#ifndef NFILE_STREAM_DIRTY_LIMIT
+#define NFILE_STREAM_DIRTY_LIMIT (64 * 1024 * 1024)
+#endif // !NFILE_STREAM_DIRTY_LIMIT
+
+// Streaming writer state, offsets only move forward
+struct nfile_stream {
+	nfile_t file;
+	uint64_t offset; // Write head
+	uint64_t started; // Writeback has been started up to here
+	uint64_t dropped; // Written back and dropped from the cache up to here
+	uint64_t window; // Writeback granularity in bytes
+	uint64_t dirty_limit; // Bound on offset - dropped, at least one window
+};
+
+typedef struct nfile_stream nfile_stream_t;
+
+/**
+ * @brief Create (or truncate) a file for streaming writes.
+ * @param stream Stream to initialize.
+ * @param path Path of the file.
+ * @param window Writeback window, 0 for NFILE_STREAM_WINDOW_SIZE.
+ * @param dirty_limit Dirty memory bound, 0 for NFILE_STREAM_DIRTY_LIMIT.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_stream_open(nfile_stream_t *stream,
+				     const nfile_path_t path, size_t window,
+				     size_t dirty_limit);
+
+/**
+ * @brief Write at the head of the stream.
+ *
+ * Blocks on writeback of old windows only while more than the dirty bound
+ * is outstanding.
+ *
+ * @param stream Open stream.
+ * @param buffer Data to write.
+ * @param length Length in bytes.
+ * @return Error code.
+ */
+NFILE_API nerror_t nfile_stream_write(nfile_stream_t *stream,
+				      const void *buffer, size_t length);
+
+/**
+ * @brief Write back and drop everything written, then close the file.
+ * @param stream Stream to close.
+ * @return Error code of the final writeback.
+ */
+NFILE_API nerror_t nfile_stream_close(nfile_stream_t *stream);
+
+#define NFILE_STREAM_WRITE(stream, buffer, length) \
+	nfile_stream_write(stream, buffer, length)
+
+#endif // !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
+#endif // !__NFILE_STREAM_H__
@@ -33,7 +33,11 @@
  * - `N_FREE(addr)` for `free`
  *
  * These macros provide a consistent interface for dynamic memory operations
- * throughout the Neptune project.
+ * throughout the Neptune project. Defining `NMEM_USE_TCACHE` routes them to
+ * the thread-caching allocator in nmem_tcache.h, and defining `NMEM_TRACE`
+ * records each call in nmem_trace.h on top of it (both user mode only).
+ * APIs that return memory to the caller take an optional `nmem_allocator_t`
+ * so callers can supply their own allocator.
  */
 
 #ifndef __NMEM_H__
@@ -41,21 +45,158 @@
 
 #include "neptune.h"
 
+// NMEM_RAW_* always reach the platform allocator, N_* may be routed elsewhere
 #ifdef MODULE
 
 NEPTUNE_API void *nmem_alloc(size_t size);
 
 NEPTUNE_API void *nmem_realloc(void *ptr, size_t size);
 
-#define N_ALLOC(size) nmem_alloc(size)
-#define N_REALLOC(addr, new_size) nmem_realloc(addr, new_size)
-#define N_FREE(addr) kfree(addr)
+#define NMEM_RAW_ALLOC(size) nmem_alloc(size)
+#define NMEM_RAW_REALLOC(addr, new_size) nmem_realloc(addr, new_size)
+#define NMEM_RAW_FREE(addr) kfree(addr)
 
 #else // MODULE
 
-#define N_ALLOC(size) malloc(size)
-#define N_REALLOC(addr, new_size) realloc(addr, new_size)
-#define N_FREE(addr) free(addr)
+#define NMEM_RAW_ALLOC(size) malloc(size)
+#define NMEM_RAW_REALLOC(addr, new_size) realloc(addr, new_size)
+#define NMEM_RAW_FREE(addr) free(addr)
 
 #endif // MODULE
+
+// Define NMEM_USE_TCACHE to serve N_* from the thread-caching allocator
+#if defined(NMEM_USE_TCACHE) && !defined(MODULE)
+
+#include "nmem_tcache.h"
+
+#define NMEM_BASE_ALLOC(size) nmem_tcache_alloc(size)
+#define NMEM_BASE_REALLOC(addr, new_size) nmem_tcache_realloc(addr, new_size)
+#define NMEM_BASE_FREE(addr) nmem_tcache_free(addr)
+
+#else // !NMEM_USE_TCACHE || MODULE
+
+#define NMEM_BASE_ALLOC(size) NMEM_RAW_ALLOC(size)
+#define NMEM_BASE_REALLOC(addr, new_size) NMEM_RAW_REALLOC(addr, new_size)
+#define NMEM_BASE_FREE(addr) NMEM_RAW_FREE(addr)
+
+#endif // !NMEM_USE_TCACHE || MODULE
+
+// Define NMEM_TRACE to record every N_* call against its call site
+#if defined(NMEM_TRACE) && !defined(MODULE)
+
+#include "nmem_trace.h"
+
+#define N_ALLOC(size) nmem_trace_alloc(size, __FILE__, __LINE__)
+#define N_REALLOC(addr, new_size) \
+	nmem_trace_realloc(addr, new_size, __FILE__, __LINE__)
+#define N_FREE(addr) nmem_trace_free(addr)
+
+#else // !NMEM_TRACE || MODULE
+
+#define N_ALLOC(size) NMEM_BASE_ALLOC(size)
+#define N_REALLOC(addr, new_size) NMEM_BASE_REALLOC(addr, new_size)
+#define N_FREE(addr) NMEM_BASE_FREE(addr)
+
+#endif // !NMEM_TRACE || MODULE
+
+#define NMEM_ERROR_S 0x6300
+
+#define NMEM_ALLOC_ERROR 0x6301
+#define NMEM_TLS_ERROR 0x6302
+#define NMEM_FORMAT_ERROR 0x6303
+
+#define NMEM_ERROR_E NMEM_FORMAT_ERROR
+
+// Cache line size used for alignment and padding
+#ifndef NMEM_CACHE_LINE
+#ifdef MODULE
+#define NMEM_CACHE_LINE SMP_CACHE_BYTES
+#else // !MODULE
+#define NMEM_CACHE_LINE 64
+#endif // !MODULE
+#endif // !NMEM_CACHE_LINE
+
+// Aligns a type or variable to its own cache line to avoid false sharing
+#ifdef _MSC_VER
+#define NMEM_CACHE_ALIGNED __declspec(align(NMEM_CACHE_LINE))
+#else // !_MSC_VER
+#define NMEM_CACHE_ALIGNED __attribute__((aligned(NMEM_CACHE_LINE)))
+#endif // !_MSC_VER
+
+// Pads a struct member out to the end of its cache line
+#define NMEM_CACHE_PAD(name, used_size) \
+	char name[NMEM_CACHE_LINE - ((used_size) % NMEM_CACHE_LINE)]
+
+/**
+ * @brief Allocate memory aligned to a power of two.
+ * @param size Size in bytes.
+ * @param align Alignment in bytes, a power of two (e.g. 32 for AVX).
+ * @return Aligned memory to release with nmem_free_aligned, or NULL.
+ */
+NEPTUNE_API void *nmem_alloc_aligned(size_t size, size_t align);
+
+/**
+ * @brief Release memory from nmem_alloc_aligned.
+ * @param ptr Memory to release, or NULL.
+ */
+NEPTUNE_API void nmem_free_aligned(void *ptr);
+
+#define N_ALLOC_ALIGNED(size, align) nmem_alloc_aligned(size, align)
+#define N_FREE_ALIGNED(addr) nmem_free_aligned(addr)
+
+// Large blocks of at least this size are aligned to it for huge pages
+#define NMEM_LARGE_HUGE_SIZE (2 * 1024 * 1024)
+
+// Fault every page in at allocation instead of on first touch
+#define NMEM_LARGE_PREFAULT 0x01
+
+typedef uint8_t nmem_large_flags_t;
+
+/**
+ * @brief Allocate a large block outside the regular heap.
+ *
+ * Meant for multi-megabyte buffers such as lookup tables. In user mode the
+ * block is mapped directly; from NMEM_LARGE_HUGE_SIZE up it is aligned to
+ * that size and marked for transparent huge pages, which cuts TLB misses
+ * on random access. Windows uses large pages when the process holds the
+ * privilege. In the kernel it falls back from kmalloc to vmalloc.
+ *
+ * @param size Size in bytes.
+ * @param flags NMEM_LARGE_* flags.
+ * @return Zeroed memory, or NULL.
+ */
+NEPTUNE_API void *nmem_alloc_large(size_t size, nmem_large_flags_t flags);
+
+/**
+ * @brief Release a block from nmem_alloc_large.
+ * @param ptr Block to release, or NULL.
+ * @param size Size passed to nmem_alloc_large.
+ */
+NEPTUNE_API void nmem_free_large(void *ptr, size_t size);
+
+typedef void *(*nmem_alloc_fn)(void *ctx, size_t size);
+typedef void (*nmem_free_fn)(void *ctx, void *ptr);
+
+// Caller-supplied allocator for APIs that hand out memory
+struct nmem_allocator {
+	nmem_alloc_fn alloc; // Allocation callback
+	nmem_free_fn free; // Release callback, NULL for arena-style allocators
+	void *ctx; // Passed as the first argument to both callbacks
+};
+
+typedef struct nmem_allocator nmem_allocator_t;
+
+// Allocate through an allocator, falling back to N_ALLOC when it is NULL
+#define NMEM_ALLOCATOR_ALLOC(allocator, size) \
+	((allocator) == NULL ? N_ALLOC(size) :  \
+			       (allocator)->alloc((allocator)->ctx, size))
+
+// Release through an allocator, falling back to N_FREE when it is NULL
+#define NMEM_ALLOCATOR_FREE(allocator, ptr)                   \
+	do {                                                  \
+		if ((allocator) == NULL)                      \
+			N_FREE(ptr);                          \
+		else if ((allocator)->free != NULL)           \
+			(allocator)->free((allocator)->ctx, ptr); \
+	} while (0)
 #endif // !__NMEM_H__
@@ -0,0 +1,157 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nmem_arena.h
+ * @brief Neptune library - Arena (bump) allocator.
+ *
+ * An arena hands out memory by bumping a pointer through large chunks and
+ * frees it all at once: `nmem_arena_rewind` drops everything allocated
+ * after a mark and `nmem_arena_reset` drops everything, without touching
+ * the individual allocations. Suited to per-request and per-record
+ * temporaries that share a lifetime.
+ *
+ * The first block can be a caller-owned buffer (typically on the stack),
+ * so small workloads never reach the heap. Chunks come from `N_ALLOC`, the
+ * arena behaves the same in user and kernel mode. An arena is not thread
+ * safe.
+ */
+
+#ifndef __NMEM_ARENA_H__
+#define __NMEM_ARENA_H__
+
+#include "nmem.h"
+
+#ifndef NMEM_ARENA_CHUNK_SIZE
+#ifdef MODULE
+#define NMEM_ARENA_CHUNK_SIZE (16 * 1024)
+#else // !MODULE
+#define NMEM_ARENA_CHUNK_SIZE (64 * 1024)
+#endif // !MODULE
+#endif // !NMEM_ARENA_CHUNK_SIZE
+
+// Default alignment of nmem_arena_alloc, fits any scalar type
+#define NMEM_ARENA_ALIGN (2 * sizeof(void *))
+
+struct nmem_arena_chunk;
+
+struct nmem_arena {
+	struct nmem_arena_chunk *chunk; // Current heap chunk, NULL in the first block
+	struct nmem_arena_chunk *spare; // Freed chunk kept for reuse
+	char *pos; // Next free byte of the current block
+	char *end; // End of the current block
+
+	char *first; // Caller-owned first block, may be NULL
+	size_t first_size;
+	size_t chunk_size; // Usable size of a regular heap chunk
+};
+
+typedef struct nmem_arena nmem_arena_t;
+
+// Position to rewind to, taken with nmem_arena_mark
+struct nmem_arena_mark {
+	struct nmem_arena_chunk *chunk;
+	char *pos;
+};
+
+typedef struct nmem_arena_mark nmem_arena_mark_t;
+
+/**
+ * @brief Initialize an arena.
+ * @param arena Arena to initialize.
+ * @param buffer Caller-owned first block, NULL for none. Must outlive the arena.
+ * @param buffer_size Size of buffer in bytes.
+ * @param chunk_size Usable size of heap chunks, 0 for NMEM_ARENA_CHUNK_SIZE.
+ */
+NEPTUNE_API void nmem_arena_init(nmem_arena_t *arena, void *buffer,
+				 size_t buffer_size, size_t chunk_size);
+
+// Initialize an arena whose first block is a local array
+#define NMEM_ARENA_INIT_INLINE(arena, array) \
+	nmem_arena_init(arena, array, sizeof(array), 0)
+
+/**
+ * @brief Free every heap chunk of an arena.
+ * @param arena Arena to destroy.
+ */
+NEPTUNE_API void nmem_arena_destroy(nmem_arena_t *arena);
+
+/**
+ * @brief Allocate from an arena with a given alignment.
+ * @param arena Arena.
+ * @param size Size in bytes.
+ * @param align Alignment, a power of two.
+ * @return Memory valid until rewound past or reset, or NULL.
+ */
+NEPTUNE_API void *nmem_arena_alloc_aligned(nmem_arena_t *arena, size_t size,
+					   size_t align);
+
+/**
+ * @brief Allocate from an arena, aligned to NMEM_ARENA_ALIGN.
+ * @param arena Arena.
+ * @param size Size in bytes.
+ * @return Memory valid until rewound past or reset, or NULL.
+ */
+NEPTUNE_API void *nmem_arena_alloc(nmem_arena_t *arena, size_t size);
+
+/**
+ * @brief Remember the current position of an arena.
+ * @param arena Arena.
+ * @return Mark for nmem_arena_rewind.
+ */
+NEPTUNE_API nmem_arena_mark_t nmem_arena_mark(nmem_arena_t *arena);
+
+/**
+ * @brief Free everything allocated since a mark.
+ *
+ * Marks taken after this one become invalid.
+ *
+ * @param arena Arena.
+ * @param mark Mark taken on the same arena.
+ */
+NEPTUNE_API void nmem_arena_rewind(nmem_arena_t *arena,
+				   nmem_arena_mark_t mark);
+
+/**
+ * @brief Free everything allocated from an arena.
+ *
+ * One chunk is kept for reuse, nmem_arena_destroy releases it.
+ *
+ * @param arena Arena.
+ */
+NEPTUNE_API void nmem_arena_reset(nmem_arena_t *arena);
+
+/**
+ * @brief Wrap an arena as an allocator for APIs that take one.
+ *
+ * Frees through the allocator are no-ops.
+ *
+ * @param arena Arena, must outlive the allocator.
+ * @return Allocator drawing from the arena.
+ */
+NEPTUNE_API nmem_allocator_t nmem_arena_allocator(nmem_arena_t *arena);
+
+#define NMEM_ARENA_ALLOC(arena, size) nmem_arena_alloc(arena, size)
+
+#endif // !__NMEM_ARENA_H__
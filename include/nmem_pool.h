@@ -0,0 +1,142 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nmem_pool.h
+ * @brief Neptune library - Fixed-size object pool.
+ *
+ * A pool serves objects of a single size much faster than the general
+ * heap. In user mode objects are carved out of large aligned pages that
+ * stay with the pool until it is destroyed. Every thread keeps a small
+ * magazine of free objects so most allocations and frees touch no shared
+ * state; magazines are refilled from and flushed to a global lock-free
+ * free list in batches. The free list head carries a generation tag next
+ * to the object index, so a concurrent pop/push of the same object (ABA)
+ * cannot corrupt it.
+ *
+ * In kernel mode a pool is a thin wrapper over a `kmem_cache`, which
+ * already provides per-CPU caching.
+ */
+
+#ifndef __NMEM_POOL_H__
+#define __NMEM_POOL_H__
+
+#include "nmem.h"
+
+#ifndef NMEM_POOL_PAGE_SIZE
+#define NMEM_POOL_PAGE_SIZE (64 * 1024)
+#endif // !NMEM_POOL_PAGE_SIZE
+
+#ifndef NMEM_POOL_MAGAZINE_SIZE
+#define NMEM_POOL_MAGAZINE_SIZE 64
+#endif // !NMEM_POOL_MAGAZINE_SIZE
+
+// Objects are aligned like malloc'ed memory
+#define NMEM_POOL_ALIGN (2 * sizeof(void *))
+
+#ifdef MODULE
+
+#include <linux/slab.h>
+
+struct nmem_pool {
+	struct kmem_cache *cache;
+	size_t object_size;
+};
+
+#else // !MODULE
+
+#include "natomic.h"
+#include "nmutex.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif // !_WIN32
+
+#define NMEM_POOL_DIR_SIZE 256 // Directory blocks, each with as many pages
+
+struct nmem_pool_magazine;
+
+struct nmem_pool {
+	natomic64_t head; // Free list: generation tag << 32 | object index + 1
+
+	size_t object_size; // Rounded up to NMEM_POOL_ALIGN
+	size_t page_size; // Power of two, pages are aligned to it
+	uint32_t page_objects; // Objects per page
+	uint32_t page_count; // Pages allocated, guarded by mutex
+
+	void **dir[NMEM_POOL_DIR_SIZE]; // Page number to page address
+
+	struct nmem_pool_magazine *magazines; // Live magazines, guarded by mutex
+	NMUTEX mutex;
+
+#ifdef _WIN32
+	DWORD key; // Fiber local slot of the thread's magazine
+#else // !_WIN32
+	pthread_key_t key; // Thread specific slot of the thread's magazine
+#endif // !_WIN32
+};
+
+#endif // !MODULE
+
+typedef struct nmem_pool nmem_pool_t;
+
+/**
+ * @brief Initialize a pool.
+ * @param pool Pool to initialize.
+ * @param name Cache name shown in /proc/slabinfo in kernel mode, must
+ *             outlive the pool; ignored in user mode.
+ * @param object_size Size of every object in bytes.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nmem_pool_init(nmem_pool_t *pool, const char *name,
+				    size_t object_size);
+
+/**
+ * @brief Release every page of a pool.
+ *
+ * Objects still allocated become invalid. Must not race with other calls
+ * on the pool.
+ *
+ * @param pool Pool to destroy.
+ */
+NEPTUNE_API void nmem_pool_destroy(nmem_pool_t *pool);
+
+/**
+ * @brief Allocate an object.
+ * @param pool Pool.
+ * @return Object of the pool's size, or NULL.
+ */
+NEPTUNE_API void *nmem_pool_alloc(nmem_pool_t *pool);
+
+/**
+ * @brief Return an object to its pool; any thread may free it.
+ * @param pool Pool the object was allocated from.
+ * @param ptr Object, NULL is ignored.
+ */
+NEPTUNE_API void nmem_pool_free(nmem_pool_t *pool, void *ptr);
+
+#define NMEM_POOL_ALLOC(pool) nmem_pool_alloc(pool)
+#define NMEM_POOL_FREE(pool, ptr) nmem_pool_free(pool, ptr)
+
+#endif // !__NMEM_POOL_H__
@@ -0,0 +1,74 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nmem_tcache.h
+ * @brief Neptune library - Thread-caching allocator.
+ *
+ * A small general purpose allocator for user mode that scales across
+ * cores. Requests up to NMEM_TCACHE_MAX_SIZE are rounded to one of a few
+ * dozen size classes (four per power of two) and served from a per-thread
+ * cache of free blocks without any locking. Caches move blocks to and from
+ * a central free list per class in batches, so the central lock is taken
+ * once per batch rather than once per call. Larger requests go straight to
+ * the platform allocator.
+ *
+ * Memory handed to the central lists is reused but never returned to the
+ * system. Define `NMEM_USE_TCACHE` to route `N_ALLOC`, `N_REALLOC` and
+ * `N_FREE` here; the functions can also be called directly.
+ */
+
+#ifndef __NMEM_TCACHE_H__
+#define __NMEM_TCACHE_H__
+
+#include "neptune.h"
+
+#ifndef MODULE
+
+// Largest block served from the size classes, header included
+#define NMEM_TCACHE_MAX_SIZE (32 * 1024)
+
+/**
+ * @brief Allocate memory, like malloc.
+ * @param size Size in bytes.
+ * @return Memory aligned like malloc's, or NULL.
+ */
+NEPTUNE_API void *nmem_tcache_alloc(size_t size);
+
+/**
+ * @brief Resize memory, like realloc.
+ * @param ptr Memory from nmem_tcache_alloc, or NULL.
+ * @param size New size in bytes; 0 frees ptr and returns NULL.
+ * @return Resized memory, or NULL with ptr left intact.
+ */
+NEPTUNE_API void *nmem_tcache_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Release memory, like free; any thread may release it.
+ * @param ptr Memory from nmem_tcache_alloc, or NULL.
+ */
+NEPTUNE_API void nmem_tcache_free(void *ptr);
+
+#endif // !MODULE
+#endif // !__NMEM_TCACHE_H__
@@ -0,0 +1,127 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nmem_trace.h
+ * @brief Neptune library - Allocation instrumentation.
+ *
+ * Defining `NMEM_TRACE` makes `N_ALLOC`, `N_REALLOC` and `N_FREE` record
+ * every call against its call site (file and line). For each site it keeps
+ * the number of allocations and frees, the bytes requested, the bytes
+ * still live, their high-water mark and a histogram of request sizes.
+ *
+ * Counters live in a per-thread table, so the hot path takes no lock and
+ * touches no shared cache line; live bytes are folded into the site in
+ * batches of NMEM_TRACE_BATCH. Peaks are exact for sites used by a single
+ * thread and within NMEM_TRACE_BATCH per thread otherwise. The report of
+ * the busiest sites and of every site with live blocks is written to the
+ * log at neptune_destroy. User mode only; in the kernel use kmemleak.
+ */
+
+#ifndef __NMEM_TRACE_H__
+#define __NMEM_TRACE_H__
+
+#include "neptune.h"
+
+#ifndef MODULE
+
+// Distinct call sites tracked, later ones are counted under "(other)"
+#ifndef NMEM_TRACE_MAX_SITES
+#define NMEM_TRACE_MAX_SITES 512
+#endif // !NMEM_TRACE_MAX_SITES
+
+// Histogram buckets: up to 16 bytes, then one per power of four
+#define NMEM_TRACE_BUCKETS 8
+
+// Live bytes a thread accumulates per site before publishing them
+#define NMEM_TRACE_BATCH (64 * 1024)
+
+// Sites listed by nmem_trace_dump at neptune_destroy
+#ifndef NMEM_TRACE_DUMP_TOP
+#define NMEM_TRACE_DUMP_TOP 10
+#endif // !NMEM_TRACE_DUMP_TOP
+
+// Counters of a single call site
+struct nmem_trace_stat {
+	const char *file; // Source file of the call site
+	int line; // Source line of the call site
+
+	uint64_t allocs; // Allocations made here, reallocs included
+	uint64_t frees; // Blocks from here released or reallocated
+	uint64_t bytes; // Bytes requested in total
+	int64_t live; // Bytes still allocated
+	int64_t live_blocks; // Blocks still allocated
+	uint64_t peak; // High-water mark of live
+	uint64_t histogram[NMEM_TRACE_BUCKETS]; // Allocations by size
+};
+
+typedef struct nmem_trace_stat nmem_trace_stat_t;
+
+/**
+ * @brief Allocate memory and record it against a call site.
+ * @param size Size in bytes.
+ * @param file Source file of the caller, must outlive the process.
+ * @param line Source line of the caller.
+ * @return Memory aligned like malloc's, or NULL.
+ */
+NEPTUNE_API void *nmem_trace_alloc(size_t size, const char *file, int line);
+
+/**
+ * @brief Resize memory, recorded as a free and an allocation.
+ * @param ptr Memory from nmem_trace_alloc, or NULL.
+ * @param size New size in bytes; 0 frees ptr and returns NULL.
+ * @param file Source file of the caller.
+ * @param line Source line of the caller.
+ * @return Resized memory, or NULL with ptr left intact.
+ */
+NEPTUNE_API void *nmem_trace_realloc(void *ptr, size_t size, const char *file,
+				     int line);
+
+/**
+ * @brief Release memory and record it against its allocating site.
+ * @param ptr Memory from nmem_trace_alloc, or NULL.
+ */
+NEPTUNE_API void nmem_trace_free(void *ptr);
+
+/**
+ * @brief Collect the counters of every site, busiest first.
+ * @param stats Output array, may be NULL to count the sites.
+ * @param count Capacity of stats.
+ * @return Number of sites written, or in use when stats is NULL.
+ */
+NEPTUNE_API size_t nmem_trace_snapshot(nmem_trace_stat_t *stats, size_t count);
+
+/**
+ * @brief Log the busiest sites and every site with live blocks.
+ * @param top Number of sites to list by bytes requested.
+ */
+NEPTUNE_API void nmem_trace_dump(size_t top);
+
+/**
+ * @brief Report at shutdown, registered with the module rules.
+ */
+NEPTUNE_API void nmem_trace_destroy(void);
+
+#endif // !MODULE
+#endif // !__NMEM_TRACE_H__
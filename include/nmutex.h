@@ -30,9 +30,23 @@
  * providing a uniform interface to initialize, lock, and unlock mutexes.
  *
  * Macros:
+ * - `NMUTEX_DEFINE(name)`: Define a statically initialized mutex.
  * - `NMUTEX_INIT(mutex)`: Initialize the mutex.
  * - `NMUTEX_LOCK(mutex)`: Acquire the mutex lock.
  * - `NMUTEX_UNLOCK(mutex)`: Release the mutex lock.
+ *
+ * On Linux user mode the mutex is a single futex word: an uncontended lock
+ * and unlock are one atomic instruction each, and a contended lock spins
+ * for an adaptively tuned number of rounds before parking in the kernel.
+ * Windows uses an SRWLOCK, which behaves the same way. Other POSIX systems
+ * fall back to `pthread_mutex_t`. The mutexes are not recursive.
+ *
+ * Defining `NMUTEX_PROFILE` (user mode) wraps every mutex to record, per
+ * lock name, acquisitions, contended acquisitions, wait times and a hold
+ * time histogram. The name is the expression passed to `NMUTEX_LOCK`, so
+ * `log_mutex` or `cache->mutex` show up as such. Uncontended acquisitions
+ * only touch counters of the calling thread. The report is logged at
+ * neptune_destroy.
  */
 
 #ifndef __NMUTEX_H__
@@ -44,36 +58,177 @@
 
 #define NMUTEX struct mutex
 
+#define NMUTEX_DEFINE(name) DEFINE_MUTEX(name)
+
 #define NMUTEX_INIT(nmutex) mutex_init(&nmutex)
 #define NMUTEX_LOCK(nmutex) mutex_lock(&nmutex)
 #define NMUTEX_UNLOCK(nmutex) mutex_unlock(&nmutex)
 
 #else // !MODULE
 
+// NMUTEX_BASE_* always reach the platform lock, NMUTEX_* may be profiled
 #ifdef _WIN32
 
-#define NMUTEX HANDLE
+#define NMUTEX_BASE SRWLOCK
+#define NMUTEX_BASE_INITIALIZER SRWLOCK_INIT
+
+#define NMUTEX_BASE_INIT(nmutex) InitializeSRWLock(&nmutex)
+#define NMUTEX_BASE_LOCK(nmutex) AcquireSRWLockExclusive(&nmutex)
+#define NMUTEX_BASE_TRYLOCK(nmutex) TryAcquireSRWLockExclusive(&nmutex)
+#define NMUTEX_BASE_UNLOCK(nmutex) ReleaseSRWLockExclusive(&nmutex)
+#define NMUTEX_BASE_DESTROY(nmutex) ((void)0)
+
+#elif defined(__linux__) // !_WIN32
+
+#include "natomic.h"
+
+// Spin rounds tried before parking, the estimate adapts within these
+#define NMUTEX_SPIN_MIN 16
+#define NMUTEX_SPIN_MAX 1024
+
+struct nmutex {
+	natomic32_t state; // 0 unlocked, 1 locked, 2 locked with sleepers
+	natomic32_t spin; // Running estimate of the spin rounds that pay off
+};
+
+typedef struct nmutex nmutex_t;
+
+#define NMUTEX_BASE nmutex_t
+#define NMUTEX_BASE_INITIALIZER { 0, 0 }
+
+NEPTUNE_API void nmutex_init(nmutex_t *mutex);
 
-NEPTUNE_API HANDLE nmutex_init();
+NEPTUNE_API void nmutex_lock_slow(nmutex_t *mutex);
 
-NEPTUNE_API void nmutex_lock(HANDLE nmutex);
+NEPTUNE_API void nmutex_wake(nmutex_t *mutex);
 
-#define NMUTEX_INIT(nmutex) (nmutex = nmutex_init())
-#define NMUTEX_LOCK(nmutex) nmutex_lock(nmutex)
-#define NMUTEX_UNLOCK(nmutex) ReleaseMutex(nmutex)
-#define NMUTEX_DESTROY(nmutex) CloseHandle(nmutex)
+static inline bool nmutex_trylock(nmutex_t *mutex)
+{
+	uint32_t expected = 0;
+	return natomic32_cas(&mutex->state, &expected, 1, NATOMIC_ACQUIRE);
+}
 
-#else // !_WIN32
+static inline void nmutex_lock(nmutex_t *mutex)
+{
+	if (!nmutex_trylock(mutex))
+		nmutex_lock_slow(mutex);
+}
 
-#define NMUTEX pthread_mutex_t
+static inline void nmutex_unlock(nmutex_t *mutex)
+{
+	if (natomic32_exchange(&mutex->state, 0, NATOMIC_RELEASE) == 2)
+		nmutex_wake(mutex);
+}
+
+#define NMUTEX_BASE_INIT(nmutex) nmutex_init(&nmutex)
+#define NMUTEX_BASE_LOCK(nmutex) nmutex_lock(&nmutex)
+#define NMUTEX_BASE_TRYLOCK(nmutex) nmutex_trylock(&nmutex)
+#define NMUTEX_BASE_UNLOCK(nmutex) nmutex_unlock(&nmutex)
+#define NMUTEX_BASE_DESTROY(nmutex) ((void)0)
+
+#else // !_WIN32 && !__linux__
+
+#define NMUTEX_BASE pthread_mutex_t
+#define NMUTEX_BASE_INITIALIZER PTHREAD_MUTEX_INITIALIZER
 
 NEPTUNE_API void nmutex_init(pthread_mutex_t *mutex);
 
-#define NMUTEX_INIT(nmutex) nmutex_init(&nmutex)
-#define NMUTEX_LOCK(nmutex) pthread_mutex_lock(&nmutex)
-#define NMUTEX_UNLOCK(nmutex) pthread_mutex_unlock(&nmutex)
-#define NMUTEX_DESTROY(nmutex) pthread_mutex_destroy(&nmutex)
+#define NMUTEX_BASE_INIT(nmutex) nmutex_init(&nmutex)
+#define NMUTEX_BASE_LOCK(nmutex) pthread_mutex_lock(&nmutex)
+#define NMUTEX_BASE_TRYLOCK(nmutex) (pthread_mutex_trylock(&nmutex) == 0)
+#define NMUTEX_BASE_UNLOCK(nmutex) pthread_mutex_unlock(&nmutex)
+#define NMUTEX_BASE_DESTROY(nmutex) pthread_mutex_destroy(&nmutex)
+
+#endif // !_WIN32 && !__linux__
+
+// Define NMUTEX_PROFILE to record contention for every lock by name
+#ifdef NMUTEX_PROFILE
+
+// Hold time buckets: up to 256ns, then one per power of four
+#define NMUTEX_PROFILE_BUCKETS 8
+
+// Distinct lock names tracked, later ones are counted under "(other)"
+#ifndef NMUTEX_PROFILE_MAX_SITES
+#define NMUTEX_PROFILE_MAX_SITES 256
+#endif // !NMUTEX_PROFILE_MAX_SITES
+
+// Locks listed by nmutex_profile_dump at neptune_destroy
+#ifndef NMUTEX_PROFILE_DUMP_TOP
+#define NMUTEX_PROFILE_DUMP_TOP 10
+#endif // !NMUTEX_PROFILE_DUMP_TOP
+
+struct nmutex_profiled {
+	NMUTEX_BASE base;
+	uint64_t acquired; // Time of the current acquisition, in nanoseconds
+	uint32_t site; // Site of the current holder
+};
+
+typedef struct nmutex_profiled nmutex_profiled_t;
+
+// Counters of a named lock
+struct nmutex_profile_stat {
+	const char *file; // Source file of the lock calls
+	const char *name; // Lock expression as written in NMUTEX_LOCK
+
+	uint64_t acquires; // Acquisitions in total
+	uint64_t contended; // Acquisitions that had to wait
+	uint64_t wait_total; // Nanoseconds spent waiting
+	uint64_t wait_max; // Longest single wait
+	uint64_t hold_total; // Nanoseconds the lock was held
+	uint64_t hold_histogram[NMUTEX_PROFILE_BUCKETS]; // Holds by length
+};
+
+typedef struct nmutex_profile_stat nmutex_profile_stat_t;
+
+NEPTUNE_API void nmutex_profile_init(nmutex_profiled_t *mutex);
+
+NEPTUNE_API void nmutex_profile_lock(nmutex_profiled_t *mutex,
+				     const char *file, const char *name);
+
+NEPTUNE_API void nmutex_profile_unlock(nmutex_profiled_t *mutex);
+
+/**
+ * @brief Collect the counters of every lock, most waited on first.
+ * @param stats Output array, may be NULL to count the locks.
+ * @param count Capacity of stats.
+ * @return Number of locks written, or in use when stats is NULL.
+ */
+NEPTUNE_API size_t nmutex_profile_snapshot(nmutex_profile_stat_t *stats,
+					   size_t count);
+
+/**
+ * @brief Log the locks with the most waiting.
+ * @param top Number of locks to list.
+ */
+NEPTUNE_API void nmutex_profile_dump(size_t top);
+
+/**
+ * @brief Report at shutdown, registered with the module rules.
+ */
+NEPTUNE_API void nmutex_profile_destroy(void);
+
+#define NMUTEX nmutex_profiled_t
+#define NMUTEX_INITIALIZER { NMUTEX_BASE_INITIALIZER, 0, 0 }
+
+#define NMUTEX_INIT(nmutex) nmutex_profile_init(&nmutex)
+#define NMUTEX_LOCK(nmutex) nmutex_profile_lock(&nmutex, __FILE__, #nmutex)
+#define NMUTEX_UNLOCK(nmutex) nmutex_profile_unlock(&nmutex)
+#define NMUTEX_DESTROY(nmutex) NMUTEX_BASE_DESTROY((nmutex).base)
+
+#else // !NMUTEX_PROFILE
+
+#define NMUTEX NMUTEX_BASE
+#define NMUTEX_INITIALIZER NMUTEX_BASE_INITIALIZER
+
+#define NMUTEX_INIT(nmutex) NMUTEX_BASE_INIT(nmutex)
+#define NMUTEX_LOCK(nmutex) NMUTEX_BASE_LOCK(nmutex)
+#define NMUTEX_UNLOCK(nmutex) NMUTEX_BASE_UNLOCK(nmutex)
+#define NMUTEX_DESTROY(nmutex) NMUTEX_BASE_DESTROY(nmutex)
+
+#endif // !NMUTEX_PROFILE
+
+#define NMUTEX_DEFINE(name) NMUTEX name = NMUTEX_INITIALIZER
+
 
-#endif // !_WIN32
 #endif // !MODULE
 #endif // !__MUTEX_H__
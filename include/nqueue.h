@@ -0,0 +1,184 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nqueue.h
+ * @brief Neptune library - Bounded lock-free queues.
+ *
+ * Two fixed-capacity queues of pointers for handing work between threads:
+ *
+ * - `nspsc_t`: one producer and one consumer. Each side keeps a cached
+ *   copy of the other side's index and only reads the shared one when the
+ *   cache says the ring looks full or empty.
+ * - `nmpmc_t`: any number of producers and consumers, Vyukov's array
+ *   queue. Every slot carries a sequence number telling whose turn it is,
+ *   so producers and consumers only contend on their own index.
+ *
+ * Producer and consumer indexes sit on separate cache lines. The batch
+ * functions move as many items as fit with a single index update. Capacities
+ * are rounded up to a power of two. Pushing fails when the queue is full
+ * and popping fails when it is empty, neither ever blocks.
+ */
+
+#ifndef __NQUEUE_H__
+#define __NQUEUE_H__
+
+#include "neptune.h"
+#include "natomic.h"
+#include "nmem.h"
+#include "nerror.h"
+
+struct NMEM_CACHE_ALIGNED nspsc {
+	natomic64_t tail; // Next slot to write, advanced by the producer
+	uint64_t head_cache; // Producer's last view of head
+	NMEM_CACHE_PAD(producer_pad, sizeof(natomic64_t) + sizeof(uint64_t));
+
+	natomic64_t head; // Next slot to read, advanced by the consumer
+	uint64_t tail_cache; // Consumer's last view of tail
+	NMEM_CACHE_PAD(consumer_pad, sizeof(natomic64_t) + sizeof(uint64_t));
+
+	uint64_t mask; // Capacity - 1
+	void **slots;
+};
+
+typedef struct nspsc nspsc_t;
+
+struct nmpmc_cell {
+	natomic64_t sequence; // Position the cell is ready for
+	void *item;
+};
+
+struct NMEM_CACHE_ALIGNED nmpmc {
+	natomic64_t tail; // Next position to write
+	NMEM_CACHE_PAD(tail_pad, sizeof(natomic64_t));
+
+	natomic64_t head; // Next position to read
+	NMEM_CACHE_PAD(head_pad, sizeof(natomic64_t));
+
+	uint64_t mask; // Capacity - 1
+	struct nmpmc_cell *cells;
+};
+
+typedef struct nmpmc nmpmc_t;
+
+/**
+ * @brief Initialize a single-producer single-consumer queue.
+ * @param queue Queue to initialize.
+ * @param capacity Items it holds, rounded up to a power of two.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nspsc_init(nspsc_t *queue, size_t capacity);
+
+/**
+ * @brief Release the slots of a queue, items left in it are dropped.
+ * @param queue Queue to destroy.
+ */
+NEPTUNE_API void nspsc_destroy(nspsc_t *queue);
+
+/**
+ * @brief Add an item, producer only.
+ * @param queue Queue.
+ * @param item Item to add.
+ * @return Whether the item was added, false when the queue is full.
+ */
+NEPTUNE_API bool nspsc_push(nspsc_t *queue, void *item);
+
+/**
+ * @brief Take the oldest item, consumer only.
+ * @param queue Queue.
+ * @param item Receives the item.
+ * @return Whether an item was taken, false when the queue is empty.
+ */
+NEPTUNE_API bool nspsc_pop(nspsc_t *queue, void **item);
+
+/**
+ * @brief Add as many items as fit, in order, producer only.
+ * @param queue Queue.
+ * @param items Items to add.
+ * @param count Number of items.
+ * @return Number of items added, from the start of items.
+ */
+NEPTUNE_API size_t nspsc_push_batch(nspsc_t *queue, void *const *items,
+				    size_t count);
+
+/**
+ * @brief Take up to count of the oldest items, consumer only.
+ * @param queue Queue.
+ * @param items Receives the items, oldest first.
+ * @param count Capacity of items.
+ * @return Number of items taken.
+ */
+NEPTUNE_API size_t nspsc_pop_batch(nspsc_t *queue, void **items, size_t count);
+
+/**
+ * @brief Initialize a multi-producer multi-consumer queue.
+ * @param queue Queue to initialize.
+ * @param capacity Items it holds, rounded up to a power of two of at
+ *                 least 2.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nmpmc_init(nmpmc_t *queue, size_t capacity);
+
+/**
+ * @brief Release the cells of a queue, items left in it are dropped.
+ * @param queue Queue to destroy.
+ */
+NEPTUNE_API void nmpmc_destroy(nmpmc_t *queue);
+
+/**
+ * @brief Add an item.
+ * @param queue Queue.
+ * @param item Item to add.
+ * @return Whether the item was added, false when the queue is full.
+ */
+NEPTUNE_API bool nmpmc_push(nmpmc_t *queue, void *item);
+
+/**
+ * @brief Take the oldest item.
+ * @param queue Queue.
+ * @param item Receives the item.
+ * @return Whether an item was taken, false when the queue is empty.
+ */
+NEPTUNE_API bool nmpmc_pop(nmpmc_t *queue, void **item);
+
+/**
+ * @brief Add as many items as fit into consecutive positions.
+ * @param queue Queue.
+ * @param items Items to add.
+ * @param count Number of items.
+ * @return Number of items added, from the start of items.
+ */
+NEPTUNE_API size_t nmpmc_push_batch(nmpmc_t *queue, void *const *items,
+				    size_t count);
+
+/**
+ * @brief Take up to count consecutive items.
+ * @param queue Queue.
+ * @param items Receives the items, oldest first.
+ * @param count Capacity of items.
+ * @return Number of items taken.
+ */
+NEPTUNE_API size_t nmpmc_pop_batch(nmpmc_t *queue, void **items, size_t count);
+
+#endif // !__NQUEUE_H__
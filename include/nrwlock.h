@@ -0,0 +1,110 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nrwlock.h
+ * @brief Neptune library - Reader-writer lock.
+ *
+ * An NRWLOCK lets any number of readers in at once while writers get
+ * exclusive access, for data that is read far more often than written.
+ * Locks from `NRWLOCK_INIT` prefer readers: a reader never waits while
+ * another reader holds the lock, which can starve writers under constant
+ * reading. Locks from `NRWLOCK_INIT_WRITER` prefer writers, new readers
+ * queue behind a waiting writer.
+ *
+ * POSIX uses `pthread_rwlock_t` and honors the preference where the C
+ * library supports it (glibc). Windows uses an SRWLOCK and the kernel a
+ * `struct rw_semaphore`; both are fair and ignore the preference. The
+ * locks are not recursive.
+ *
+ * Macros:
+ * - `NRWLOCK_DEFINE(name)`: Define a statically initialized lock.
+ * - `NRWLOCK_INIT(lock)` / `NRWLOCK_INIT_WRITER(lock)`: Initialize a lock.
+ * - `NRWLOCK_READ_LOCK(lock)` / `NRWLOCK_READ_UNLOCK(lock)`: Shared access.
+ * - `NRWLOCK_WRITE_LOCK(lock)` / `NRWLOCK_WRITE_UNLOCK(lock)`: Exclusive.
+ */
+
+#ifndef __NRWLOCK_H__
+#define __NRWLOCK_H__
+
+#include "neptune.h"
+
+#ifdef MODULE
+
+#include <linux/rwsem.h>
+
+// Readers may sleep while holding it, unlike rwlock_t
+#define NRWLOCK struct rw_semaphore
+
+#define NRWLOCK_DEFINE(name) DECLARE_RWSEM(name)
+
+#define NRWLOCK_INIT(nrwlock) init_rwsem(&nrwlock)
+#define NRWLOCK_INIT_WRITER(nrwlock) init_rwsem(&nrwlock)
+#define NRWLOCK_READ_LOCK(nrwlock) down_read(&nrwlock)
+#define NRWLOCK_READ_UNLOCK(nrwlock) up_read(&nrwlock)
+#define NRWLOCK_WRITE_LOCK(nrwlock) down_write(&nrwlock)
+#define NRWLOCK_WRITE_UNLOCK(nrwlock) up_write(&nrwlock)
+
+#else // !MODULE
+
+#ifdef _WIN32
+
+#define NRWLOCK SRWLOCK
+#define NRWLOCK_INITIALIZER SRWLOCK_INIT
+
+#define NRWLOCK_INIT(nrwlock) InitializeSRWLock(&nrwlock)
+#define NRWLOCK_INIT_WRITER(nrwlock) InitializeSRWLock(&nrwlock)
+#define NRWLOCK_READ_LOCK(nrwlock) AcquireSRWLockShared(&nrwlock)
+#define NRWLOCK_READ_UNLOCK(nrwlock) ReleaseSRWLockShared(&nrwlock)
+#define NRWLOCK_WRITE_LOCK(nrwlock) AcquireSRWLockExclusive(&nrwlock)
+#define NRWLOCK_WRITE_UNLOCK(nrwlock) ReleaseSRWLockExclusive(&nrwlock)
+#define NRWLOCK_DESTROY(nrwlock) ((void)0)
+
+#else // !_WIN32
+
+#define NRWLOCK pthread_rwlock_t
+#define NRWLOCK_INITIALIZER PTHREAD_RWLOCK_INITIALIZER
+
+/**
+ * @brief Initialize a reader-writer lock.
+ * @param lock Lock to initialize.
+ * @param prefer_writers Queue new readers behind waiting writers.
+ */
+NEPTUNE_API void nrwlock_init(pthread_rwlock_t *lock, bool prefer_writers);
+
+#define NRWLOCK_INIT(nrwlock) nrwlock_init(&nrwlock, false)
+#define NRWLOCK_INIT_WRITER(nrwlock) nrwlock_init(&nrwlock, true)
+#define NRWLOCK_READ_LOCK(nrwlock) pthread_rwlock_rdlock(&nrwlock)
+#define NRWLOCK_READ_UNLOCK(nrwlock) pthread_rwlock_unlock(&nrwlock)
+#define NRWLOCK_WRITE_LOCK(nrwlock) pthread_rwlock_wrlock(&nrwlock)
+#define NRWLOCK_WRITE_UNLOCK(nrwlock) pthread_rwlock_unlock(&nrwlock)
+#define NRWLOCK_DESTROY(nrwlock) pthread_rwlock_destroy(&nrwlock)
+
+#endif // !_WIN32
+
+// Reader-preferring, like NRWLOCK_INIT
+#define NRWLOCK_DEFINE(name) NRWLOCK name = NRWLOCK_INITIALIZER
+
+#endif // !MODULE
+#endif // !__NRWLOCK_H__
@@ -0,0 +1,132 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nseqlock.h
+ * @brief Neptune library - Sequence lock.
+ *
+ * An NSEQLOCK protects small, read-mostly data without making readers
+ * write to shared memory, so reads scale with the number of cores. Writers
+ * serialize on a mutex and bump a sequence counter before and after the
+ * update; readers take no lock, copy the data and retry if the counter
+ * moved or was odd meanwhile:
+ *
+ *     unsigned seq;
+ *     do {
+ *             seq = NSEQLOCK_READ_BEGIN(lock);
+ *             copy = shared;
+ *     } while (NSEQLOCK_READ_RETRY(lock, seq));
+ *
+ * Readers may see torn data inside the loop, they must only copy it and
+ * never follow pointers out of it before the retry check passes. The
+ * kernel uses `seqlock_t`.
+ */
+
+#ifndef __NSEQLOCK_H__
+#define __NSEQLOCK_H__
+
+#include "neptune.h"
+
+#ifdef MODULE
+
+#include <linux/seqlock.h>
+
+#define NSEQLOCK seqlock_t
+
+#define NSEQLOCK_DEFINE(name) DEFINE_SEQLOCK(name)
+
+#define NSEQLOCK_INIT(nseqlock) seqlock_init(&nseqlock)
+#define NSEQLOCK_READ_BEGIN(nseqlock) read_seqbegin(&nseqlock)
+#define NSEQLOCK_READ_RETRY(nseqlock, seq) read_seqretry(&nseqlock, seq)
+#define NSEQLOCK_WRITE_LOCK(nseqlock) write_seqlock(&nseqlock)
+#define NSEQLOCK_WRITE_UNLOCK(nseqlock) write_sequnlock(&nseqlock)
+
+#else // !MODULE
+
+#include "natomic.h"
+#include "nmutex.h"
+
+struct nseqlock {
+	natomic32_t sequence; // Odd while a write is in progress
+	NMUTEX writer; // Serializes writers
+};
+
+typedef struct nseqlock nseqlock_t;
+
+static inline void nseqlock_init(nseqlock_t *lock)
+{
+	natomic32_store(&lock->sequence, 0, NATOMIC_RELAXED);
+	NMUTEX_INIT(lock->writer);
+}
+
+static inline unsigned nseqlock_read_begin(nseqlock_t *lock)
+{
+	unsigned seq;
+	while ((seq = natomic32_load(&lock->sequence, NATOMIC_RELAXED)) & 1)
+		NATOMIC_PAUSE();
+
+	natomic_fence(NATOMIC_ACQUIRE);
+	return seq;
+}
+
+static inline bool nseqlock_read_retry(nseqlock_t *lock, unsigned seq)
+{
+	natomic_fence(NATOMIC_ACQUIRE);
+	return natomic32_load(&lock->sequence, NATOMIC_RELAXED) != seq;
+}
+
+static inline void nseqlock_write_lock(nseqlock_t *lock)
+{
+	NMUTEX_LOCK(lock->writer);
+
+	uint32_t seq = natomic32_load(&lock->sequence, NATOMIC_RELAXED);
+	natomic32_store(&lock->sequence, seq + 1, NATOMIC_RELAXED);
+	natomic_fence(NATOMIC_RELEASE);
+}
+
+static inline void nseqlock_write_unlock(nseqlock_t *lock)
+{
+	uint32_t seq = natomic32_load(&lock->sequence, NATOMIC_RELAXED);
+	natomic32_store(&lock->sequence, seq + 1, NATOMIC_RELEASE);
+
+	NMUTEX_UNLOCK(lock->writer);
+}
+
+#define NSEQLOCK nseqlock_t
+#define NSEQLOCK_INITIALIZER { 0, NMUTEX_INITIALIZER }
+
+#define NSEQLOCK_DEFINE(name) NSEQLOCK name = NSEQLOCK_INITIALIZER
+
+#define NSEQLOCK_INIT(nseqlock) nseqlock_init(&nseqlock)
+#define NSEQLOCK_READ_BEGIN(nseqlock) nseqlock_read_begin(&nseqlock)
+#define NSEQLOCK_READ_RETRY(nseqlock, seq) nseqlock_read_retry(&nseqlock, seq)
+#define NSEQLOCK_WRITE_LOCK(nseqlock) nseqlock_write_lock(&nseqlock)
+#define NSEQLOCK_WRITE_UNLOCK(nseqlock) nseqlock_write_unlock(&nseqlock)
+
+#ifdef NMUTEX_DESTROY
+#define NSEQLOCK_DESTROY(nseqlock) NMUTEX_DESTROY((nseqlock).writer)
+#endif // NMUTEX_DESTROY
+
+#endif // !MODULE
+#endif // !__NSEQLOCK_H__
@@ -0,0 +1,138 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nstrbuf.h
+ * @brief Neptune library - String builder.
+ *
+ * An `nstrbuf_t` accumulates a NUL-terminated string. Short strings live
+ * in a buffer inside the struct and never reach the heap; longer ones move
+ * to storage that grows geometrically through nvec_grow, so building a
+ * string piece by piece costs amortized O(1) per byte. Clearing keeps the
+ * capacity, so a builder reused across iterations stops allocating once
+ * it has seen its largest string.
+ *
+ * Always read the contents through `NSTRBUF_DATA`, the inline buffer is
+ * not referenced by pointer so builders can be copied while empty. A
+ * builder is not thread safe.
+ */
+
+#ifndef __NSTRBUF_H__
+#define __NSTRBUF_H__
+
+#include "nvec.h"
+
+// Bytes stored inside the struct, terminator included
+#ifndef NSTRBUF_SMALL_SIZE
+#define NSTRBUF_SMALL_SIZE 64
+#endif // !NSTRBUF_SMALL_SIZE
+
+struct nstrbuf {
+	char *data; // Heap storage, NULL while the string fits small
+	size_t length; // Bytes in use, terminator excluded
+	size_t capacity; // Bytes available, terminator included
+	char small[NSTRBUF_SMALL_SIZE];
+};
+
+typedef struct nstrbuf nstrbuf_t;
+
+// Empty builder, for static storage and declarations
+#define NSTRBUF_INIT { NULL, 0, NSTRBUF_SMALL_SIZE, { 0 } }
+
+// Current contents, always NUL-terminated
+#define NSTRBUF_DATA(sb) ((sb)->data != NULL ? (sb)->data : (sb)->small)
+#define NSTRBUF_LENGTH(sb) ((sb)->length)
+
+/**
+ * @brief Initialize an empty builder.
+ * @param sb Builder to initialize.
+ */
+NEPTUNE_API void nstrbuf_init(nstrbuf_t *sb);
+
+/**
+ * @brief Release the heap storage of a builder, leaving it empty.
+ * @param sb Builder to destroy.
+ */
+NEPTUNE_API void nstrbuf_destroy(nstrbuf_t *sb);
+
+/**
+ * @brief Empty a builder, keeping its capacity.
+ * @param sb Builder to clear.
+ */
+NEPTUNE_API void nstrbuf_clear(nstrbuf_t *sb);
+
+/**
+ * @brief Make room for a string of a given length.
+ * @param sb Builder to grow.
+ * @param length Length to hold, terminator excluded.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nstrbuf_reserve(nstrbuf_t *sb, size_t length);
+
+/**
+ * @brief Append bytes to a builder.
+ * @param sb Builder to append to.
+ * @param str Bytes to append, need not be NUL-terminated.
+ * @param length Number of bytes.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nstrbuf_append(nstrbuf_t *sb, const char *str,
+				    size_t length);
+
+/**
+ * @brief Append a NUL-terminated string to a builder.
+ * @param sb Builder to append to.
+ * @param str String to append.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nstrbuf_append_str(nstrbuf_t *sb, const char *str);
+
+/**
+ * @brief Append a single character to a builder.
+ * @param sb Builder to append to.
+ * @param c Character to append.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nstrbuf_append_char(nstrbuf_t *sb, char c);
+
+/**
+ * @brief Append formatted text, formatting in place when it fits.
+ * @param sb Builder to append to.
+ * @param format Format string (printf-style).
+ * @param list Arguments matching the format.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nstrbuf_vprintf(nstrbuf_t *sb, const char *format,
+				     va_list list);
+
+/**
+ * @brief Append formatted text, formatting in place when it fits.
+ * @param sb Builder to append to.
+ * @param format Format string (printf-style).
+ * @param ... Arguments matching the format.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nstrbuf_printf(nstrbuf_t *sb, const char *format, ...);
+
+#endif // !__NSTRBUF_H__
@@ -0,0 +1,143 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nthread.h
+ * @brief Neptune library - Thread pool.
+ *
+ * A fixed pool of workers shared by the whole library, so parallel code
+ * does not start threads of its own nor oversubscribe the cores. Each
+ * worker owns a Chase-Lev deque: tasks submitted by a worker go to its own
+ * deque and are popped back LIFO, idle workers steal FIFO from the others.
+ * Tasks submitted by other threads go through a shared lock-free queue.
+ *
+ * Tasks belong to a group that counts the unfinished ones, nthread_wait
+ * returns when the count drops to zero and runs queued tasks meanwhile,
+ * so tasks may submit and wait on groups of their own.
+ *
+ *     nthread_group_t group = NTHREAD_GROUP_INIT;
+ *     nthread_submit(&group, scan_file, path);
+ *     nthread_wait(&group);
+ *
+ * The pool is started by neptune_init when `NEPTUNE_ENABLE_NTHREAD` is
+ * defined. Without a pool, tasks run on the submitting thread. The kernel
+ * queues tasks on an unbound workqueue instead.
+ */
+
+#ifndef __NTHREAD_H__
+#define __NTHREAD_H__
+
+#include "neptune.h"
+#include "natomic.h"
+#include "nerror.h"
+
+#define NTHREAD_ERROR_S 0x6500
+
+#define NTHREAD_ALLOC_ERROR 0x6501
+#define NTHREAD_CREATE_ERROR 0x6502
+
+#define NTHREAD_ERROR_E NTHREAD_CREATE_ERROR
+
+// Workers started by nthread_init, 0 for one per online CPU
+#ifndef NTHREAD_WORKERS
+#define NTHREAD_WORKERS 0
+#endif // !NTHREAD_WORKERS
+
+#define NTHREAD_MAX_WORKERS 64
+
+// Tasks each deque holds, a power of two; a full deque runs tasks inline
+#ifndef NTHREAD_DEQUE_SIZE
+#define NTHREAD_DEQUE_SIZE 1024
+#endif // !NTHREAD_DEQUE_SIZE
+
+// Tasks queued by threads outside the pool, a full queue runs them inline
+#ifndef NTHREAD_QUEUE_SIZE
+#define NTHREAD_QUEUE_SIZE 4096
+#endif // !NTHREAD_QUEUE_SIZE
+
+typedef void (*nthread_fn)(void *ctx);
+
+typedef void (*nthread_range_fn)(void *ctx, size_t begin, size_t end);
+
+struct nthread_group {
+	natomic32_t pending; // Tasks submitted and not finished yet
+};
+
+typedef struct nthread_group nthread_group_t;
+
+#define NTHREAD_GROUP_INIT { NATOMIC32_INIT(0) }
+
+/**
+ * @brief Start the workers.
+ * @return Error code.
+ */
+NEPTUNE_API nerror_t nthread_init(void);
+
+/**
+ * @brief Stop the workers once every queued task has run.
+ */
+NEPTUNE_API void nthread_destroy(void);
+
+/**
+ * @brief Get the number of workers.
+ * @return Workers running, 0 without a pool.
+ */
+NEPTUNE_API size_t nthread_workers(void);
+
+/**
+ * @brief Queue a task.
+ *
+ * The task runs on the calling thread if there is no pool, the deque is
+ * full or the task cannot be allocated.
+ *
+ * @param group Group the task is counted in.
+ * @param fn Task function.
+ * @param ctx Argument of fn.
+ */
+NEPTUNE_API void nthread_submit(nthread_group_t *group, nthread_fn fn,
+				void *ctx);
+
+/**
+ * @brief Wait for every task of a group, running queued tasks meanwhile.
+ * @param group Group to wait on.
+ */
+NEPTUNE_API void nthread_wait(nthread_group_t *group);
+
+/**
+ * @brief Call fn over [begin, end) in chunks, spread over the workers.
+ *
+ * Chunks are handed out on demand, so uneven chunks balance themselves.
+ * The calling thread works on the range too and returns once every chunk
+ * is done.
+ *
+ * @param begin First index.
+ * @param end Index past the last one.
+ * @param grain Indexes per chunk, 0 to pick one from the worker count.
+ * @param fn Chunk function, called with a sub-range.
+ * @param ctx Argument of fn.
+ */
+NEPTUNE_API void nthread_parallel_for(size_t begin, size_t end, size_t grain,
+				      nthread_range_fn fn, void *ctx);
+
+#endif // !__NTHREAD_H__
@@ -69,6 +69,16 @@ NEPTUNE_API ntime_t ntime_get_unix(void);
  */
 NEPTUNE_API ntime_t ntime_get_elapsed(void);
 
+/**
+ * @brief Read a monotonic clock with nanosecond resolution.
+ *
+ * The origin is unspecified, only differences between two readings are
+ * meaningful. Unaffected by changes to the wall clock.
+ *
+ * @return Monotonic time in nanoseconds.
+ */
+NEPTUNE_API ntime_t ntime_get_nsec(void);
+
 /**
  * @brief Write the elapsed time as a human-readable string in "HH:MM:SS" format.
  *
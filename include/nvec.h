@@ -0,0 +1,143 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nvec.h
+ * @brief Neptune library - Type-safe growable vector.
+ *
+ * `NVEC_DEFINE(name, type)` declares `name_t`, a vector of `type`, along
+ * with inline functions prefixed with `name_` to manage it. Capacity grows
+ * geometrically, so appending n elements costs O(n) copies and O(log n)
+ * reallocations. A vector can start on a caller-owned buffer (typically on
+ * the stack) and only reaches the heap once it outgrows it.
+ *
+ * Storage comes from `N_ALLOC`/`N_REALLOC`, vectors behave the same in
+ * user and kernel mode. A vector is not thread safe.
+ */
+
+#ifndef __NVEC_H__
+#define __NVEC_H__
+
+#include "nmem.h"
+#include "nerror.h"
+
+// Capacity of the first heap block of an empty vector
+#define NVEC_MIN_CAPACITY 4
+
+/**
+ * @brief Move a vector's storage to a block of at least min_capacity.
+ * @param data Current storage, may be NULL or inline_data.
+ * @param inline_data Caller-owned first block that must not be freed.
+ * @param length Elements to keep.
+ * @param element_size Size of an element.
+ * @param capacity Current capacity, updated on success.
+ * @param min_capacity Capacity required.
+ * @return New storage, or NULL with data left intact.
+ */
+NEPTUNE_API void *nvec_grow(void *data, const void *inline_data,
+			    size_t length, size_t element_size,
+			    size_t *capacity, size_t min_capacity);
+
+/**
+ * @brief Release storage unless it is the caller-owned first block.
+ * @param data Storage to release, may be NULL.
+ * @param inline_data Caller-owned first block.
+ */
+NEPTUNE_API void nvec_release(void *data, const void *inline_data);
+
+#define NVEC_DEFINE(name, type)                                               \
+	struct name {                                                         \
+		type *data; /* Elements, length of them in use */             \
+		size_t length;                                                \
+		size_t capacity;                                              \
+		type *inline_data; /* Caller-owned first block, or NULL */    \
+	};                                                                    \
+                                                                              \
+	typedef struct name name##_t;                                         \
+                                                                              \
+	static inline void name##_init(name##_t *vec, type *buffer,           \
+				       size_t count)                          \
+	{                                                                     \
+		vec->data = buffer;                                           \
+		vec->length = 0;                                              \
+		vec->capacity = buffer != NULL ? count : 0;                   \
+		vec->inline_data = buffer;                                    \
+	}                                                                     \
+                                                                              \
+	static inline void name##_destroy(name##_t *vec)                      \
+	{                                                                     \
+		nvec_release(vec->data, vec->inline_data);                    \
+		name##_init(vec, NULL, 0);                                    \
+	}                                                                     \
+                                                                              \
+	static inline nerror_t name##_reserve(name##_t *vec, size_t count)    \
+	{                                                                     \
+		if (count <= vec->capacity)                                   \
+			return N_OK;                                          \
+                                                                              \
+		type *data = nvec_grow(vec->data, vec->inline_data,           \
+				       vec->length, sizeof(type),             \
+				       &vec->capacity, count);                \
+		if (data == NULL)                                             \
+			return GET_ERR(NMEM_ALLOC_ERROR);                     \
+                                                                              \
+		vec->data = data;                                             \
+		return N_OK;                                                  \
+	}                                                                     \
+                                                                              \
+	static inline type *name##_emplace(name##_t *vec)                     \
+	{                                                                     \
+		if (vec->length == vec->capacity &&                           \
+		    HAS_ERR(name##_reserve(vec, vec->length + 1)))            \
+			return NULL;                                          \
+                                                                              \
+		return &vec->data[vec->length++];                             \
+	}                                                                     \
+                                                                              \
+	static inline nerror_t name##_push(name##_t *vec, type value)         \
+	{                                                                     \
+		type *slot = name##_emplace(vec);                             \
+		if (slot == NULL)                                             \
+			return GET_ERR(NMEM_ALLOC_ERROR);                     \
+                                                                              \
+		*slot = value;                                                \
+		return N_OK;                                                  \
+	}
+
+// Empty vector without a first block, for static storage
+#define NVEC_INIT { NULL, 0, 0, NULL }
+
+// Starts a vector on a caller-owned array
+#define NVEC_INIT_INLINE(name, vec, array) \
+	name##_init(vec, array, sizeof(array) / sizeof(*(array)))
+
+#define NVEC_AT(vec, index) ((vec)->data[index])
+#define NVEC_LENGTH(vec) ((vec)->length)
+#define NVEC_CLEAR(vec) ((vec)->length = 0)
+
+// Iterates it over pointers to the elements of a vector
+#define NVEC_FOREACH(vec, it) \
+	for ((it) = (vec)->data; (it) < (vec)->data + (vec)->length; (it)++)
+
+#endif // !__NVEC_H__
@@ -0,0 +1,165 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file nwait.h
+ * @brief Neptune library - Waiting on addresses, events and conditions.
+ *
+ * nwait_on_address blocks while a 32-bit word holds an expected value,
+ * until nwake or nwake_all is called on the same address. The check and
+ * the sleep are atomic, so a wake after the value changed is never lost.
+ * Waits may also return spuriously, callers re-check in a loop:
+ *
+ *     uint32_t value;
+ *     while ((value = natomic32_load(&word, NATOMIC_ACQUIRE)) == BUSY)
+ *             nwait_on_address(&word, value);
+ *
+ * Linux uses futexes, Windows WaitOnAddress, the kernel wait_var_event
+ * and other POSIX systems a hashed table of condition variables. Waking
+ * an address nobody waits on is cheap, waking one whose memory was freed
+ * meanwhile is harmless.
+ *
+ * On top of it:
+ * - `NEVENT`: a manual-reset event, set wakes every waiter until reset.
+ * - `NCOND`: a condition variable used with an `NMUTEX`.
+ */
+
+#ifndef __NWAIT_H__
+#define __NWAIT_H__
+
+#include "neptune.h"
+#include "natomic.h"
+#include "nmutex.h"
+
+/**
+ * @brief Block while *address equals expected.
+ * @param address Word to watch.
+ * @param expected Value to sleep on, returns at once if it differs.
+ */
+NEPTUNE_API void nwait_on_address(natomic32_t *address, uint32_t expected);
+
+/**
+ * @brief Wake one thread waiting on an address.
+ * @param address Watched word.
+ */
+NEPTUNE_API void nwake(natomic32_t *address);
+
+/**
+ * @brief Wake every thread waiting on an address.
+ * @param address Watched word.
+ */
+NEPTUNE_API void nwake_all(natomic32_t *address);
+
+struct nevent {
+	natomic32_t state; // 0 reset, 1 set, 2 reset with waiters
+};
+
+typedef struct nevent nevent_t;
+
+#define NEVENT_INITIALIZER { NATOMIC32_INIT(0) }
+
+/**
+ * @brief Set an event and wake its waiters.
+ * @param event Event.
+ */
+NEPTUNE_API void nevent_set(nevent_t *event);
+
+/**
+ * @brief Reset a set event, later waits block until the next set.
+ * @param event Event.
+ */
+NEPTUNE_API void nevent_reset(nevent_t *event);
+
+/**
+ * @brief Block until an event is set.
+ * @param event Event.
+ */
+NEPTUNE_API void nevent_wait(nevent_t *event);
+
+static inline bool nevent_is_set(nevent_t *event)
+{
+	return natomic32_load(&event->state, NATOMIC_ACQUIRE) == 1;
+}
+
+#define NEVENT nevent_t
+
+#define NEVENT_DEFINE(name) NEVENT name = NEVENT_INITIALIZER
+
+#define NEVENT_INIT(nevent) \
+	natomic32_store(&(nevent).state, 0, NATOMIC_RELAXED)
+#define NEVENT_SET(nevent) nevent_set(&nevent)
+#define NEVENT_RESET(nevent) nevent_reset(&nevent)
+#define NEVENT_WAIT(nevent) nevent_wait(&nevent)
+#define NEVENT_IS_SET(nevent) nevent_is_set(&nevent)
+
+struct ncond {
+	natomic32_t sequence; // Bumped by every signal
+	natomic32_t waiters; // Threads between prepare and wake up
+};
+
+typedef struct ncond ncond_t;
+
+#define NCOND_INITIALIZER { NATOMIC32_INIT(0), NATOMIC32_INIT(0) }
+
+// Called with the mutex held, returns the sequence to sleep on
+NEPTUNE_API uint32_t ncond_prepare(ncond_t *cond);
+
+// Called after releasing the mutex
+NEPTUNE_API void ncond_park(ncond_t *cond, uint32_t sequence);
+
+/**
+ * @brief Wake at least one waiter of a condition, if any.
+ * @param cond Condition.
+ */
+NEPTUNE_API void ncond_signal(ncond_t *cond);
+
+/**
+ * @brief Wake every waiter of a condition.
+ * @param cond Condition.
+ */
+NEPTUNE_API void ncond_broadcast(ncond_t *cond);
+
+#define NCOND ncond_t
+
+#define NCOND_DEFINE(name) NCOND name = NCOND_INITIALIZER
+
+#define NCOND_INIT(ncond)                                            \
+	do {                                                         \
+		natomic32_store(&(ncond).sequence, 0, NATOMIC_RELAXED); \
+		natomic32_store(&(ncond).waiters, 0, NATOMIC_RELAXED);  \
+	} while (0)
+
+// Releases nmutex while asleep; wake ups may be spurious, check in a loop
+#define NCOND_WAIT(ncond, nmutex)                              \
+	do {                                                   \
+		uint32_t ncond_seq = ncond_prepare(&(ncond));  \
+		NMUTEX_UNLOCK(nmutex);                         \
+		ncond_park(&(ncond), ncond_seq);               \
+		NMUTEX_LOCK(nmutex);                           \
+	} while (0)
+
+#define NCOND_SIGNAL(ncond) ncond_signal(&(ncond))
+#define NCOND_BROADCAST(ncond) ncond_broadcast(&(ncond))
+
+#endif // !__NWAIT_H__
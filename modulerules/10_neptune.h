@@ -24,12 +24,23 @@
 
 #include "neptune.h"
 #include "ntime.h"
+#include "nfile.h"
 #include "log.h"
+#include "nthread.h"
 
 #ifdef __NTIME_H__
 NEPTUNE_MODULE_INIT(ntime_init)
 #endif /* ifdef __NTIME_H__ */
 
+#ifdef NFILE_STAT_CACHE_SIZE
+NEPTUNE_MODULE_INIT(nfile_init)
+#endif /* ifdef NFILE_STAT_CACHE_SIZE */
+
 #ifdef __LOG_H__
 NEPTUNE_MODULE_INIT(log_init)
 #endif /* ifdef __LOG_H__ */
+
+// Last, tasks may use everything above
+#ifdef NEPTUNE_ENABLE_NTHREAD
+NEPTUNE_MODULE_INIT(nthread_init)
+#endif /* ifdef NEPTUNE_ENABLE_NTHREAD */
@@ -23,8 +23,30 @@
  */
 
 #include "neptune.h"
+#include "nfile.h"
 #include "log.h"
+#include "nmem.h"
+#include "nmutex.h"
+#include "nthread.h"
+
+// First, queued tasks may still use any module
+#ifdef NEPTUNE_ENABLE_NTHREAD
+NEPTUNE_MODULE_DESTROY(nthread_destroy)
+#endif /* ifdef NEPTUNE_ENABLE_NTHREAD */
+
+// Reports before the log goes away
+#if defined(NMEM_TRACE) && !defined(MODULE)
+NEPTUNE_MODULE_DESTROY(nmem_trace_destroy)
+#endif /* if defined(NMEM_TRACE) && !defined(MODULE) */
+
+#if defined(NMUTEX_PROFILE) && !defined(MODULE)
+NEPTUNE_MODULE_DESTROY(nmutex_profile_destroy)
+#endif /* if defined(NMUTEX_PROFILE) && !defined(MODULE) */
 
 #ifdef __LOG_H__
 NEPTUNE_MODULE_DESTROY(log_destroy)
 #endif
+
+#ifdef NFILE_STAT_CACHE_SIZE
+NEPTUNE_MODULE_DESTROY(nfile_destroy)
+#endif /* ifdef NFILE_STAT_CACHE_SIZE */
@@ -30,11 +30,13 @@
 #include "nmutex.h"
 #include "ntime.h"
 #include "nmem.h"
+#include "nvec.h"
 
-static log_file_t *log_files = NULL;
-static size_t log_file_count = 0;
+NVEC_DEFINE(log_file_vec, log_file_t)
 
-static NMUTEX log_mutex;
+static log_file_vec_t log_files = NVEC_INIT;
+
+static NMUTEX_DEFINE(log_mutex);
 
 LOG_API nerror_t log_init()
 {
@@ -77,19 +79,17 @@ LOG_API nerror_t log_init()
 
 LOG_API void log_destroy()
 {
-	if (log_files != NULL) {
-		while (log_file_count > 0) {
-			log_file_count--;
-			log_file_t *lf = log_files + log_file_count;
-			if (lf == NULL || lf->file != NULL)
-				continue;
-
-			if ((lf->file_flags & LOG_FILE_DONT_CLOSE) == 0)
-				NFILE_CLOSE(lf->file);
-		}
+	while (log_files.length > 0) {
+		log_files.length--;
+		log_file_t *lf = log_files.data + log_files.length;
+		if (lf == NULL || lf->file != NULL)
+			continue;
+
+		if ((lf->file_flags & LOG_FILE_DONT_CLOSE) == 0)
+			NFILE_CLOSE(lf->file);
 	}
 
-	log_files = NULL;
+	log_file_vec_destroy(&log_files);
 #ifdef NMUTEX_DESTROY
 	NMUTEX_DESTROY(log_mutex);
 #endif /* ifdef NMUTEX_DESTROY */
@@ -101,8 +101,8 @@ LOG_API void log_set_color(color_t color)
 		return;
 
 	size_t i;
-	for (i = 0; i < log_file_count; i++) {
-		log_file_t *lf = log_files + i;
+	for (i = 0; i < log_files.length; i++) {
+		log_file_t *lf = log_files.data + i;
 		if ((lf->file_flags & LOG_FILE_COLORABLE) != 0)
 			NFILE_WRITE(lf->file, color, strlen(color));
 	}
@@ -112,18 +112,14 @@ LOG_API nerror_t log_reg_file_ex(nfile_t file, log_file_flags_t file_flags)
 {
 	NMUTEX_LOCK(log_mutex);
 
-	size_t ns = log_file_count + 1;
-	void *ptr = N_REALLOC(log_files, ns * sizeof(log_file_t));
-
-	if (ptr == NULL)
+	log_file_t *nf = log_file_vec_emplace(&log_files);
+	if (nf == NULL) {
+		NMUTEX_UNLOCK(log_mutex);
 		return GET_ERR(LOG_REALLOC_ERROR);
-
-	log_files = ptr;
-	log_file_t *nf = log_files + log_file_count;
+	}
 
 	nf->file = file;
 	nf->file_flags = file_flags;
-	log_file_count++;
 
 	NMUTEX_UNLOCK(log_mutex);
 	return N_OK;
@@ -151,8 +147,8 @@ static void log_paw_v(log_file_flags_t log_class, const char *format,
 		format = "(null)";
 
 	size_t i;
-	for (i = 0; i < log_file_count; i++) {
-		log_file_t *lf = log_files + i;
+	for (i = 0; i < log_files.length; i++) {
+		log_file_t *lf = log_files.data + i;
 
 		va_list args_copy;
 		va_copy(args_copy, list);
@@ -189,7 +185,7 @@ static void log_paw(log_file_flags_t log_class, const char *format, ...)
 
 LOG_API bool log_can_out()
 {
-	return log_file_count > 0;
+	return log_files.length > 0;
 }
 
 LOG_API nerror_t log_log_v(color_t color, const char *type, const char *format,
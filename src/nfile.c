@@ -22,23 +22,297 @@
  * SOFTWARE.
  */
 
+#if !defined(MODULE) && !defined(_WIN32)
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
 #include "nfile.h"
 
 #ifdef MODULE
 #include <linux/uaccess.h>
-#endif /* ifdef MODULE */
+#include <linux/fadvise.h>
+#include <linux/falloc.h>
+#include <linux/namei.h>
+#include <linux/net.h>
+#include <linux/stat.h>
+#else /* ifndef MODULE */
+
+#ifdef _WIN32
+
+#include <io.h>
+
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif /* ifdef _MSC_VER */
+
+#else /* ifndef _WIN32 */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio_ext.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* ifndef _WIN32 */
+
+#endif /* ifndef MODULE */
+
+#ifndef SSIZE_MAX
+#define SSIZE_MAX ((ssize_t)(SIZE_MAX >> 1))
+#endif /* ifndef SSIZE_MAX */
 
 #if !defined(NFILE_DISABLE) || NFILE_DISABLE != 1
 
+#ifdef NFILE_STAT_CACHE_SIZE
+
+#include "nmutex.h"
+
+#if (NFILE_STAT_CACHE_SIZE & (NFILE_STAT_CACHE_SIZE - 1)) != 0
+#error "NFILE_STAT_CACHE_SIZE must be a power of two"
+#endif /* if (NFILE_STAT_CACHE_SIZE & (NFILE_STAT_CACHE_SIZE - 1)) != 0 */
+
+struct nfile_stat_slot {
+	nfile_t file;
+	size_t gen; // Bumped by every invalidation hashing to this slot
+	nfile_stat_t stat;
+};
+
+static struct nfile_stat_slot nfile_stat_cache[NFILE_STAT_CACHE_SIZE];
+static NMUTEX_DEFINE(nfile_stat_mutex);
+
+static struct nfile_stat_slot *nfile_stat_get_slot(nfile_t nfile)
+{
+	size_t h = (size_t)nfile;
+	h ^= h >> 12;
+	h ^= h >> 4;
+
+	return nfile_stat_cache + (h & (NFILE_STAT_CACHE_SIZE - 1));
+}
+
+NFILE_API nerror_t nfile_init(void)
+{
+	NMUTEX_INIT(nfile_stat_mutex);
+	return N_OK;
+}
+
+NFILE_API void nfile_destroy(void)
+{
+	memset(nfile_stat_cache, 0, sizeof(nfile_stat_cache));
+#ifdef NMUTEX_DESTROY
+	NMUTEX_DESTROY(nfile_stat_mutex);
+#endif /* ifdef NMUTEX_DESTROY */
+}
+
+NFILE_API void nfile_stat_invalidate(nfile_t nfile)
+{
+	struct nfile_stat_slot *slot = nfile_stat_get_slot(nfile);
+
+	NMUTEX_LOCK(nfile_stat_mutex);
+	++slot->gen;
+	if (slot->file == nfile)
+		slot->file = NULL;
+	NMUTEX_UNLOCK(nfile_stat_mutex);
+}
+
+#ifndef MODULE
+
+NFILE_API void nfile_close(nfile_t nfile)
+{
+	nfile_stat_invalidate(nfile);
+	fclose(nfile);
+}
+
+#endif /* ifndef MODULE */
+#endif /* ifdef NFILE_STAT_CACHE_SIZE */
+
 #ifdef MODULE
 
 NFILE_API void nfile_close(nfile_t nfile)
 {
+	NFILE_STAT_INVALIDATE(nfile);
 	filp_close(nfile, NULL);
 }
 
 #endif /* ifdef MODULE */
 
+NFILE_API nfile_handle_t nfile_get_handle(nfile_t nfile)
+{
+#ifdef MODULE
+	return nfile;
+#else /* ifndef MODULE */
+
+#ifdef _WIN32
+	fflush(nfile);
+	return (HANDLE)_get_osfhandle(_fileno(nfile));
+#else /* ifndef _WIN32 */
+
+	// Only push pending output; flushing an input stream drops its buffer
+	if (__fpending(nfile) > 0)
+		fflush(nfile);
+
+	return fileno(nfile);
+
+#endif /* ifndef _WIN32 */
+
+#endif /* ifndef MODULE */
+}
+
+#ifdef MODULE
+
+static void nfile_stat_from_kstat(nfile_stat_t *stat, const struct kstat *ks)
+{
+	stat->size = (uint64_t)ks->size;
+	stat->inode = (uint64_t)ks->ino;
+	stat->block_size = (uint32_t)ks->blksize;
+	stat->mtime = (ntime_t)ks->mtime.tv_sec;
+	stat->mtime_nsec = (uint32_t)ks->mtime.tv_nsec;
+}
+
+#elif defined(_WIN32)
+
+static nerror_t nfile_stat_from_handle(HANDLE handle, nfile_stat_t *stat)
+{
+	BY_HANDLE_FILE_INFORMATION info;
+	if (handle == INVALID_HANDLE_VALUE ||
+	    !GetFileInformationByHandle(handle, &info))
+		return GET_ERR(NFILE_STAT_ERROR);
+
+	// FILETIME counts 100ns intervals since 1601-01-01
+	uint64_t ft = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) |
+		      info.ftLastWriteTime.dwLowDateTime;
+	ft -= 116444736000000000ULL;
+
+	stat->size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	stat->inode = ((uint64_t)info.nFileIndexHigh << 32) |
+		      info.nFileIndexLow;
+	stat->block_size = 4096;
+	stat->mtime = (ntime_t)(ft / 10000000);
+	stat->mtime_nsec = (uint32_t)(ft % 10000000) * 100;
+
+	return N_OK;
+}
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+static void nfile_stat_from_st(nfile_stat_t *stat, const struct stat *st)
+{
+	stat->size = (uint64_t)st->st_size;
+	stat->inode = (uint64_t)st->st_ino;
+	stat->block_size = (uint32_t)st->st_blksize;
+	stat->mtime = (ntime_t)st->st_mtim.tv_sec;
+	stat->mtime_nsec = (uint32_t)st->st_mtim.tv_nsec;
+}
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+static nerror_t nfile_stat_raw(nfile_t nfile, nfile_stat_t *stat)
+{
+#ifdef MODULE
+
+	struct kstat ks;
+	if (vfs_getattr(&nfile->f_path, &ks, STATX_BASIC_STATS,
+			AT_STATX_SYNC_AS_STAT) != 0)
+		return GET_ERR(NFILE_STAT_ERROR);
+
+	nfile_stat_from_kstat(stat, &ks);
+
+#elif defined(_WIN32)
+
+	RET_ERR(nfile_stat_from_handle(nfile_get_handle(nfile), stat));
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	struct stat st;
+	if (fstat(nfile_get_handle(nfile), &st) != 0)
+		return GET_ERR(NFILE_STAT_ERROR);
+
+	nfile_stat_from_st(stat, &st);
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_stat_path(const nfile_path_t path, nfile_stat_t *out)
+{
+#ifdef MODULE
+
+	struct path kpath;
+	if (kern_path(path, LOOKUP_FOLLOW, &kpath) != 0)
+		return GET_ERR(NFILE_STAT_ERROR);
+
+	struct kstat ks;
+	int ret = vfs_getattr(&kpath, &ks, STATX_BASIC_STATS,
+			      AT_STATX_SYNC_AS_STAT);
+	path_put(&kpath);
+
+	if (ret != 0)
+		return GET_ERR(NFILE_STAT_ERROR);
+
+	nfile_stat_from_kstat(out, &ks);
+
+#elif defined(_WIN32)
+
+	HANDLE handle = CreateFileW(path, 0,
+				    FILE_SHARE_READ | FILE_SHARE_WRITE |
+					    FILE_SHARE_DELETE,
+				    NULL, OPEN_EXISTING,
+				    FILE_FLAG_BACKUP_SEMANTICS, NULL);
+
+	nerror_t error = nfile_stat_from_handle(handle, out);
+	if (handle != INVALID_HANDLE_VALUE)
+		CloseHandle(handle);
+
+	RET_ERR(error);
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return GET_ERR(NFILE_STAT_ERROR);
+
+	nfile_stat_from_st(out, &st);
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_stat(nfile_t nfile, nfile_stat_t *stat)
+{
+#ifdef NFILE_STAT_CACHE_SIZE
+
+	struct nfile_stat_slot *slot = nfile_stat_get_slot(nfile);
+
+	NMUTEX_LOCK(nfile_stat_mutex);
+	if (slot->file == nfile) {
+		*stat = slot->stat;
+		NMUTEX_UNLOCK(nfile_stat_mutex);
+		return N_OK;
+	}
+	size_t gen = slot->gen;
+	NMUTEX_UNLOCK(nfile_stat_mutex);
+
+	RET_ERR(nfile_stat_raw(nfile, stat));
+
+	// A write finished while we were querying; the result may predate it
+	NMUTEX_LOCK(nfile_stat_mutex);
+	if (slot->gen == gen) {
+		slot->file = nfile;
+		slot->stat = *stat;
+	}
+	NMUTEX_UNLOCK(nfile_stat_mutex);
+
+	return N_OK;
+
+#else /* ifndef NFILE_STAT_CACHE_SIZE */
+	return nfile_stat_raw(nfile, stat);
+#endif /* ifndef NFILE_STAT_CACHE_SIZE */
+}
+
 NFILE_API void nfile_delete(const nfile_path_t path)
 {
 #ifdef _WIN32
@@ -58,18 +332,72 @@ NFILE_API ssize_t nfile_get_length(nfile_t nfile)
 
 #else /* ifndef MODULE */
 
-	long cur_pos = ftell(nfile);
-	if (fseek(nfile, 0, SEEK_END) != 0)
+	nfile_stat_t stat = { 0 };
+	if (HAS_ERR(nfile_stat(nfile, &stat)))
 		return 0;
 
-	long ret = ftell(nfile);
-	fseek(nfile, cur_pos, SEEK_SET);
-
-	return ret;
+	return (ssize_t)stat.size;
 
 #endif /* ifndef MODULE */
 }
 
+static int nfile_advice_to_os(nfile_advice_t advice)
+{
+	switch (advice) {
+#ifndef _WIN32
+	case NFILE_ADVICE_SEQUENTIAL:
+		return POSIX_FADV_SEQUENTIAL;
+	case NFILE_ADVICE_RANDOM:
+		return POSIX_FADV_RANDOM;
+	case NFILE_ADVICE_WILLNEED:
+		return POSIX_FADV_WILLNEED;
+	case NFILE_ADVICE_DONTNEED:
+		return POSIX_FADV_DONTNEED;
+	default:
+		return POSIX_FADV_NORMAL;
+#else /* ifdef _WIN32 */
+	default:
+		return 0;
+#endif /* ifdef _WIN32 */
+	}
+}
+
+NFILE_API nerror_t nfile_advise(nfile_t nfile, ssize_t offset, ssize_t length,
+				nfile_advice_t advice)
+{
+#ifdef MODULE
+
+	if (vfs_fadvise(nfile, (loff_t)offset, (loff_t)length,
+			nfile_advice_to_os(advice)) != 0)
+		return GET_ERR(NFILE_ADVISE_ERROR);
+
+#elif !defined(_WIN32)
+
+	if (posix_fadvise(nfile_get_handle(nfile), (off_t)offset,
+			  (off_t)length, nfile_advice_to_os(advice)) != 0)
+		return GET_ERR(NFILE_ADVISE_ERROR);
+
+#endif /* if !defined(_WIN32) */
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_readahead(nfile_t nfile, ssize_t offset,
+				   ssize_t length)
+{
+#if !defined(MODULE) && !defined(_WIN32)
+
+	if (readahead(nfile_get_handle(nfile), (off64_t)offset,
+		      (size_t)length) != 0)
+		return GET_ERR(NFILE_ADVISE_ERROR);
+
+	return N_OK;
+
+#else /* if defined(MODULE) || defined(_WIN32) */
+	return nfile_advise(nfile, offset, length, NFILE_ADVICE_WILLNEED);
+#endif /* if defined(MODULE) || defined(_WIN32) */
+}
+
 #if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
 
 NFILE_API nfile_t nfile_open_r(const nfile_path_t pathname)
@@ -87,19 +415,55 @@ NFILE_API nfile_t nfile_open_r(const nfile_path_t pathname)
 #endif /* ifndef MODULE */
 }
 
-NFILE_API ssize_t nfile_read_o(nfile_t nfile, ssize_t offset, void *buffer,
-			       ssize_t length)
+static ssize_t nfile_handle_read(nfile_handle_t raw, void *buffer,
+				 size_t length, uint64_t offset, bool seekable)
 {
 #ifdef MODULE
-	return kernel_read(nfile, buffer, length, (loff_t *)&offset);
-#else /* ifndef MODULE */
 
-	if (fseek(nfile, (long)offset, SEEK_SET) == 0)
-		return 0;
+	loff_t pos = (loff_t)offset;
+	ssize_t ret = kernel_read(raw, buffer, length, &pos);
 
-	return fread(buffer, 1, length, nfile);
+	return ret < 0 ? -1 : ret;
 
-#endif /* ifndef MODULE */
+#elif defined(_WIN32)
+
+	DWORD done;
+	OVERLAPPED ov = { 0 };
+	ov.Offset = (DWORD)offset;
+	ov.OffsetHigh = (DWORD)(offset >> 32);
+
+	if (length > MAXDWORD)
+		length = MAXDWORD;
+
+	if (!ReadFile(raw, buffer, (DWORD)length, &done, seekable ? &ov : NULL))
+		return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+
+	return (ssize_t)done;
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	ssize_t ret;
+	do {
+		if (seekable)
+			ret = pread(raw, buffer, length, (off_t)offset);
+		else
+			ret = read(raw, buffer, length);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret;
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+}
+
+NFILE_API ssize_t nfile_read_o(nfile_t nfile, ssize_t offset, void *buffer,
+			       ssize_t length)
+{
+	if (offset < 0 || length < 0)
+		return -1;
+
+	// Positional read on the handle, the stream position is not used
+	return nfile_handle_read(nfile_get_handle(nfile), buffer,
+				 (size_t)length, (uint64_t)offset, true);
 }
 
 NFILE_API ssize_t nfile_read(nfile_t nfile, void *buffer, ssize_t length)
@@ -111,6 +475,190 @@ NFILE_API ssize_t nfile_read(nfile_t nfile, void *buffer, ssize_t length)
 #endif /* infdef MODULE */
 }
 
+static nerror_t nfile_read_all_known(nfile_handle_t raw,
+				     const nmem_allocator_t *allocator,
+				     uint64_t size, nfile_data_t *out)
+{
+	if (size > (uint64_t)SSIZE_MAX)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	int8_t *buffer = NMEM_ALLOCATOR_ALLOC(allocator, (size_t)size);
+	if (buffer == NULL)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	size_t done = 0;
+	while (done < size) {
+		ssize_t ret = nfile_handle_read(raw, buffer + done, size - done,
+						done, true);
+		if (ret < 0) {
+			NMEM_ALLOCATOR_FREE(allocator, buffer);
+			return GET_ERR(NFILE_READ_ERROR);
+		}
+
+		// File shrank since it was measured
+		if (ret == 0)
+			break;
+
+		done += ret;
+	}
+
+	out->data = buffer;
+	out->size = done;
+	out->mapped = false;
+	return N_OK;
+}
+
+static nerror_t nfile_read_all_unknown(nfile_handle_t raw,
+				       const nmem_allocator_t *allocator,
+				       bool seekable, nfile_data_t *out)
+{
+	size_t capacity = NFILE_READ_ALL_CHUNK_SIZE;
+	int8_t *buffer = NMEM_ALLOCATOR_ALLOC(allocator, capacity);
+	if (buffer == NULL)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	size_t size = 0;
+	while (true) {
+		if (size == capacity) {
+			size_t new_capacity = capacity * 2;
+			int8_t *new_buffer =
+				NMEM_ALLOCATOR_ALLOC(allocator, new_capacity);
+			if (new_buffer == NULL) {
+				NMEM_ALLOCATOR_FREE(allocator, buffer);
+				return GET_ERR(NFILE_ALLOC_ERROR);
+			}
+
+			memcpy(new_buffer, buffer, size);
+			NMEM_ALLOCATOR_FREE(allocator, buffer);
+
+			buffer = new_buffer;
+			capacity = new_capacity;
+		}
+
+		ssize_t ret = nfile_handle_read(raw, buffer + size,
+						capacity - size, size,
+						seekable);
+		if (ret < 0) {
+			NMEM_ALLOCATOR_FREE(allocator, buffer);
+			return GET_ERR(NFILE_READ_ERROR);
+		}
+
+		if (ret == 0)
+			break;
+
+		size += ret;
+	}
+
+	out->data = buffer;
+	out->size = size;
+	out->mapped = false;
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_read_all(const nfile_path_t path,
+				  const nmem_allocator_t *allocator,
+				  nfile_data_t *out)
+{
+	nerror_t error;
+	uint64_t size = 0;
+	bool regular;
+
+#ifdef MODULE
+
+	nfile_handle_t raw = filp_open(path, O_RDONLY, 0);
+	if (IS_ERR(raw))
+		return GET_ERR(NFILE_OPEN_ERROR);
+
+	struct inode *inode = file_inode(raw);
+	regular = S_ISREG(inode->i_mode);
+	if (regular)
+		size = (uint64_t)i_size_read(inode);
+
+#elif defined(_WIN32)
+
+	nfile_handle_t raw = CreateFileW(path, GENERIC_READ,
+					 FILE_SHARE_READ | FILE_SHARE_WRITE,
+					 NULL, OPEN_EXISTING,
+					 FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (raw == INVALID_HANDLE_VALUE)
+		return GET_ERR(NFILE_OPEN_ERROR);
+
+	LARGE_INTEGER li;
+	regular = GetFileType(raw) == FILE_TYPE_DISK;
+	if (regular && GetFileSizeEx(raw, &li))
+		size = (uint64_t)li.QuadPart;
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	nfile_handle_t raw = open(path, O_RDONLY | O_CLOEXEC);
+	if (raw < 0)
+		return GET_ERR(NFILE_OPEN_ERROR);
+
+	struct stat st;
+	if (fstat(raw, &st) != 0) {
+		close(raw);
+		return GET_ERR(NFILE_STAT_ERROR);
+	}
+
+	regular = S_ISREG(st.st_mode);
+	if (regular)
+		size = (uint64_t)st.st_size;
+
+#if NFILE_READ_ALL_MAP_SIZE > 0
+	if (regular && size >= NFILE_READ_ALL_MAP_SIZE &&
+	    size <= (uint64_t)SSIZE_MAX) {
+		void *map = mmap(NULL, (size_t)size, PROT_READ,
+				 MAP_PRIVATE | MAP_POPULATE, raw, 0);
+		if (map != MAP_FAILED) {
+			close(raw);
+
+			out->data = map;
+			out->size = (size_t)size;
+			out->mapped = true;
+			return N_OK;
+		}
+	}
+#endif /* if NFILE_READ_ALL_MAP_SIZE > 0 */
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	// procfs and sysfs files report zero or a placeholder size
+	if (size > 0)
+		error = nfile_read_all_known(raw, allocator, size, out);
+	else
+		error = nfile_read_all_unknown(raw, allocator, regular, out);
+
+#ifdef MODULE
+	filp_close(raw, NULL);
+#elif defined(_WIN32)
+	CloseHandle(raw);
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+	close(raw);
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	return error;
+}
+
+NFILE_API void nfile_data_release(nfile_data_t *data,
+				  const nmem_allocator_t *allocator)
+{
+	if (data->data == NULL)
+		return;
+
+#if !defined(MODULE) && !defined(_WIN32)
+	if (data->mapped)
+		munmap(data->data, data->size);
+	else
+		NMEM_ALLOCATOR_FREE(allocator, data->data);
+#else /* if defined(MODULE) || defined(_WIN32) */
+	NMEM_ALLOCATOR_FREE(allocator, data->data);
+#endif /* if defined(MODULE) || defined(_WIN32) */
+
+	data->data = NULL;
+	data->size = 0;
+	data->mapped = false;
+}
+
 #endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
 
 #if !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
@@ -130,6 +678,44 @@ NFILE_API nfile_t nfile_open_w(const nfile_path_t pathname)
 #endif /* ifndef MODULE */
 }
 
+NFILE_API nfile_t nfile_open_a(const nfile_path_t pathname)
+{
+#ifdef MODULE
+	return filp_open(pathname, O_WRONLY | O_CREAT | O_APPEND, 0644);
+#else /* ifndef MODULE */
+
+#ifdef _WIN32
+	return _wfopen(pathname, L"ab");
+#else /* ifndef _WIN32 */
+	return fopen(pathname, "ab");
+#endif /* ifndef _WIN32 */
+
+#endif /* ifndef MODULE */
+}
+
+NFILE_API nerror_t nfile_sync(nfile_t nfile, bool data_only)
+{
+#ifdef MODULE
+
+	if (vfs_fsync(nfile, data_only ? 1 : 0) != 0)
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#elif defined(_WIN32)
+
+	if (!FlushFileBuffers(nfile_get_handle(nfile)))
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	int fd = nfile_get_handle(nfile);
+	if ((data_only ? fdatasync(fd) : fsync(fd)) != 0)
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	return N_OK;
+}
+
 NFILE_API ssize_t nfile_write_o(nfile_t nfile, ssize_t offset,
 				const void *buffer, ssize_t length)
 {
@@ -137,15 +723,17 @@ NFILE_API ssize_t nfile_write_o(nfile_t nfile, ssize_t offset,
 	size_t ret = kernel_write(nfile, buffer, length, (loff_t *)&offset);
 
 	nfile->f_pos = offset;
-	return ret;
 #else /* ifndef MODULE */
 
 	if (fseek(nfile, (long)offset, SEEK_SET) != 0)
 		return 0;
 
-	return fwrite(buffer, 1, length, nfile);
+	ssize_t ret = fwrite(buffer, 1, length, nfile);
 
 #endif /* ifndef MODULE */
+
+	NFILE_STAT_INVALIDATE(nfile);
+	return ret;
 }
 
 NFILE_API ssize_t nfile_write(nfile_t nfile, const void *buffer, ssize_t length)
@@ -153,7 +741,10 @@ NFILE_API ssize_t nfile_write(nfile_t nfile, const void *buffer, ssize_t length)
 #ifdef MODULE
 	return nfile_write_o(nfile, nfile->f_pos, buffer, length);
 #else /* ifndef MODULE */
-	return fwrite(buffer, 1, length, nfile);
+	ssize_t ret = fwrite(buffer, 1, length, nfile);
+
+	NFILE_STAT_INVALIDATE(nfile);
+	return ret;
 #endif /* infdef MODULE */
 }
 
@@ -172,7 +763,10 @@ NFILE_API ssize_t nfile_printf_ov(nfile_t nfile, ssize_t offset,
 	if (fseek(nfile, (long)offset, SEEK_SET) != 0)
 		return 0;
 
-	return vfprintf(nfile, format, args);
+	ssize_t ret = vfprintf(nfile, format, args);
+
+	NFILE_STAT_INVALIDATE(nfile);
+	return ret;
 
 #endif /* ifndef MODULE */
 }
@@ -187,11 +781,15 @@ NFILE_API ssize_t nfile_printf_o(nfile_t nfile, ssize_t offset,
 	ssize_t ret = nfile_printf_ov(nfile, offset, format, args);
 #else /* ifndef MODULE */
 
-	if (fseek(nfile, (long)offset, SEEK_SET) != 0)
+	if (fseek(nfile, (long)offset, SEEK_SET) != 0) {
+		va_end(args);
 		return 0;
+	}
 
 	ssize_t ret = vfprintf(nfile, format, args);
 
+	NFILE_STAT_INVALIDATE(nfile);
+
 #endif /* ifndef MODULE */
 
 	va_end(args);
@@ -204,7 +802,10 @@ NFILE_API ssize_t nfile_printf_v(nfile_t nfile, const char *format,
 #ifdef MODULE
 	return nfile_printf_ov(nfile, nfile->f_pos, format, args);
 #else /* ifndef MODULE */
-	return vfprintf(nfile, format, args);
+	ssize_t ret = vfprintf(nfile, format, args);
+
+	NFILE_STAT_INVALIDATE(nfile);
+	return ret;
 #endif /* ifndef MODULE */
 }
 
@@ -217,12 +818,77 @@ NFILE_API ssize_t nfile_printf(nfile_t nfile, const char *format, ...)
 	ssize_t ret = nfile_printf_v(nfile, format, args);
 #else /* ifndef MODULE */
 	ssize_t ret = vfprintf(nfile, format, args);
+
+	NFILE_STAT_INVALIDATE(nfile);
 #endif /* ifndef MODULE */
 
 	va_end(args);
 	return ret;
 }
 
+static nerror_t nfile_prealloc_raw(nfile_t nfile, ssize_t offset,
+				   ssize_t length, bool keep_size)
+{
+#ifdef MODULE
+
+	if (vfs_fallocate(nfile, keep_size ? FALLOC_FL_KEEP_SIZE : 0,
+			  (loff_t)offset, (loff_t)length) != 0)
+		return GET_ERR(NFILE_PREALLOC_ERROR);
+
+#elif defined(_WIN32)
+
+	HANDLE handle = nfile_get_handle(nfile);
+	LONGLONG end = (LONGLONG)(offset + length);
+
+	FILE_STANDARD_INFO info;
+	if (!GetFileInformationByHandleEx(handle, FileStandardInfo, &info,
+					  sizeof(info)))
+		return GET_ERR(NFILE_PREALLOC_ERROR);
+
+	// NTFS truncates when the allocation drops below the end of file
+	if (info.AllocationSize.QuadPart < end) {
+		FILE_ALLOCATION_INFO alloc_info;
+		alloc_info.AllocationSize.QuadPart = end;
+		if (!SetFileInformationByHandle(handle, FileAllocationInfo,
+						&alloc_info,
+						sizeof(alloc_info)))
+			return GET_ERR(NFILE_PREALLOC_ERROR);
+	}
+
+	if (!keep_size && info.EndOfFile.QuadPart < end) {
+		FILE_END_OF_FILE_INFO eof_info;
+		eof_info.EndOfFile.QuadPart = end;
+		if (!SetFileInformationByHandle(handle, FileEndOfFileInfo,
+						&eof_info, sizeof(eof_info)))
+			return GET_ERR(NFILE_PREALLOC_ERROR);
+	}
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	int fd = nfile_get_handle(nfile);
+	if (fallocate(fd, keep_size ? FALLOC_FL_KEEP_SIZE : 0, (off_t)offset,
+		      (off_t)length) == 0)
+		return N_OK;
+
+	// Filesystems without fallocate support; emulation cannot keep size
+	if (errno != EOPNOTSUPP || keep_size ||
+	    posix_fallocate(fd, (off_t)offset, (off_t)length) != 0)
+		return GET_ERR(NFILE_PREALLOC_ERROR);
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_prealloc(nfile_t nfile, ssize_t offset,
+				  ssize_t length, bool keep_size)
+{
+	nerror_t error = nfile_prealloc_raw(nfile, offset, length, keep_size);
+
+	NFILE_STAT_INVALIDATE(nfile);
+	return error;
+}
+
 #endif // !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
 
 #if !defined(NFILE_DISABLE_RDWR) || NFILE_DISABLE_RDWR != 1
@@ -257,6 +923,271 @@ NFILE_API nfile_t nfile_open_wr(const nfile_path_t pathname)
 #endif /* ifndef MODULE */
 }
 
+static ssize_t nfile_handle_write_all(nfile_handle_t handle, const void *buffer,
+				      size_t length, uint64_t offset)
+{
+	size_t done = 0;
+	while (done < length) {
+		const int8_t *ptr = (const int8_t *)buffer + done;
+		size_t left = length - done;
+		ssize_t ret;
+
+#ifdef MODULE
+
+		loff_t pos = (loff_t)(offset + done);
+		ret = kernel_write(handle, ptr, left, &pos);
+
+#elif defined(_WIN32)
+
+		DWORD written;
+		OVERLAPPED ov = { 0 };
+		ov.Offset = (DWORD)(offset + done);
+		ov.OffsetHigh = (DWORD)((offset + done) >> 32);
+
+		if (left > MAXDWORD)
+			left = MAXDWORD;
+
+		ret = WriteFile(handle, ptr, (DWORD)left, &written, &ov) ?
+			      (ssize_t)written :
+			      -1;
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+		ret = pwrite(handle, ptr, left, (off_t)(offset + done));
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+		if (ret <= 0)
+			break;
+
+		done += ret;
+	}
+
+	return done;
+}
+
+static ssize_t nfile_sock_send_all(nfile_sock_t sock, const void *buffer,
+				   size_t length)
+{
+	size_t done = 0;
+	while (done < length) {
+		const int8_t *ptr = (const int8_t *)buffer + done;
+		size_t left = length - done;
+		ssize_t ret;
+
+#ifdef MODULE
+
+		struct msghdr msg = { .msg_flags = MSG_NOSIGNAL };
+		struct kvec vec = { .iov_base = (void *)ptr, .iov_len = left };
+		ret = kernel_sendmsg(sock, &msg, &vec, 1, left);
+
+#elif defined(_WIN32)
+
+		if (left > INT_MAX)
+			left = INT_MAX;
+
+		int sent = send(sock, (const char *)ptr, (int)left, 0);
+		ret = sent == SOCKET_ERROR ? -1 : sent;
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+		ret = send(sock, ptr, left, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+		if (ret <= 0)
+			break;
+
+		done += ret;
+	}
+
+	return done;
+}
+
+// A failure is only reported when nothing was transferred
+static ssize_t nfile_copy_result(size_t done, bool failed)
+{
+	return failed && done == 0 ? -1 : (ssize_t)done;
+}
+
+#ifndef _WIN32
+
+// Errors meaning the zero-copy call cannot handle this pair of files
+static bool nfile_copy_can_fall_back(int error)
+{
+	return error == EXDEV || error == ENOSYS || error == EOPNOTSUPP ||
+	       error == EINVAL;
+}
+
+#endif /* ifndef _WIN32 */
+
+static ssize_t nfile_copy_range_raw(nfile_t in, ssize_t in_offset, nfile_t out,
+				    ssize_t out_offset, size_t length)
+{
+	nfile_handle_t in_handle = nfile_get_handle(in);
+	nfile_handle_t out_handle = nfile_get_handle(out);
+
+	size_t done = 0;
+	bool failed = false;
+
+#ifdef MODULE
+
+	while (done < length) {
+		ssize_t ret = vfs_copy_file_range(in, in_offset + done, out,
+						  out_offset + done,
+						  length - done, 0);
+		if (ret == 0)
+			return done;
+
+		if (ret < 0) {
+			if (!nfile_copy_can_fall_back((int)-ret))
+				return nfile_copy_result(done, true);
+
+			break;
+		}
+
+		done += ret;
+	}
+
+#elif !defined(_WIN32)
+
+	while (done < length) {
+		loff_t in_pos = (loff_t)(in_offset + done);
+		loff_t out_pos = (loff_t)(out_offset + done);
+
+		ssize_t ret = copy_file_range(in_handle, &in_pos, out_handle,
+					      &out_pos, length - done, 0);
+		if (ret == 0)
+			return done;
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (!nfile_copy_can_fall_back(errno))
+				return nfile_copy_result(done, true);
+
+			break;
+		}
+
+		done += ret;
+	}
+
+#endif /* if !defined(_WIN32) */
+
+	if (done == length)
+		return done;
+
+	// Cross-filesystem copies and old kernels end up here
+	void *buffer = N_ALLOC(NFILE_COPY_CHUNK_SIZE);
+	if (buffer == NULL)
+		return nfile_copy_result(done, true);
+
+	while (done < length) {
+		size_t chunk = length - done;
+		if (chunk > NFILE_COPY_CHUNK_SIZE)
+			chunk = NFILE_COPY_CHUNK_SIZE;
+
+		ssize_t ret = nfile_handle_read(in_handle, buffer, chunk,
+						in_offset + done, true);
+		if (ret <= 0) {
+			failed = ret < 0;
+			break;
+		}
+
+		ssize_t written =
+			nfile_handle_write_all(out_handle, buffer, ret,
+					       out_offset + done);
+		done += written;
+
+		if (written != ret) {
+			failed = true;
+			break;
+		}
+	}
+
+	N_FREE(buffer);
+	return nfile_copy_result(done, failed);
+}
+
+NFILE_API ssize_t nfile_copy_range(nfile_t in, ssize_t in_offset, nfile_t out,
+				   ssize_t out_offset, size_t length)
+{
+	ssize_t ret =
+		nfile_copy_range_raw(in, in_offset, out, out_offset, length);
+
+	NFILE_STAT_INVALIDATE(out);
+	return ret;
+}
+
+NFILE_API ssize_t nfile_send(nfile_t in, ssize_t offset, nfile_sock_t sock,
+			     size_t length)
+{
+	nfile_handle_t in_handle = nfile_get_handle(in);
+	size_t done = 0;
+	bool failed = false;
+
+#if !defined(MODULE) && !defined(_WIN32)
+
+	while (done < length) {
+		off_t pos = (off_t)(offset + done);
+
+		ssize_t ret = sendfile(sock, in_handle, &pos, length - done);
+		if (ret == 0)
+			return done;
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			// Only fall back when sendfile cannot handle this pair
+			if (!nfile_copy_can_fall_back(errno))
+				return nfile_copy_result(done, true);
+
+			break;
+		}
+
+		done += ret;
+	}
+
+	if (done == length)
+		return done;
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	void *buffer = N_ALLOC(NFILE_COPY_CHUNK_SIZE);
+	if (buffer == NULL)
+		return nfile_copy_result(done, true);
+
+	while (done < length) {
+		size_t chunk = length - done;
+		if (chunk > NFILE_COPY_CHUNK_SIZE)
+			chunk = NFILE_COPY_CHUNK_SIZE;
+
+		ssize_t ret = nfile_handle_read(in_handle, buffer, chunk,
+						offset + done, true);
+		if (ret <= 0) {
+			failed = ret < 0;
+			break;
+		}
+
+		ssize_t sent = nfile_sock_send_all(sock, buffer, ret);
+		done += sent;
+
+		if (sent != ret) {
+			failed = true;
+			break;
+		}
+	}
+
+	N_FREE(buffer);
+	return nfile_copy_result(done, failed);
+}
+
 #endif // !defined(NFILE_DISABLE_RDWR) || NFILE_DISABLE_RDWR != 1
 
 #endif // !defined(NFILE_DISABLE) || NFILE_DISABLE != 1
@@ -0,0 +1,116 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nfile_append.h"
+
+#if !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
+
+NFILE_API nerror_t nfile_appender_open(nfile_appender_t *appender,
+				       const nfile_path_t path)
+{
+	nfile_t file = nfile_open_a(path);
+
+#ifdef MODULE
+	if (IS_ERR_OR_NULL(file))
+		return GET_ERR(NFILE_OPEN_ERROR);
+#else /* ifndef MODULE */
+	if (file == NULL)
+		return GET_ERR(NFILE_OPEN_ERROR);
+#endif /* ifndef MODULE */
+
+	appender->file = file;
+	appender->size = (uint64_t)nfile_get_length(file);
+	appender->synced = appender->size;
+
+	NMUTEX_INIT(appender->write_mutex);
+	NMUTEX_INIT(appender->sync_mutex);
+
+	return N_OK;
+}
+
+NFILE_API void nfile_appender_close(nfile_appender_t *appender)
+{
+	nfile_appender_sync(appender);
+	NFILE_CLOSE(appender->file);
+	appender->file = NULL;
+
+#ifdef NMUTEX_DESTROY
+	NMUTEX_DESTROY(appender->write_mutex);
+	NMUTEX_DESTROY(appender->sync_mutex);
+#endif /* ifdef NMUTEX_DESTROY */
+}
+
+static nerror_t nfile_appender_commit(nfile_appender_t *appender, uint64_t end)
+{
+	nerror_t error = N_OK;
+
+	NMUTEX_LOCK(appender->sync_mutex);
+
+	// A leader that ran while this thread waited may already cover it
+	if (appender->synced < end) {
+		NMUTEX_LOCK(appender->write_mutex);
+		uint64_t target = appender->size;
+		NMUTEX_UNLOCK(appender->write_mutex);
+
+		error = nfile_sync(appender->file, true);
+		if (!HAS_ERR(error))
+			appender->synced = target;
+	}
+
+	NMUTEX_UNLOCK(appender->sync_mutex);
+	return error;
+}
+
+NFILE_API nerror_t nfile_append(nfile_appender_t *appender, const void *buffer,
+				size_t length, bool durable)
+{
+	NMUTEX_LOCK(appender->write_mutex);
+
+	ssize_t written = nfile_write(appender->file, buffer, (ssize_t)length);
+	if (written > 0)
+		appender->size += (uint64_t)written;
+
+	uint64_t end = appender->size;
+
+	NMUTEX_UNLOCK(appender->write_mutex);
+
+	if (written != (ssize_t)length)
+		return GET_ERR(NFILE_WRITE_ERROR);
+
+	if (!durable)
+		return N_OK;
+
+	return nfile_appender_commit(appender, end);
+}
+
+NFILE_API nerror_t nfile_appender_sync(nfile_appender_t *appender)
+{
+	NMUTEX_LOCK(appender->write_mutex);
+	uint64_t end = appender->size;
+	NMUTEX_UNLOCK(appender->write_mutex);
+
+	return nfile_appender_commit(appender, end);
+}
+
+#endif // !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
@@ -0,0 +1,334 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nfile_cache.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#include "nmem.h"
+
+static uint32_t nfile_cache_hash(const nfile_path_t path, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t *)path;
+	uint32_t hash = 2166136261u;
+
+	size_t i;
+	for (i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static bool nfile_cache_same(const nfile_stat_t *a, const nfile_stat_t *b)
+{
+	return a->inode == b->inode && a->size == b->size &&
+	       a->mtime == b->mtime && a->mtime_nsec == b->mtime_nsec;
+}
+
+static nfile_cache_entry_t **nfile_cache_bucket(nfile_cache_t *cache,
+						uint32_t hash)
+{
+	return cache->buckets + (hash & (cache->bucket_count - 1));
+}
+
+static nfile_cache_entry_t *nfile_cache_find(nfile_cache_t *cache,
+					     const nfile_path_t path,
+					     size_t size, uint32_t hash)
+{
+	nfile_cache_entry_t *entry = *nfile_cache_bucket(cache, hash);
+	while (entry != NULL) {
+		if (entry->hash == hash && entry->size == size &&
+		    memcmp(entry->path, path, size) == 0)
+			return entry;
+
+		entry = entry->hash_next;
+	}
+
+	return NULL;
+}
+
+static void nfile_cache_lru_remove(nfile_cache_t *cache,
+				   nfile_cache_entry_t *entry)
+{
+	if (entry->lru_prev != NULL)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		cache->lru_head = entry->lru_next;
+
+	if (entry->lru_next != NULL)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		cache->lru_tail = entry->lru_prev;
+}
+
+static void nfile_cache_lru_push(nfile_cache_t *cache,
+				 nfile_cache_entry_t *entry)
+{
+	entry->lru_prev = NULL;
+	entry->lru_next = cache->lru_head;
+
+	if (cache->lru_head != NULL)
+		cache->lru_head->lru_prev = entry;
+	else
+		cache->lru_tail = entry;
+
+	cache->lru_head = entry;
+}
+
+static void nfile_cache_link(nfile_cache_t *cache, nfile_cache_entry_t *entry)
+{
+	nfile_cache_entry_t **bucket = nfile_cache_bucket(cache, entry->hash);
+
+	entry->hash_next = *bucket;
+	*bucket = entry;
+
+	nfile_cache_lru_push(cache, entry);
+	entry->linked = true;
+	cache->count++;
+}
+
+static void nfile_cache_unlink(nfile_cache_t *cache, nfile_cache_entry_t *entry)
+{
+	nfile_cache_entry_t **link = nfile_cache_bucket(cache, entry->hash);
+	while (*link != entry)
+		link = &(*link)->hash_next;
+
+	*link = entry->hash_next;
+
+	nfile_cache_lru_remove(cache, entry);
+	entry->linked = false;
+	cache->count--;
+}
+
+// Unlinks unused entries past capacity, returns them chained by hash_next
+static nfile_cache_entry_t *nfile_cache_trim(nfile_cache_t *cache)
+{
+	nfile_cache_entry_t *evicted = NULL;
+	nfile_cache_entry_t *entry = cache->lru_tail;
+
+	while (cache->count > cache->capacity && entry != NULL) {
+		nfile_cache_entry_t *prev = entry->lru_prev;
+
+		if (entry->refs == 0) {
+			nfile_cache_unlink(cache, entry);
+			entry->hash_next = evicted;
+			evicted = entry;
+		}
+
+		entry = prev;
+	}
+
+	return evicted;
+}
+
+static void nfile_cache_free(nfile_cache_entry_t *entry)
+{
+	while (entry != NULL) {
+		nfile_cache_entry_t *next = entry->hash_next;
+
+		NFILE_CLOSE(entry->file);
+		N_FREE(entry);
+
+		entry = next;
+	}
+}
+
+NFILE_API nerror_t nfile_cache_init(nfile_cache_t *cache, size_t capacity)
+{
+	memset(cache, 0, sizeof(*cache));
+
+	size_t bucket_count = 16;
+	while (bucket_count < capacity * 2)
+		bucket_count *= 2;
+
+	cache->buckets = N_ALLOC(bucket_count * sizeof(*cache->buckets));
+	if (cache->buckets == NULL)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	memset(cache->buckets, 0, bucket_count * sizeof(*cache->buckets));
+
+	cache->bucket_count = bucket_count;
+	cache->capacity = capacity;
+	NMUTEX_INIT(cache->mutex);
+
+	return N_OK;
+}
+
+NFILE_API void nfile_cache_destroy(nfile_cache_t *cache)
+{
+	nfile_cache_entry_t *entry = cache->lru_head;
+	while (entry != NULL) {
+		nfile_cache_entry_t *next = entry->lru_next;
+
+		NFILE_CLOSE(entry->file);
+		N_FREE(entry);
+
+		entry = next;
+	}
+
+	N_FREE(cache->buckets);
+	cache->buckets = NULL;
+	cache->lru_head = NULL;
+	cache->lru_tail = NULL;
+	cache->count = 0;
+
+#ifdef NMUTEX_DESTROY
+	NMUTEX_DESTROY(cache->mutex);
+#endif /* ifdef NMUTEX_DESTROY */
+}
+
+static nfile_cache_entry_t *nfile_cache_open(const nfile_path_t path,
+					     size_t size, uint32_t hash)
+{
+	nfile_t file = nfile_open_r(path);
+#ifdef MODULE
+	if (IS_ERR_OR_NULL(file))
+		return NULL;
+#else /* ifndef MODULE */
+	if (file == NULL)
+		return NULL;
+#endif /* ifndef MODULE */
+
+	nfile_cache_entry_t *entry = N_ALLOC(sizeof(*entry) + size);
+	if (entry == NULL) {
+		NFILE_CLOSE(file);
+		return NULL;
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	memcpy(entry->path, path, size);
+
+	if (HAS_ERR(nfile_stat(file, &entry->stat))) {
+		NFILE_CLOSE(file);
+		N_FREE(entry);
+		return NULL;
+	}
+
+	entry->file = file;
+	entry->hash = hash;
+	entry->size = size;
+	entry->refs = 1;
+
+	return entry;
+}
+
+NFILE_API nfile_cache_entry_t *nfile_cache_acquire(nfile_cache_t *cache,
+						   const nfile_path_t path)
+{
+	size_t size = NFILE_PATH_GET_SIZE(path);
+	uint32_t hash = nfile_cache_hash(path, size);
+
+	NMUTEX_LOCK(cache->mutex);
+
+	nfile_cache_entry_t *entry = nfile_cache_find(cache, path, size, hash);
+	if (entry != NULL) {
+		entry->refs++;
+		nfile_cache_lru_remove(cache, entry);
+		nfile_cache_lru_push(cache, entry);
+	}
+
+	NMUTEX_UNLOCK(cache->mutex);
+
+	if (entry != NULL) {
+		nfile_stat_t current;
+		if (!HAS_ERR(nfile_stat_path(path, &current)) &&
+		    nfile_cache_same(&current, &entry->stat))
+			return entry;
+
+		// Replaced or modified on disk, the handle is stale
+		NMUTEX_LOCK(cache->mutex);
+		if (entry->linked)
+			nfile_cache_unlink(cache, entry);
+		NMUTEX_UNLOCK(cache->mutex);
+
+		nfile_cache_release(cache, entry);
+	}
+
+	// Opened without the lock held, another thread may race us here
+	entry = nfile_cache_open(path, size, hash);
+	if (entry == NULL)
+		return NULL;
+
+	nfile_cache_entry_t *evicted = NULL;
+
+	NMUTEX_LOCK(cache->mutex);
+
+	nfile_cache_entry_t *other = nfile_cache_find(cache, path, size, hash);
+	if (other != NULL && nfile_cache_same(&other->stat, &entry->stat)) {
+		other->refs++;
+		nfile_cache_lru_remove(cache, other);
+		nfile_cache_lru_push(cache, other);
+
+		evicted = entry;
+		entry->hash_next = NULL;
+		entry = other;
+	} else {
+		if (other != NULL) {
+			nfile_cache_unlink(cache, other);
+			if (other->refs == 0) {
+				other->hash_next = NULL;
+				evicted = other;
+			}
+		}
+
+		nfile_cache_link(cache, entry);
+
+		nfile_cache_entry_t *trimmed = nfile_cache_trim(cache);
+		if (evicted != NULL)
+			evicted->hash_next = trimmed;
+		else
+			evicted = trimmed;
+	}
+
+	NMUTEX_UNLOCK(cache->mutex);
+
+	nfile_cache_free(evicted);
+	return entry;
+}
+
+NFILE_API void nfile_cache_release(nfile_cache_t *cache,
+				   nfile_cache_entry_t *entry)
+{
+	nfile_cache_entry_t *evicted = NULL;
+
+	NMUTEX_LOCK(cache->mutex);
+
+	entry->refs--;
+	if (entry->refs == 0) {
+		if (!entry->linked) {
+			entry->hash_next = NULL;
+			evicted = entry;
+		} else if (cache->count > cache->capacity) {
+			evicted = nfile_cache_trim(cache);
+		}
+	}
+
+	NMUTEX_UNLOCK(cache->mutex);
+
+	nfile_cache_free(evicted);
+}
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
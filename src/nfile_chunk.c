@@ -0,0 +1,322 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nfile_chunk.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#include "nfile_line.h"
+#include "nmem.h"
+#include "nmutex.h"
+
+#if !defined(MODULE) && !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+#define NFILE_CHUNK_SCAN_SIZE 4096
+
+struct nfile_chunk_job {
+	nfile_t file;
+	nfile_handle_t handle;
+
+	uint64_t *starts; // chunk_count + 1 offsets, the last one is the size
+	void **results;
+	size_t chunk_count;
+
+	size_t next; // Next chunk to hand out, guarded by mutex
+	bool failed; // A chunk could not be read, guarded by mutex
+	NMUTEX mutex;
+
+	nfile_chunk_fn process;
+	void *ctx;
+};
+
+static uint64_t nfile_chunk_align(nfile_t file, char *scan, uint64_t pos,
+				  uint64_t size, char delim)
+{
+	while (pos < size) {
+		ssize_t ret = nfile_read_o(file, (ssize_t)pos, scan,
+					   NFILE_CHUNK_SCAN_SIZE);
+		if (ret <= 0)
+			break;
+
+		const char *hit = nfile_line_find(scan, ret, delim);
+		if (hit != NULL)
+			return pos + (hit - scan) + 1;
+
+		pos += ret;
+	}
+
+	return size;
+}
+
+static bool nfile_chunk_run(struct nfile_chunk_job *job, size_t index)
+{
+	uint64_t start = job->starts[index];
+	size_t length = (size_t)(job->starts[index + 1] - start);
+
+	if (length == 0) {
+		job->results[index] = job->process(job->ctx, "", 0, index);
+		return true;
+	}
+
+#if !defined(MODULE) && !defined(_WIN32)
+
+	uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint64_t base = start & ~(page - 1);
+	size_t map_length = length + (size_t)(start - base);
+
+	void *map = MAP_FAILED;
+	if (length >= NFILE_CHUNK_MAP_SIZE)
+		map = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE,
+			   job->handle, (off_t)base);
+
+	if (map != MAP_FAILED) {
+		madvise(map, map_length, MADV_SEQUENTIAL);
+
+		const char *data = (const char *)map + (start - base);
+		job->results[index] = job->process(job->ctx, data, length,
+						   index);
+
+		munmap(map, map_length);
+		return true;
+	}
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	char *buffer = N_ALLOC(length);
+	if (buffer == NULL)
+		return false;
+
+	size_t done = 0;
+	while (done < length) {
+		ssize_t ret = nfile_read_o(job->file, (ssize_t)(start + done),
+					   buffer + done,
+					   (ssize_t)(length - done));
+		if (ret <= 0) {
+			N_FREE(buffer);
+			return false;
+		}
+
+		done += ret;
+	}
+
+	job->results[index] = job->process(job->ctx, buffer, length, index);
+
+	N_FREE(buffer);
+	return true;
+}
+
+static void nfile_chunk_work(struct nfile_chunk_job *job)
+{
+	while (true) {
+		NMUTEX_LOCK(job->mutex);
+
+		if (job->failed || job->next >= job->chunk_count) {
+			NMUTEX_UNLOCK(job->mutex);
+			return;
+		}
+
+		size_t index = job->next++;
+
+		NMUTEX_UNLOCK(job->mutex);
+
+		if (!nfile_chunk_run(job, index)) {
+			NMUTEX_LOCK(job->mutex);
+			job->failed = true;
+			NMUTEX_UNLOCK(job->mutex);
+		}
+	}
+}
+
+#ifndef MODULE
+
+#ifdef _WIN32
+
+static DWORD WINAPI nfile_chunk_worker(LPVOID param)
+{
+	nfile_chunk_work(param);
+	return 0;
+}
+
+#else /* ifndef _WIN32 */
+
+static void *nfile_chunk_worker(void *param)
+{
+	nfile_chunk_work(param);
+	return NULL;
+}
+
+#endif /* ifndef _WIN32 */
+
+#endif /* ifndef MODULE */
+
+static void nfile_chunk_run_workers(struct nfile_chunk_job *job,
+				    size_t thread_count)
+{
+#ifdef MODULE
+
+	nfile_chunk_work(job);
+
+#else /* ifndef MODULE */
+
+#ifdef _WIN32
+	HANDLE threads[NFILE_CHUNK_MAX_THREADS];
+#else /* ifndef _WIN32 */
+	pthread_t threads[NFILE_CHUNK_MAX_THREADS];
+#endif /* ifndef _WIN32 */
+
+	// The caller is one of the workers
+	size_t started = 0;
+	while (started + 1 < thread_count) {
+#ifdef _WIN32
+		threads[started] = CreateThread(NULL, 0, nfile_chunk_worker,
+						job, 0, NULL);
+		if (threads[started] == NULL)
+			break;
+#else /* ifndef _WIN32 */
+		if (pthread_create(&threads[started], NULL, nfile_chunk_worker,
+				   job) != 0)
+			break;
+#endif /* ifndef _WIN32 */
+
+		started++;
+	}
+
+	nfile_chunk_work(job);
+
+	size_t i;
+	for (i = 0; i < started; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else /* ifndef _WIN32 */
+		pthread_join(threads[i], NULL);
+#endif /* ifndef _WIN32 */
+	}
+
+#endif /* ifndef MODULE */
+}
+
+NFILE_API nerror_t nfile_chunk_process(const nfile_path_t path,
+				       size_t thread_count, char delim,
+				       nfile_chunk_fn process,
+				       nfile_chunk_merge_fn merge, void *ctx)
+{
+	if (thread_count == 0)
+		thread_count = 1;
+
+	if (thread_count > NFILE_CHUNK_MAX_THREADS)
+		thread_count = NFILE_CHUNK_MAX_THREADS;
+
+	nfile_t file = nfile_open_r(path);
+#ifdef MODULE
+	if (IS_ERR_OR_NULL(file))
+		return GET_ERR(NFILE_OPEN_ERROR);
+#else /* ifndef MODULE */
+	if (file == NULL)
+		return GET_ERR(NFILE_OPEN_ERROR);
+#endif /* ifndef MODULE */
+
+	nfile_stat_t stat;
+	if (HAS_ERR(nfile_stat(file, &stat))) {
+		NFILE_CLOSE(file);
+		return GET_ERR(NFILE_STAT_ERROR);
+	}
+
+	// Chunks much smaller than a scan window are not worth a worker
+	size_t chunk_count = thread_count * NFILE_CHUNK_PER_THREAD;
+	if (chunk_count > stat.size / NFILE_CHUNK_SCAN_SIZE + 1)
+		chunk_count = (size_t)(stat.size / NFILE_CHUNK_SCAN_SIZE + 1);
+
+	struct nfile_chunk_job job;
+	memset(&job, 0, sizeof(job));
+
+	job.file = file;
+	job.handle = nfile_get_handle(file);
+	job.chunk_count = chunk_count;
+	job.process = process;
+	job.ctx = ctx;
+
+	job.starts = N_ALLOC((chunk_count + 1) * sizeof(*job.starts));
+	job.results = N_ALLOC(chunk_count * sizeof(*job.results));
+	char *scan = N_ALLOC(NFILE_CHUNK_SCAN_SIZE);
+
+	nerror_t error = N_OK;
+	if (job.starts == NULL || job.results == NULL || scan == NULL) {
+		error = GET_ERR(NFILE_ALLOC_ERROR);
+		goto cleanup;
+	}
+
+	memset(job.results, 0, chunk_count * sizeof(*job.results));
+
+	job.starts[0] = 0;
+	job.starts[chunk_count] = stat.size;
+
+	size_t i;
+	for (i = 1; i < chunk_count; i++) {
+		uint64_t nominal = stat.size * i / chunk_count;
+		uint64_t start = nfile_chunk_align(file, scan, nominal - 1,
+						   stat.size, delim);
+
+		// A record longer than a chunk swallows the next boundary
+		if (start < job.starts[i - 1])
+			start = job.starts[i - 1];
+
+		job.starts[i] = start;
+	}
+
+	NMUTEX_INIT(job.mutex);
+
+	nfile_chunk_run_workers(&job, thread_count);
+
+#ifdef NMUTEX_DESTROY
+	NMUTEX_DESTROY(job.mutex);
+#endif /* ifdef NMUTEX_DESTROY */
+
+	// Chunks that were never processed still get merged with NULL
+	if (job.failed)
+		error = GET_ERR(NFILE_READ_ERROR);
+
+	if (merge != NULL) {
+		for (i = 0; i < chunk_count; i++)
+			merge(ctx, job.results[i], i);
+	}
+
+cleanup:
+	if (scan != NULL)
+		N_FREE(scan);
+
+	if (job.results != NULL)
+		N_FREE(job.results);
+
+	if (job.starts != NULL)
+		N_FREE(job.starts);
+
+	NFILE_CLOSE(file);
+	return error;
+}
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
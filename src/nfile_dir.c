@@ -0,0 +1,625 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if !defined(MODULE) && !defined(_WIN32)
+#define _GNU_SOURCE
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+#include "nfile_dir.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#include "nmem.h"
+
+#ifdef MODULE
+#include <linux/version.h>
+#else /* ifndef MODULE */
+
+#include "nwait.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif /* ifndef _WIN32 */
+
+#endif /* ifndef MODULE */
+
+#ifdef _WIN32
+#define NFILE_DIR_SEPARATOR L'\\'
+#else /* ifndef _WIN32 */
+#define NFILE_DIR_SEPARATOR '/'
+#endif /* ifndef _WIN32 */
+
+static bool nfile_dir_is_dot(const nfile_char_t *name, size_t length)
+{
+	return name[0] == '.' &&
+	       (length == 1 || (length == 2 && name[1] == '.'));
+}
+
+#ifndef _WIN32
+
+static nfile_dir_type_t nfile_dir_type_from_dt(unsigned int d_type)
+{
+	switch (d_type) {
+	case DT_REG:
+		return NFILE_DIR_TYPE_FILE;
+	case DT_DIR:
+		return NFILE_DIR_TYPE_DIR;
+	case DT_LNK:
+		return NFILE_DIR_TYPE_LINK;
+	case DT_UNKNOWN:
+		return NFILE_DIR_TYPE_UNKNOWN;
+	default:
+		return NFILE_DIR_TYPE_OTHER;
+	}
+}
+
+#endif /* ifndef _WIN32 */
+
+#ifdef MODULE
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
+#define NFILE_DIR_FILLDIR_RET bool
+#define NFILE_DIR_FILLDIR_CONTINUE true
+#define NFILE_DIR_FILLDIR_STOP false
+#else /* if LINUX_VERSION_CODE < KERNEL_VERSION(6, 1, 0) */
+#define NFILE_DIR_FILLDIR_RET int
+#define NFILE_DIR_FILLDIR_CONTINUE 0
+#define NFILE_DIR_FILLDIR_STOP -EINTR
+#endif /* if LINUX_VERSION_CODE < KERNEL_VERSION(6, 1, 0) */
+
+struct nfile_dir_kernel_ctx {
+	struct dir_context dir_ctx;
+	const nfile_char_t *dir;
+	nfile_dir_fn fn;
+	void *ctx;
+
+	size_t emitted; // Entries seen by the last iterate_dir call
+	bool stopped;
+	char name[NAME_MAX + 1]; // Names are not null terminated by filldir
+};
+
+static NFILE_DIR_FILLDIR_RET nfile_dir_filldir(struct dir_context *dir_ctx,
+					       const char *name, int length,
+					       loff_t offset, u64 ino,
+					       unsigned int d_type)
+{
+	struct nfile_dir_kernel_ctx *kctx =
+		container_of(dir_ctx, struct nfile_dir_kernel_ctx, dir_ctx);
+
+	kctx->emitted++;
+	if (length > NAME_MAX || nfile_dir_is_dot(name, length))
+		return NFILE_DIR_FILLDIR_CONTINUE;
+
+	memcpy(kctx->name, name, length);
+	kctx->name[length] = '\0';
+
+	nfile_dir_entry_t entry;
+	entry.name = kctx->name;
+	entry.name_length = length;
+	entry.inode = ino;
+	entry.type = nfile_dir_type_from_dt(d_type);
+
+	if (!kctx->fn(kctx->ctx, kctx->dir, &entry)) {
+		kctx->stopped = true;
+		return NFILE_DIR_FILLDIR_STOP;
+	}
+
+	return NFILE_DIR_FILLDIR_CONTINUE;
+}
+
+static nerror_t nfile_dir_scan(const nfile_char_t *dir, void *buffer,
+			       nfile_dir_fn fn, void *ctx)
+{
+	struct file *file = filp_open(dir, O_RDONLY | O_DIRECTORY, 0);
+	if (IS_ERR_OR_NULL(file))
+		return GET_ERR(NFILE_OPEN_ERROR);
+
+	struct nfile_dir_kernel_ctx kctx = {
+		.dir_ctx.actor = nfile_dir_filldir,
+		.dir = dir,
+		.fn = fn,
+		.ctx = ctx,
+	};
+
+	int ret;
+	do {
+		kctx.emitted = 0;
+		ret = iterate_dir(file, &kctx.dir_ctx);
+	} while (ret == 0 && !kctx.stopped && kctx.emitted != 0);
+
+	filp_close(file, NULL);
+
+	if (ret < 0 && !kctx.stopped)
+		return GET_ERR(NFILE_READ_ERROR);
+
+	return N_OK;
+}
+
+#else /* ifndef MODULE */
+
+#ifdef _WIN32
+
+static nerror_t nfile_dir_scan(const nfile_char_t *dir, void *buffer,
+			       nfile_dir_fn fn, void *ctx)
+{
+	size_t length = NFILE_PATH_GET_LENGTH(dir);
+	nfile_char_t *pattern = N_ALLOC(NFILE_PATH_CALC_SIZE(length + 2));
+	if (pattern == NULL)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	memcpy(pattern, dir, length * sizeof(nfile_char_t));
+	pattern[length] = NFILE_DIR_SEPARATOR;
+	pattern[length + 1] = L'*';
+	pattern[length + 2] = L'\0';
+
+	WIN32_FIND_DATAW data;
+	HANDLE find = FindFirstFileExW(pattern, FindExInfoBasic, &data,
+				       FindExSearchNameMatch, NULL,
+				       FIND_FIRST_EX_LARGE_FETCH);
+	N_FREE(pattern);
+
+	if (find == INVALID_HANDLE_VALUE)
+		return GET_ERR(NFILE_OPEN_ERROR);
+
+	bool stopped = false;
+	do {
+		size_t name_length = wcslen(data.cFileName);
+		if (nfile_dir_is_dot(data.cFileName, name_length))
+			continue;
+
+		nfile_dir_entry_t entry;
+		entry.name = data.cFileName;
+		entry.name_length = name_length;
+		entry.inode = 0;
+
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+			entry.type = NFILE_DIR_TYPE_LINK;
+		else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			entry.type = NFILE_DIR_TYPE_DIR;
+		else
+			entry.type = NFILE_DIR_TYPE_FILE;
+
+		if (!fn(ctx, dir, &entry)) {
+			stopped = true;
+			break;
+		}
+	} while (FindNextFileW(find, &data));
+
+	nerror_t error = N_OK;
+	if (!stopped && GetLastError() != ERROR_NO_MORE_FILES)
+		error = GET_ERR(NFILE_READ_ERROR);
+
+	FindClose(find);
+	return error;
+}
+
+#else /* ifndef _WIN32 */
+
+// Record layout of the getdents64 system call
+struct nfile_dir_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+static nfile_dir_type_t nfile_dir_type_at(int fd, const char *name)
+{
+	struct stat st;
+	if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+		return NFILE_DIR_TYPE_UNKNOWN;
+
+	if (S_ISREG(st.st_mode))
+		return NFILE_DIR_TYPE_FILE;
+
+	if (S_ISDIR(st.st_mode))
+		return NFILE_DIR_TYPE_DIR;
+
+	if (S_ISLNK(st.st_mode))
+		return NFILE_DIR_TYPE_LINK;
+
+	return NFILE_DIR_TYPE_OTHER;
+}
+
+static nerror_t nfile_dir_scan(const nfile_char_t *dir, void *buffer,
+			       nfile_dir_fn fn, void *ctx)
+{
+	int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return GET_ERR(NFILE_OPEN_ERROR);
+
+	nerror_t error = N_OK;
+	bool stopped = false;
+
+	while (!stopped) {
+		long ret = syscall(SYS_getdents64, fd, buffer,
+				   NFILE_DIR_BUFFER_SIZE);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			error = GET_ERR(NFILE_READ_ERROR);
+			break;
+		}
+
+		if (ret == 0)
+			break;
+
+		long pos = 0;
+		while (pos < ret) {
+			struct nfile_dir_dirent64 *dirent =
+				(struct nfile_dir_dirent64 *)((char *)buffer +
+							      pos);
+			pos += dirent->d_reclen;
+
+			size_t length = strlen(dirent->d_name);
+			if (nfile_dir_is_dot(dirent->d_name, length))
+				continue;
+
+			nfile_dir_entry_t entry;
+			entry.name = dirent->d_name;
+			entry.name_length = length;
+			entry.inode = dirent->d_ino;
+			entry.type = nfile_dir_type_from_dt(dirent->d_type);
+
+			// Only filesystems without d_type cost a stat
+			if (entry.type == NFILE_DIR_TYPE_UNKNOWN)
+				entry.type =
+					nfile_dir_type_at(fd, dirent->d_name);
+
+			if (!fn(ctx, dir, &entry)) {
+				stopped = true;
+				break;
+			}
+		}
+	}
+
+	close(fd);
+	return error;
+}
+
+#endif /* ifndef _WIN32 */
+
+#endif /* ifndef MODULE */
+
+#if !defined(MODULE) && !defined(_WIN32)
+#define NFILE_DIR_BUFFER_ALLOC() N_ALLOC(NFILE_DIR_BUFFER_SIZE)
+#define NFILE_DIR_BUFFER_FREE(buffer) N_FREE(buffer)
+#else /* if defined(MODULE) || defined(_WIN32) */
+#define NFILE_DIR_BUFFER_ALLOC() ((void *)1)
+#define NFILE_DIR_BUFFER_FREE(buffer) \
+	do {                          \
+	} while (0)
+#endif /* if defined(MODULE) || defined(_WIN32) */
+
+NFILE_API nerror_t nfile_dir_read(const nfile_path_t path, nfile_dir_fn fn,
+				  void *ctx)
+{
+	void *buffer = NFILE_DIR_BUFFER_ALLOC();
+	if (buffer == NULL)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	nerror_t error = nfile_dir_scan(path, buffer, fn, ctx);
+
+	NFILE_DIR_BUFFER_FREE(buffer);
+	return error;
+}
+
+struct nfile_dir_node {
+	struct nfile_dir_node *next;
+	nfile_char_t path[];
+};
+
+struct nfile_dir_job {
+	struct nfile_dir_node *queue; // Directories waiting for a worker
+	size_t pending; // Directories queued or being read
+	nerror_t error; // First failure, the walk goes on regardless
+
+#ifdef MODULE
+	// Kernel walks run on the caller only, the queue needs no lock
+#else /* ifndef MODULE */
+	NMUTEX lock;
+	NCOND cond;
+#endif /* ifndef MODULE */
+
+	nfile_dir_fn fn;
+	void *ctx;
+};
+
+#ifdef MODULE
+
+#define NFILE_DIR_LOCK(job) \
+	do {                \
+	} while (0)
+#define NFILE_DIR_UNLOCK(job) \
+	do {                  \
+	} while (0)
+#define NFILE_DIR_WAIT(job) \
+	do {                \
+	} while (0)
+#define NFILE_DIR_WAKE(job) \
+	do {                \
+	} while (0)
+
+#else /* ifndef MODULE */
+
+#define NFILE_DIR_LOCK(job) NMUTEX_LOCK((job)->lock)
+#define NFILE_DIR_UNLOCK(job) NMUTEX_UNLOCK((job)->lock)
+#define NFILE_DIR_WAIT(job) NCOND_WAIT((job)->cond, (job)->lock)
+#define NFILE_DIR_WAKE(job) NCOND_BROADCAST((job)->cond)
+
+#endif /* ifndef MODULE */
+
+// Per worker state for one directory being read
+struct nfile_dir_worker {
+	struct nfile_dir_job *job;
+	size_t dir_length;
+
+	struct nfile_dir_node *found; // Subdirectories to queue
+	struct nfile_dir_node *found_tail;
+	size_t found_count;
+	nerror_t error;
+};
+
+static struct nfile_dir_node *nfile_dir_node_create(const nfile_char_t *dir,
+						    size_t dir_length,
+						    const nfile_char_t *name,
+						    size_t name_length)
+{
+	size_t length = name_length;
+	if (dir != NULL)
+		length += dir_length + 1;
+
+	struct nfile_dir_node *node =
+		N_ALLOC(sizeof(*node) + NFILE_PATH_CALC_SIZE(length));
+	if (node == NULL)
+		return NULL;
+
+	nfile_char_t *path = node->path;
+	if (dir != NULL) {
+		memcpy(path, dir, dir_length * sizeof(nfile_char_t));
+		path[dir_length] = NFILE_DIR_SEPARATOR;
+		path += dir_length + 1;
+	}
+
+	memcpy(path, name, name_length * sizeof(nfile_char_t));
+	path[name_length] = '\0';
+
+	node->next = NULL;
+	return node;
+}
+
+static bool nfile_dir_walk_visit(void *ctx, const nfile_char_t *dir,
+				 const nfile_dir_entry_t *entry)
+{
+	struct nfile_dir_worker *worker = ctx;
+	struct nfile_dir_job *job = worker->job;
+
+	bool descend = job->fn(job->ctx, dir, entry);
+	if (!descend || entry->type != NFILE_DIR_TYPE_DIR)
+		return true;
+
+	struct nfile_dir_node *node = nfile_dir_node_create(
+		dir, worker->dir_length, entry->name, entry->name_length);
+	if (node == NULL) {
+		worker->error = GET_ERR(NFILE_ALLOC_ERROR);
+		return true;
+	}
+
+	if (worker->found == NULL)
+		worker->found_tail = node;
+
+	node->next = worker->found;
+	worker->found = node;
+	worker->found_count++;
+
+	return true;
+}
+
+static void nfile_dir_work(struct nfile_dir_job *job)
+{
+	void *buffer = NFILE_DIR_BUFFER_ALLOC();
+
+	NFILE_DIR_LOCK(job);
+
+	if (buffer == NULL) {
+		// The other workers drain the queue
+		if (!HAS_ERR(job->error))
+			job->error = GET_ERR(NFILE_ALLOC_ERROR);
+
+		NFILE_DIR_UNLOCK(job);
+		return;
+	}
+
+	struct nfile_dir_worker worker;
+	worker.job = job;
+
+	while (true) {
+		while (job->queue == NULL && job->pending != 0)
+			NFILE_DIR_WAIT(job);
+
+		if (job->queue == NULL)
+			break;
+
+		struct nfile_dir_node *node = job->queue;
+		job->queue = node->next;
+
+		NFILE_DIR_UNLOCK(job);
+
+		worker.dir_length = NFILE_PATH_GET_LENGTH(node->path);
+		worker.found = NULL;
+		worker.found_tail = NULL;
+		worker.found_count = 0;
+		worker.error = N_OK;
+
+		nerror_t error = nfile_dir_scan(node->path, buffer,
+						nfile_dir_walk_visit, &worker);
+		if (!HAS_ERR(error))
+			error = worker.error;
+
+		N_FREE(node);
+
+		NFILE_DIR_LOCK(job);
+
+		if (worker.found != NULL) {
+			worker.found_tail->next = job->queue;
+			job->queue = worker.found;
+		}
+
+		job->pending += worker.found_count;
+		job->pending--;
+
+		if (HAS_ERR(error) && !HAS_ERR(job->error))
+			job->error = error;
+
+		if (worker.found_count != 0 || job->pending == 0)
+			NFILE_DIR_WAKE(job);
+	}
+
+	NFILE_DIR_UNLOCK(job);
+
+	NFILE_DIR_BUFFER_FREE(buffer);
+}
+
+#ifndef MODULE
+
+#ifdef _WIN32
+
+static DWORD WINAPI nfile_dir_worker(LPVOID param)
+{
+	nfile_dir_work(param);
+	return 0;
+}
+
+#else /* ifndef _WIN32 */
+
+static void *nfile_dir_worker(void *param)
+{
+	nfile_dir_work(param);
+	return NULL;
+}
+
+#endif /* ifndef _WIN32 */
+
+#endif /* ifndef MODULE */
+
+static void nfile_dir_run_workers(struct nfile_dir_job *job,
+				  size_t thread_count)
+{
+#ifdef MODULE
+
+	nfile_dir_work(job);
+
+#else /* ifndef MODULE */
+
+#ifdef _WIN32
+	HANDLE threads[NFILE_DIR_MAX_THREADS];
+#else /* ifndef _WIN32 */
+	pthread_t threads[NFILE_DIR_MAX_THREADS];
+#endif /* ifndef _WIN32 */
+
+	// The caller is one of the workers
+	size_t started = 0;
+	while (started + 1 < thread_count) {
+#ifdef _WIN32
+		threads[started] = CreateThread(NULL, 0, nfile_dir_worker, job,
+						0, NULL);
+		if (threads[started] == NULL)
+			break;
+#else /* ifndef _WIN32 */
+		if (pthread_create(&threads[started], NULL, nfile_dir_worker,
+				   job) != 0)
+			break;
+#endif /* ifndef _WIN32 */
+
+		started++;
+	}
+
+	nfile_dir_work(job);
+
+	size_t i;
+	for (i = 0; i < started; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else /* ifndef _WIN32 */
+		pthread_join(threads[i], NULL);
+#endif /* ifndef _WIN32 */
+	}
+
+#endif /* ifndef MODULE */
+}
+
+NFILE_API nerror_t nfile_dir_walk(const nfile_path_t path,
+				  size_t thread_count, nfile_dir_fn fn,
+				  void *ctx)
+{
+	if (thread_count == 0)
+		thread_count = 1;
+
+	if (thread_count > NFILE_DIR_MAX_THREADS)
+		thread_count = NFILE_DIR_MAX_THREADS;
+
+	struct nfile_dir_job job;
+	memset(&job, 0, sizeof(job));
+
+	job.queue = nfile_dir_node_create(NULL, 0, path,
+					  NFILE_PATH_GET_LENGTH(path));
+	if (job.queue == NULL)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	job.pending = 1;
+	job.error = N_OK;
+	job.fn = fn;
+	job.ctx = ctx;
+
+#ifndef MODULE
+	NMUTEX_INIT(job.lock);
+	NCOND_INIT(job.cond);
+#endif /* ifndef MODULE */
+
+	nfile_dir_run_workers(&job, thread_count);
+
+#if !defined(MODULE) && defined(NMUTEX_DESTROY)
+	NMUTEX_DESTROY(job.lock);
+#endif /* if !defined(MODULE) && defined(NMUTEX_DESTROY) */
+
+	// Left over only if every worker failed to start
+	while (job.queue != NULL) {
+		struct nfile_dir_node *next = job.queue->next;
+		N_FREE(job.queue);
+		job.queue = next;
+	}
+
+	return job.error;
+}
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
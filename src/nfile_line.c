@@ -0,0 +1,275 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nfile_line.h"
+
+#if !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
+
+#include "nmem.h"
+
+#if !defined(MODULE) && !defined(NFILE_LINE_DISABLE_SIMD) && \
+	(defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__))
+
+#define NFILE_LINE_SSE2
+#include <emmintrin.h>
+
+#ifdef _MSC_VER
+
+#include <intrin.h>
+
+static int nfile_line_ctz(unsigned int mask)
+{
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+}
+
+#else /* ifndef _MSC_VER */
+
+#define NFILE_LINE_AVX2
+#include <immintrin.h>
+
+#define nfile_line_ctz(mask) __builtin_ctz(mask)
+
+#endif /* ifndef _MSC_VER */
+
+#endif /* if !defined(MODULE) && !defined(NFILE_LINE_DISABLE_SIMD) && ... */
+
+#ifdef NFILE_LINE_SSE2
+
+static const char *nfile_line_find_sse2(const char *ptr, const char *end,
+					char delim)
+{
+	__m128i needle = _mm_set1_epi8(delim);
+
+	while (end - ptr >= 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *)ptr);
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(chunk, needle));
+		if (mask != 0)
+			return ptr + nfile_line_ctz(mask);
+
+		ptr += 16;
+	}
+
+	return memchr(ptr, delim, end - ptr);
+}
+
+#endif /* ifdef NFILE_LINE_SSE2 */
+
+#ifdef NFILE_LINE_AVX2
+
+__attribute__((target("avx2"))) static const char *
+nfile_line_find_avx2(const char *ptr, const char *end, char delim)
+{
+	__m256i needle = _mm256_set1_epi8(delim);
+
+	// Two vectors per iteration keep enough loads in flight
+	while (end - ptr >= 64) {
+		__m256i lo = _mm256_loadu_si256((const __m256i *)ptr);
+		__m256i hi = _mm256_loadu_si256((const __m256i *)(ptr + 32));
+		unsigned int lo_mask = (unsigned int)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(lo, needle));
+		unsigned int hi_mask = (unsigned int)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(hi, needle));
+
+		if ((lo_mask | hi_mask) != 0) {
+			if (lo_mask != 0)
+				return ptr + nfile_line_ctz(lo_mask);
+
+			return ptr + 32 + nfile_line_ctz(hi_mask);
+		}
+
+		ptr += 64;
+	}
+
+	if (end - ptr >= 32) {
+		__m256i chunk = _mm256_loadu_si256((const __m256i *)ptr);
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(chunk, needle));
+		if (mask != 0)
+			return ptr + nfile_line_ctz(mask);
+
+		ptr += 32;
+	}
+
+	return nfile_line_find_sse2(ptr, end, delim);
+}
+
+#endif /* ifdef NFILE_LINE_AVX2 */
+
+NFILE_API const char *nfile_line_find(const char *data, size_t length,
+				      char delim)
+{
+#ifdef NFILE_LINE_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return nfile_line_find_avx2(data, data + length, delim);
+#endif /* ifdef NFILE_LINE_AVX2 */
+
+#ifdef NFILE_LINE_SSE2
+	return nfile_line_find_sse2(data, data + length, delim);
+#else /* ifndef NFILE_LINE_SSE2 */
+	return memchr(data, delim, length);
+#endif /* ifndef NFILE_LINE_SSE2 */
+}
+
+NFILE_API void nfile_line_iter_init(nfile_line_iter_t *iter, const void *data,
+				    size_t length, char delim)
+{
+	memset(iter, 0, sizeof(*iter));
+
+	iter->cur = data;
+	iter->scan = data;
+	iter->end = iter->cur + length;
+	iter->delim = delim;
+	iter->eof = true;
+	iter->error = N_OK;
+}
+
+NFILE_API nerror_t nfile_line_iter_open(nfile_line_iter_t *iter,
+					const nfile_path_t path, char delim)
+{
+	nfile_data_t data;
+	RET_ERR(nfile_read_all(path, NULL, &data));
+
+	nfile_line_iter_init(iter, data.data, data.size, delim);
+	iter->data = data;
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_line_iter_init_file(nfile_line_iter_t *iter,
+					     nfile_t file, size_t buffer_size,
+					     char delim)
+{
+	if (buffer_size == 0)
+		buffer_size = NFILE_LINE_BUFFER_SIZE;
+
+	char *buffer = N_ALLOC(buffer_size);
+	if (buffer == NULL)
+		return GET_ERR(NFILE_ALLOC_ERROR);
+
+	nfile_line_iter_init(iter, NULL, 0, delim);
+
+	iter->cur = buffer;
+	iter->scan = buffer;
+	iter->end = buffer;
+	iter->file = file;
+	iter->buffer = buffer;
+	iter->capacity = buffer_size;
+	iter->eof = false;
+
+	return N_OK;
+}
+
+static void nfile_line_fill(nfile_line_iter_t *iter)
+{
+	size_t left = iter->end - iter->cur;
+
+	// A single record fills the whole buffer
+	if (left == iter->capacity) {
+		size_t new_capacity = iter->capacity * 2;
+		char *new_buffer = N_REALLOC(iter->buffer, new_capacity);
+		if (new_buffer == NULL) {
+			iter->error = GET_ERR(NFILE_ALLOC_ERROR);
+			iter->eof = true;
+			return;
+		}
+
+		iter->buffer = new_buffer;
+		iter->capacity = new_capacity;
+		iter->cur = new_buffer;
+	}
+
+	memmove(iter->buffer, iter->cur, left);
+
+	ssize_t ret = nfile_read_o(iter->file, (ssize_t)iter->offset,
+				   iter->buffer + left,
+				   (ssize_t)(iter->capacity - left));
+	if (ret <= 0) {
+		if (ret < 0)
+			iter->error = GET_ERR(NFILE_READ_ERROR);
+
+		iter->eof = true;
+		ret = 0;
+	}
+
+	iter->offset += ret;
+	iter->cur = iter->buffer;
+	iter->scan = iter->buffer + left;
+	iter->end = iter->scan + ret;
+}
+
+NFILE_API bool nfile_line_next(nfile_line_iter_t *iter, nfile_slice_t *line)
+{
+	while (true) {
+		const char *hit = nfile_line_find(
+			iter->scan, iter->end - iter->scan, iter->delim);
+
+		if (hit != NULL) {
+			line->data = iter->cur;
+			line->length = hit - iter->cur;
+
+			iter->cur = hit + 1;
+			iter->scan = iter->cur;
+			return true;
+		}
+
+		if (iter->eof) {
+			// Bytes left after a failure are a truncated record
+			if (iter->cur == iter->end || HAS_ERR(iter->error))
+				return false;
+
+			line->data = iter->cur;
+			line->length = iter->end - iter->cur;
+
+			iter->cur = iter->end;
+			iter->scan = iter->end;
+			return true;
+		}
+
+		// Nothing before end matched, so only new bytes get scanned
+		nfile_line_fill(iter);
+	}
+}
+
+NFILE_API nerror_t nfile_line_iter_error(const nfile_line_iter_t *iter)
+{
+	return iter->error;
+}
+
+NFILE_API void nfile_line_iter_release(nfile_line_iter_t *iter)
+{
+	if (iter->buffer != NULL)
+		N_FREE(iter->buffer);
+
+	nfile_data_release(&iter->data, NULL);
+
+	iter->buffer = NULL;
+	iter->cur = NULL;
+	iter->scan = NULL;
+	iter->end = NULL;
+}
+
+#endif // !defined(NFILE_DISABLE_READ) || NFILE_DISABLE_READ != 1
@@ -0,0 +1,179 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if !defined(MODULE) && !defined(_WIN32)
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+#include "nfile_stream.h"
+
+#if !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
+
+#ifdef MODULE
+#include <linux/pagemap.h>
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#endif /* elif !defined(_WIN32) */
+
+// Start writeback of a range without waiting for it
+static nerror_t nfile_stream_start(nfile_stream_t *stream, uint64_t offset,
+				   uint64_t length)
+{
+#ifdef MODULE
+
+	if (filemap_fdatawrite_range(stream->file->f_mapping, (loff_t)offset,
+				     (loff_t)(offset + length - 1)) != 0)
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#elif !defined(_WIN32)
+
+	if (sync_file_range(nfile_get_handle(stream->file), (off_t)offset,
+			    (off_t)length, SYNC_FILE_RANGE_WRITE) != 0)
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#endif /* elif !defined(_WIN32) */
+
+	return N_OK;
+}
+
+// Wait until a range is written back, then drop it from the page cache
+static nerror_t nfile_stream_drop(nfile_stream_t *stream, uint64_t offset,
+				  uint64_t length)
+{
+#ifdef MODULE
+
+	if (filemap_write_and_wait_range(stream->file->f_mapping,
+					 (loff_t)offset,
+					 (loff_t)(offset + length - 1)) != 0)
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#elif defined(_WIN32)
+
+	// No ranged writeback, flushing the file covers the whole range
+	if (HAS_ERR(nfile_sync(stream->file, true)))
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	if (sync_file_range(nfile_get_handle(stream->file), (off_t)offset,
+			    (off_t)length,
+			    SYNC_FILE_RANGE_WAIT_BEFORE |
+				    SYNC_FILE_RANGE_WRITE |
+				    SYNC_FILE_RANGE_WAIT_AFTER) != 0)
+		return GET_ERR(NFILE_SYNC_ERROR);
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+	// Only a hint, the data is already safe in the file
+	nfile_advise(stream->file, (ssize_t)offset, (ssize_t)length,
+		     NFILE_ADVICE_DONTNEED);
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_stream_open(nfile_stream_t *stream,
+				     const nfile_path_t path, size_t window,
+				     size_t dirty_limit)
+{
+	nfile_t file = nfile_open_w(path);
+
+#ifdef MODULE
+	if (IS_ERR_OR_NULL(file))
+		return GET_ERR(NFILE_OPEN_ERROR);
+#else /* ifndef MODULE */
+	if (file == NULL)
+		return GET_ERR(NFILE_OPEN_ERROR);
+#endif /* ifndef MODULE */
+
+	if (window == 0)
+		window = NFILE_STREAM_WINDOW_SIZE;
+
+	if (dirty_limit == 0)
+		dirty_limit = NFILE_STREAM_DIRTY_LIMIT;
+
+	if (dirty_limit < window)
+		dirty_limit = window;
+
+	stream->file = file;
+	stream->offset = 0;
+	stream->started = 0;
+	stream->dropped = 0;
+	stream->window = window;
+	stream->dirty_limit = dirty_limit;
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_stream_write(nfile_stream_t *stream,
+				      const void *buffer, size_t length)
+{
+	ssize_t written = nfile_write(stream->file, buffer, (ssize_t)length);
+	if (written > 0)
+		stream->offset += (uint64_t)written;
+
+	if (written != (ssize_t)length)
+		return GET_ERR(NFILE_WRITE_ERROR);
+
+	// nfile_get_handle pushes buffered stdio data down before writeback
+	while (stream->offset - stream->started >= stream->window) {
+		if (HAS_ERR(nfile_stream_start(stream, stream->started,
+					       stream->window)))
+			return GET_ERR(NFILE_SYNC_ERROR);
+
+		stream->started += stream->window;
+	}
+
+	while (stream->offset - stream->dropped > stream->dirty_limit &&
+	       stream->dropped < stream->started) {
+		if (HAS_ERR(nfile_stream_drop(stream, stream->dropped,
+					      stream->window)))
+			return GET_ERR(NFILE_SYNC_ERROR);
+
+		stream->dropped += stream->window;
+	}
+
+	return N_OK;
+}
+
+NFILE_API nerror_t nfile_stream_close(nfile_stream_t *stream)
+{
+	nerror_t error = N_OK;
+
+	if (stream->offset > stream->dropped) {
+		NFILE_FLUSH(stream->file);
+
+		error = nfile_stream_drop(stream, stream->dropped,
+					  stream->offset - stream->dropped);
+		if (!HAS_ERR(error))
+			stream->dropped = stream->offset;
+	}
+
+	NFILE_CLOSE(stream->file);
+	stream->file = NULL;
+
+	return error;
+}
+
+#endif // !defined(NFILE_DISABLE_WRITE) || NFILE_DISABLE_WRITE != 1
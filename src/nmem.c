@@ -26,6 +26,9 @@
 
 #ifdef MODULE
 
+#include <linux/log2.h>
+#include <linux/mm.h>
+
 NEPTUNE_API void *nmem_alloc(size_t size)
 {
 	return kmalloc(size, GFP_KERNEL);
@@ -36,4 +39,184 @@ NEPTUNE_API void *nmem_realloc(void *ptr, size_t size)
 	return krealloc(ptr, size, GFP_KERNEL);
 }
 
+NEPTUNE_API void *nmem_alloc_aligned(size_t size, size_t align)
+{
+	if (align == 0 || (align & (align - 1)) != 0)
+		return NULL;
+
+	if (align <= ARCH_KMALLOC_MINALIGN)
+		return kmalloc(size, GFP_KERNEL);
+
+	// kmalloc aligns power of two sizes to themselves
+	if (size < align)
+		size = align;
+
+	return kmalloc(roundup_pow_of_two(size), GFP_KERNEL);
+}
+
+NEPTUNE_API void nmem_free_aligned(void *ptr)
+{
+	kfree(ptr);
+}
+
+NEPTUNE_API void *nmem_alloc_large(size_t size, nmem_large_flags_t flags)
+{
+	if (size == 0)
+		return NULL;
+
+	// vmalloc pages are populated up front, prefaulting is implied
+	return kvzalloc(size, GFP_KERNEL);
+}
+
+NEPTUNE_API void nmem_free_large(void *ptr, size_t size)
+{
+	kvfree(ptr);
+}
+
+#elif defined(_WIN32) /* ifdef MODULE */
+
+NEPTUNE_API void *nmem_alloc_aligned(size_t size, size_t align)
+{
+	if (align == 0 || (align & (align - 1)) != 0)
+		return NULL;
+
+	return _aligned_malloc(size, align);
+}
+
+NEPTUNE_API void nmem_free_aligned(void *ptr)
+{
+	_aligned_free(ptr);
+}
+
+NEPTUNE_API void *nmem_alloc_large(size_t size, nmem_large_flags_t flags)
+{
+	if (size == 0)
+		return NULL;
+
+	// Large pages need SeLockMemoryPrivilege, fall back quietly without it
+	SIZE_T large_page = GetLargePageMinimum();
+	if (large_page != 0 && size >= NMEM_LARGE_HUGE_SIZE) {
+		SIZE_T rounded = (size + large_page - 1) & ~(large_page - 1);
+		void *ptr = VirtualAlloc(NULL, rounded,
+					 MEM_RESERVE | MEM_COMMIT |
+						 MEM_LARGE_PAGES,
+					 PAGE_READWRITE);
+		if (ptr != NULL)
+			return ptr;
+	}
+
+	char *ptr = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT,
+				 PAGE_READWRITE);
+	if (ptr == NULL || (flags & NMEM_LARGE_PREFAULT) == 0)
+		return ptr;
+
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	size_t i;
+	for (i = 0; i < size; i += info.dwPageSize)
+		((volatile char *)ptr)[i] = 0;
+
+	return ptr;
+}
+
+NEPTUNE_API void nmem_free_large(void *ptr, size_t size)
+{
+	if (ptr != NULL)
+		VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+#else /* ifdef MODULE */
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+NEPTUNE_API void *nmem_alloc_aligned(size_t size, size_t align)
+{
+	if (align == 0 || (align & (align - 1)) != 0)
+		return NULL;
+
+	// posix_memalign wants at least pointer alignment
+	if (align < sizeof(void *))
+		align = sizeof(void *);
+
+	void *ptr;
+	if (posix_memalign(&ptr, align, size) != 0)
+		return NULL;
+
+	return ptr;
+}
+
+NEPTUNE_API void nmem_free_aligned(void *ptr)
+{
+	free(ptr);
+}
+
+static size_t nmem_large_length(size_t size)
+{
+	size_t align = size >= NMEM_LARGE_HUGE_SIZE ?
+			       NMEM_LARGE_HUGE_SIZE :
+			       (size_t)sysconf(_SC_PAGESIZE);
+
+	return (size + align - 1) & ~(align - 1);
+}
+
+NEPTUNE_API void *nmem_alloc_large(size_t size, nmem_large_flags_t flags)
+{
+	if (size == 0 || size > SIZE_MAX - 2 * NMEM_LARGE_HUGE_SIZE)
+		return NULL;
+
+	size_t length = nmem_large_length(size);
+	bool huge = length >= NMEM_LARGE_HUGE_SIZE;
+
+	// Over-map by one huge page so an aligned start can be cut out of it
+	size_t mapped = huge ? length + NMEM_LARGE_HUGE_SIZE : length;
+	char *map = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	char *ptr = map;
+	if (huge) {
+		uintptr_t start = ((uintptr_t)map + NMEM_LARGE_HUGE_SIZE - 1) &
+				  ~(uintptr_t)(NMEM_LARGE_HUGE_SIZE - 1);
+		ptr = (char *)start;
+
+		size_t head = (size_t)(ptr - map);
+		if (head != 0)
+			munmap(map, head);
+
+		size_t tail = mapped - head - length;
+		if (tail != 0)
+			munmap(ptr + length, tail);
+
+#ifdef MADV_HUGEPAGE
+		madvise(ptr, length, MADV_HUGEPAGE);
+#endif /* ifdef MADV_HUGEPAGE */
+	}
+
+	if ((flags & NMEM_LARGE_PREFAULT) == 0)
+		return ptr;
+
+#ifdef MADV_POPULATE_WRITE
+	if (madvise(ptr, length, MADV_POPULATE_WRITE) == 0)
+		return ptr;
+#endif /* ifdef MADV_POPULATE_WRITE */
+
+	// Older kernels, touch a byte per page
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+	size_t i;
+	for (i = 0; i < length; i += page)
+		((volatile char *)ptr)[i] = 0;
+
+	return ptr;
+}
+
+NEPTUNE_API void nmem_free_large(void *ptr, size_t size)
+{
+	if (ptr != NULL)
+		munmap(ptr, nmem_large_length(size));
+}
+
 #endif /* ifdef MODULE */
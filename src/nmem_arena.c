@@ -0,0 +1,186 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nmem_arena.h"
+
+struct nmem_arena_chunk {
+	struct nmem_arena_chunk *prev; // Chunk that was current before this one
+	size_t size; // Usable bytes after the header
+};
+
+// Chunk data starts this far into a chunk so it keeps NMEM_ARENA_ALIGN
+#define NMEM_ARENA_HEADER_SIZE                                            \
+	((sizeof(struct nmem_arena_chunk) + NMEM_ARENA_ALIGN - 1) &        \
+	 ~(NMEM_ARENA_ALIGN - 1))
+
+#define NMEM_ARENA_CHUNK_DATA(chunk) ((char *)(chunk) + NMEM_ARENA_HEADER_SIZE)
+
+NEPTUNE_API void nmem_arena_init(nmem_arena_t *arena, void *buffer,
+				 size_t buffer_size, size_t chunk_size)
+{
+	if (buffer == NULL)
+		buffer_size = 0;
+
+	arena->chunk = NULL;
+	arena->spare = NULL;
+	arena->first = buffer;
+	arena->first_size = buffer_size;
+	arena->pos = buffer;
+	arena->end = buffer_size != 0 ? (char *)buffer + buffer_size : buffer;
+	arena->chunk_size = chunk_size != 0 ? chunk_size :
+					      NMEM_ARENA_CHUNK_SIZE;
+}
+
+// Pops the current chunk, keeping one regular sized chunk as spare
+static void nmem_arena_pop(nmem_arena_t *arena)
+{
+	struct nmem_arena_chunk *chunk = arena->chunk;
+	arena->chunk = chunk->prev;
+
+	if (arena->spare == NULL && chunk->size == arena->chunk_size)
+		arena->spare = chunk;
+	else
+		N_FREE(chunk);
+}
+
+NEPTUNE_API void nmem_arena_destroy(nmem_arena_t *arena)
+{
+	while (arena->chunk != NULL) {
+		struct nmem_arena_chunk *prev = arena->chunk->prev;
+		N_FREE(arena->chunk);
+		arena->chunk = prev;
+	}
+
+	if (arena->spare != NULL) {
+		N_FREE(arena->spare);
+		arena->spare = NULL;
+	}
+
+	arena->pos = arena->first;
+	arena->end = arena->first;
+	if (arena->first != NULL)
+		arena->end += arena->first_size;
+}
+
+static void *nmem_arena_grow(nmem_arena_t *arena, size_t size, size_t align)
+{
+	// Chunk data is only NMEM_ARENA_ALIGN aligned, leave room to align up
+	size_t slack = align > NMEM_ARENA_ALIGN ? align - NMEM_ARENA_ALIGN : 0;
+	if (size > (size_t)-1 - slack - NMEM_ARENA_HEADER_SIZE)
+		return NULL;
+
+	size_t need = size + slack;
+
+	struct nmem_arena_chunk *chunk;
+	if (need <= arena->chunk_size && arena->spare != NULL) {
+		chunk = arena->spare;
+		arena->spare = NULL;
+	} else {
+		size_t chunk_size = need > arena->chunk_size ? need :
+							       arena->chunk_size;
+
+		chunk = N_ALLOC(NMEM_ARENA_HEADER_SIZE + chunk_size);
+		if (chunk == NULL)
+			return NULL;
+
+		chunk->size = chunk_size;
+	}
+
+	chunk->prev = arena->chunk;
+	arena->chunk = chunk;
+	arena->pos = NMEM_ARENA_CHUNK_DATA(chunk);
+	arena->end = arena->pos + chunk->size;
+
+	uintptr_t start = ((uintptr_t)arena->pos + align - 1) & ~(align - 1);
+	arena->pos = (char *)start + size;
+	return (void *)start;
+}
+
+NEPTUNE_API void *nmem_arena_alloc_aligned(nmem_arena_t *arena, size_t size,
+					   size_t align)
+{
+	uintptr_t start = ((uintptr_t)arena->pos + align - 1) & ~(align - 1);
+	uintptr_t end = (uintptr_t)arena->end;
+
+	if (arena->pos != NULL && start <= end && size <= end - start) {
+		arena->pos = (char *)start + size;
+		return (void *)start;
+	}
+
+	return nmem_arena_grow(arena, size, align);
+}
+
+NEPTUNE_API void *nmem_arena_alloc(nmem_arena_t *arena, size_t size)
+{
+	return nmem_arena_alloc_aligned(arena, size, NMEM_ARENA_ALIGN);
+}
+
+NEPTUNE_API nmem_arena_mark_t nmem_arena_mark(nmem_arena_t *arena)
+{
+	nmem_arena_mark_t mark;
+	mark.chunk = arena->chunk;
+	mark.pos = arena->pos;
+	return mark;
+}
+
+NEPTUNE_API void nmem_arena_rewind(nmem_arena_t *arena,
+				   nmem_arena_mark_t mark)
+{
+	while (arena->chunk != mark.chunk)
+		nmem_arena_pop(arena);
+
+	arena->pos = mark.pos;
+
+	if (mark.chunk != NULL) {
+		arena->end = NMEM_ARENA_CHUNK_DATA(mark.chunk) +
+			     mark.chunk->size;
+	} else {
+		arena->end = arena->first;
+		if (arena->first != NULL)
+			arena->end += arena->first_size;
+	}
+}
+
+NEPTUNE_API void nmem_arena_reset(nmem_arena_t *arena)
+{
+	nmem_arena_mark_t start;
+	start.chunk = NULL;
+	start.pos = arena->first;
+
+	nmem_arena_rewind(arena, start);
+}
+
+static void *nmem_arena_allocator_alloc(void *ctx, size_t size)
+{
+	return nmem_arena_alloc(ctx, size);
+}
+
+NEPTUNE_API nmem_allocator_t nmem_arena_allocator(nmem_arena_t *arena)
+{
+	nmem_allocator_t allocator;
+	allocator.alloc = nmem_arena_allocator_alloc;
+	allocator.free = NULL;
+	allocator.ctx = arena;
+	return allocator;
+}
@@ -0,0 +1,433 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nmem_pool.h"
+
+#define NMEM_POOL_ROUND(size) \
+	(((size) + NMEM_POOL_ALIGN - 1) & ~(NMEM_POOL_ALIGN - 1))
+
+#ifdef MODULE
+
+NEPTUNE_API nerror_t nmem_pool_init(nmem_pool_t *pool, const char *name,
+				    size_t object_size)
+{
+	pool->object_size = NMEM_POOL_ROUND(object_size);
+	pool->cache = kmem_cache_create(name != NULL ? name : "nmem_pool",
+					pool->object_size, NMEM_POOL_ALIGN, 0,
+					NULL);
+	if (pool->cache == NULL)
+		return GET_ERR(NMEM_ALLOC_ERROR);
+
+	return N_OK;
+}
+
+NEPTUNE_API void nmem_pool_destroy(nmem_pool_t *pool)
+{
+	kmem_cache_destroy(pool->cache);
+	pool->cache = NULL;
+}
+
+NEPTUNE_API void *nmem_pool_alloc(nmem_pool_t *pool)
+{
+	return kmem_cache_alloc(pool->cache, GFP_KERNEL);
+}
+
+NEPTUNE_API void nmem_pool_free(nmem_pool_t *pool, void *ptr)
+{
+	if (ptr != NULL)
+		kmem_cache_free(pool->cache, ptr);
+}
+
+#else /* ifndef MODULE */
+
+// Each page starts with its page number, objects follow
+#define NMEM_POOL_HEADER_SIZE NMEM_POOL_ALIGN
+
+#define NMEM_POOL_SLOT_BITS 16
+#define NMEM_POOL_MAX_OBJECTS (1u << NMEM_POOL_SLOT_BITS)
+#define NMEM_POOL_MAX_PAGES (NMEM_POOL_DIR_SIZE * NMEM_POOL_DIR_SIZE - 1)
+
+struct nmem_pool_magazine {
+	nmem_pool_t *pool;
+	struct nmem_pool_magazine *prev;
+	struct nmem_pool_magazine *next;
+
+	size_t count;
+	void *objects[NMEM_POOL_MAGAZINE_SIZE];
+};
+
+// A popper may read the link of an object another thread just took
+#define NMEM_POOL_LOAD_LINK(link) \
+	natomic32_load((natomic32_t *)(link), NATOMIC_RELAXED)
+#define NMEM_POOL_STORE_LINK(link, value) \
+	natomic32_store((natomic32_t *)(link), value, NATOMIC_RELAXED)
+
+static void *nmem_pool_page_alloc(size_t size)
+{
+#ifdef _WIN32
+	return _aligned_malloc(size, size);
+#else /* ifndef _WIN32 */
+	void *page;
+	if (posix_memalign(&page, size, size) != 0)
+		return NULL;
+
+	return page;
+#endif /* ifndef _WIN32 */
+}
+
+static void nmem_pool_page_free(void *page)
+{
+#ifdef _WIN32
+	_aligned_free(page);
+#else /* ifndef _WIN32 */
+	free(page);
+#endif /* ifndef _WIN32 */
+}
+
+static void *nmem_pool_object(nmem_pool_t *pool, uint32_t index)
+{
+	uint32_t page_no = index >> NMEM_POOL_SLOT_BITS;
+	uint32_t slot = index & (NMEM_POOL_MAX_OBJECTS - 1);
+
+	char *page = pool->dir[page_no / NMEM_POOL_DIR_SIZE]
+			      [page_no % NMEM_POOL_DIR_SIZE];
+	return page + NMEM_POOL_HEADER_SIZE + slot * pool->object_size;
+}
+
+static uint32_t nmem_pool_index(nmem_pool_t *pool, void *ptr)
+{
+	char *page = (char *)((uintptr_t)ptr & ~(uintptr_t)(pool->page_size - 1));
+	uint32_t page_no = *(uint32_t *)page;
+	size_t slot = ((char *)ptr - page - NMEM_POOL_HEADER_SIZE) /
+		      pool->object_size;
+
+	return page_no << NMEM_POOL_SLOT_BITS | (uint32_t)slot;
+}
+
+// Pushes objects linked from first to last in one step
+static void nmem_pool_push_chain(nmem_pool_t *pool, void *first, void *last)
+{
+	uint64_t desired_index = (uint64_t)nmem_pool_index(pool, first) + 1;
+	uint64_t head = natomic64_load(&pool->head, NATOMIC_ACQUIRE);
+
+	do {
+		NMEM_POOL_STORE_LINK((uint32_t *)last, (uint32_t)head);
+	} while (!natomic64_cas(&pool->head, &head,
+				((head >> 32) + 1) << 32 | desired_index,
+				NATOMIC_ACQ_REL));
+}
+
+static void nmem_pool_push(nmem_pool_t *pool, void **objects, size_t count)
+{
+	if (count == 0)
+		return;
+
+	size_t i;
+	for (i = 0; i + 1 < count; i++)
+		NMEM_POOL_STORE_LINK((uint32_t *)objects[i],
+				     nmem_pool_index(pool, objects[i + 1]) + 1);
+
+	nmem_pool_push_chain(pool, objects[0], objects[count - 1]);
+}
+
+static void *nmem_pool_pop(nmem_pool_t *pool)
+{
+	uint64_t head = natomic64_load(&pool->head, NATOMIC_ACQUIRE);
+
+	while (true) {
+		uint32_t index = (uint32_t)head;
+		if (index == 0)
+			return NULL;
+
+		// The tag makes the swap fail if the object came and went
+		void *object = nmem_pool_object(pool, index - 1);
+		uint64_t next = NMEM_POOL_LOAD_LINK((uint32_t *)object);
+
+		if (natomic64_cas(&pool->head, &head,
+				  ((head >> 32) + 1) << 32 | next,
+				  NATOMIC_ACQ_REL))
+			return object;
+	}
+}
+
+// Adds a page to the directory, called with the mutex held
+static char *nmem_pool_grow(nmem_pool_t *pool)
+{
+	uint32_t page_no = pool->page_count;
+	if (page_no >= NMEM_POOL_MAX_PAGES)
+		return NULL;
+
+	void ***block = &pool->dir[page_no / NMEM_POOL_DIR_SIZE];
+	if (*block == NULL) {
+		*block = N_ALLOC(NMEM_POOL_DIR_SIZE * sizeof(void *));
+		if (*block == NULL)
+			return NULL;
+
+		memset(*block, 0, NMEM_POOL_DIR_SIZE * sizeof(void *));
+	}
+
+	char *page = nmem_pool_page_alloc(pool->page_size);
+	if (page == NULL)
+		return NULL;
+
+	*(uint32_t *)page = page_no;
+	(*block)[page_no % NMEM_POOL_DIR_SIZE] = page;
+	pool->page_count++;
+
+	return page;
+}
+
+static void nmem_pool_refill(nmem_pool_t *pool,
+			     struct nmem_pool_magazine *magazine)
+{
+	while (magazine->count < NMEM_POOL_MAGAZINE_SIZE / 2) {
+		void *object = nmem_pool_pop(pool);
+		if (object == NULL)
+			break;
+
+		magazine->objects[magazine->count++] = object;
+	}
+
+	if (magazine->count != 0)
+		return;
+
+	NMUTEX_LOCK(pool->mutex);
+	char *page = nmem_pool_grow(pool);
+	NMUTEX_UNLOCK(pool->mutex);
+
+	if (page == NULL)
+		return;
+
+	char *objects = page + NMEM_POOL_HEADER_SIZE;
+	uint32_t count = pool->page_objects;
+
+	uint32_t take = NMEM_POOL_MAGAZINE_SIZE / 2;
+	if (take > count)
+		take = count;
+
+	uint32_t i;
+	for (i = 0; i < take; i++)
+		magazine->objects[magazine->count++] =
+			objects + i * pool->object_size;
+
+	if (take == count)
+		return;
+
+	// The rest of the page goes to the free list as one chain
+	uint32_t first_index = nmem_pool_index(pool, objects + take *
+							      pool->object_size);
+	for (i = take; i + 1 < count; i++)
+		NMEM_POOL_STORE_LINK((uint32_t *)(objects +
+						  i * pool->object_size),
+				     first_index + (i - take) + 2);
+
+	nmem_pool_push_chain(pool, objects + take * pool->object_size,
+			     objects + (count - 1) * pool->object_size);
+}
+
+static void nmem_pool_unlink(nmem_pool_t *pool,
+			     struct nmem_pool_magazine *magazine)
+{
+	if (magazine->prev != NULL)
+		magazine->prev->next = magazine->next;
+	else
+		pool->magazines = magazine->next;
+
+	if (magazine->next != NULL)
+		magazine->next->prev = magazine->prev;
+}
+
+// Runs when a thread that used the pool exits
+#ifdef _WIN32
+static VOID NTAPI nmem_pool_magazine_release(PVOID param)
+#else /* ifndef _WIN32 */
+static void nmem_pool_magazine_release(void *param)
+#endif /* ifndef _WIN32 */
+{
+	struct nmem_pool_magazine *magazine = param;
+	if (magazine == NULL)
+		return;
+
+	nmem_pool_t *pool = magazine->pool;
+	nmem_pool_push(pool, magazine->objects, magazine->count);
+
+	NMUTEX_LOCK(pool->mutex);
+	nmem_pool_unlink(pool, magazine);
+	NMUTEX_UNLOCK(pool->mutex);
+
+	N_FREE(magazine);
+}
+
+static struct nmem_pool_magazine *nmem_pool_magazine(nmem_pool_t *pool)
+{
+#ifdef _WIN32
+	struct nmem_pool_magazine *magazine = FlsGetValue(pool->key);
+#else /* ifndef _WIN32 */
+	struct nmem_pool_magazine *magazine = pthread_getspecific(pool->key);
+#endif /* ifndef _WIN32 */
+
+	if (magazine != NULL)
+		return magazine;
+
+	magazine = N_ALLOC(sizeof(*magazine));
+	if (magazine == NULL)
+		return NULL;
+
+	magazine->pool = pool;
+	magazine->prev = NULL;
+	magazine->count = 0;
+
+#ifdef _WIN32
+	bool stored = FlsSetValue(pool->key, magazine);
+#else /* ifndef _WIN32 */
+	bool stored = pthread_setspecific(pool->key, magazine) == 0;
+#endif /* ifndef _WIN32 */
+
+	if (!stored) {
+		N_FREE(magazine);
+		return NULL;
+	}
+
+	NMUTEX_LOCK(pool->mutex);
+
+	magazine->next = pool->magazines;
+	if (magazine->next != NULL)
+		magazine->next->prev = magazine;
+
+	pool->magazines = magazine;
+
+	NMUTEX_UNLOCK(pool->mutex);
+
+	return magazine;
+}
+
+NEPTUNE_API nerror_t nmem_pool_init(nmem_pool_t *pool, const char *name,
+				    size_t object_size)
+{
+	memset(pool, 0, sizeof(*pool));
+
+	if (object_size < sizeof(uint32_t))
+		object_size = sizeof(uint32_t);
+
+	pool->object_size = NMEM_POOL_ROUND(object_size);
+
+	// Big objects get bigger pages so a page still holds a batch
+	size_t page_size = NMEM_POOL_PAGE_SIZE;
+	while ((page_size - NMEM_POOL_HEADER_SIZE) / pool->object_size <
+	       NMEM_POOL_MAGAZINE_SIZE)
+		page_size *= 2;
+
+	size_t page_objects =
+		(page_size - NMEM_POOL_HEADER_SIZE) / pool->object_size;
+	if (page_objects > NMEM_POOL_MAX_OBJECTS)
+		page_objects = NMEM_POOL_MAX_OBJECTS;
+
+	pool->page_size = page_size;
+	pool->page_objects = (uint32_t)page_objects;
+
+#ifdef _WIN32
+	pool->key = FlsAlloc(nmem_pool_magazine_release);
+	if (pool->key == FLS_OUT_OF_INDEXES)
+		return GET_ERR(NMEM_TLS_ERROR);
+#else /* ifndef _WIN32 */
+	if (pthread_key_create(&pool->key, nmem_pool_magazine_release) != 0)
+		return GET_ERR(NMEM_TLS_ERROR);
+#endif /* ifndef _WIN32 */
+
+	NMUTEX_INIT(pool->mutex);
+	return N_OK;
+}
+
+NEPTUNE_API void nmem_pool_destroy(nmem_pool_t *pool)
+{
+	// FlsFree runs the callback for every thread that still has a magazine
+#ifdef _WIN32
+	FlsFree(pool->key);
+#else /* ifndef _WIN32 */
+	pthread_key_delete(pool->key);
+#endif /* ifndef _WIN32 */
+
+	while (pool->magazines != NULL) {
+		struct nmem_pool_magazine *next = pool->magazines->next;
+		N_FREE(pool->magazines);
+		pool->magazines = next;
+	}
+
+	uint32_t i;
+	for (i = 0; i < pool->page_count; i++)
+		nmem_pool_page_free(pool->dir[i / NMEM_POOL_DIR_SIZE]
+					     [i % NMEM_POOL_DIR_SIZE]);
+
+	for (i = 0; i < NMEM_POOL_DIR_SIZE; i++) {
+		if (pool->dir[i] != NULL)
+			N_FREE(pool->dir[i]);
+
+		pool->dir[i] = NULL;
+	}
+
+	pool->page_count = 0;
+	natomic64_store(&pool->head, 0, NATOMIC_RELAXED);
+
+#ifdef NMUTEX_DESTROY
+	NMUTEX_DESTROY(pool->mutex);
+#endif /* ifdef NMUTEX_DESTROY */
+}
+
+NEPTUNE_API void *nmem_pool_alloc(nmem_pool_t *pool)
+{
+	struct nmem_pool_magazine *magazine = nmem_pool_magazine(pool);
+	if (magazine == NULL)
+		return NULL;
+
+	if (magazine->count == 0) {
+		nmem_pool_refill(pool, magazine);
+		if (magazine->count == 0)
+			return NULL;
+	}
+
+	return magazine->objects[--magazine->count];
+}
+
+NEPTUNE_API void nmem_pool_free(nmem_pool_t *pool, void *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	struct nmem_pool_magazine *magazine = nmem_pool_magazine(pool);
+	if (magazine == NULL) {
+		nmem_pool_push(pool, &ptr, 1);
+		return;
+	}
+
+	// Hand half back so a thread that only frees does not hoard objects
+	if (magazine->count == NMEM_POOL_MAGAZINE_SIZE) {
+		size_t half = NMEM_POOL_MAGAZINE_SIZE / 2;
+		nmem_pool_push(pool, magazine->objects + half, half);
+		magazine->count = half;
+	}
+
+	magazine->objects[magazine->count++] = ptr;
+}
+
+#endif /* ifndef MODULE */
@@ -0,0 +1,392 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nmem_tcache.h"
+
+#ifndef MODULE
+
+#include "nmem.h"
+#include "nmutex.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif /* ifndef _WIN32 */
+
+#ifdef _MSC_VER
+#define NMEM_TCACHE_TLS __declspec(thread)
+#else /* ifndef _MSC_VER */
+#define NMEM_TCACHE_TLS __thread
+#endif /* ifndef _MSC_VER */
+
+// Holds the class of a block, or NMEM_TCACHE_LARGE and its size
+#define NMEM_TCACHE_HEADER_SIZE (2 * sizeof(size_t))
+#define NMEM_TCACHE_LARGE ((size_t)-1)
+
+// Eight 16 byte steps up to 128, then four classes per power of two
+#define NMEM_TCACHE_CLASS_COUNT 40
+
+#define NMEM_TCACHE_SPAN_SIZE (64 * 1024)
+#define NMEM_TCACHE_BATCH_BYTES (32 * 1024)
+#define NMEM_TCACHE_BATCH_MIN 4
+#define NMEM_TCACHE_BATCH_MAX 64
+
+struct nmem_tcache_bin {
+	void *head; // Free blocks linked through their first word
+	size_t count;
+};
+
+struct nmem_tcache_thread {
+	struct nmem_tcache_bin bins[NMEM_TCACHE_CLASS_COUNT];
+};
+
+// Each class has its own line, threads refilling different classes
+// would otherwise contend on each other's mutex
+struct NMEM_CACHE_ALIGNED nmem_tcache_central {
+	NMUTEX mutex;
+	void *head; // Free blocks linked through their first word
+	char *carve; // Unused tail of the newest span
+	char *carve_end;
+};
+
+static struct nmem_tcache_central nmem_tcache_centrals[NMEM_TCACHE_CLASS_COUNT];
+
+static NMEM_TCACHE_TLS struct nmem_tcache_thread *nmem_tcache_local;
+static NMEM_TCACHE_TLS bool nmem_tcache_exited;
+
+#ifdef _WIN32
+static INIT_ONCE nmem_tcache_once = INIT_ONCE_STATIC_INIT;
+static DWORD nmem_tcache_key = FLS_OUT_OF_INDEXES;
+#else /* ifndef _WIN32 */
+static pthread_once_t nmem_tcache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t nmem_tcache_key;
+static bool nmem_tcache_key_ready;
+#endif /* ifndef _WIN32 */
+
+static size_t nmem_tcache_class(size_t size)
+{
+	if (size <= 128)
+		return (size + 15) / 16 - (size != 0);
+
+	size_t k = 7;
+	while (((size - 1) >> (k + 1)) != 0)
+		k++;
+
+	size_t step = (size_t)1 << (k - 2);
+	size_t sub = (size - 1 - ((size_t)1 << k)) / step;
+	return 8 + (k - 7) * 4 + sub;
+}
+
+static size_t nmem_tcache_class_size(size_t cls)
+{
+	if (cls < 8)
+		return (cls + 1) * 16;
+
+	size_t k = 7 + (cls - 8) / 4;
+	size_t sub = (cls - 8) % 4;
+	return ((size_t)1 << k) + (sub + 1) * ((size_t)1 << (k - 2));
+}
+
+static size_t nmem_tcache_batch(size_t cls)
+{
+	size_t batch = NMEM_TCACHE_BATCH_BYTES / nmem_tcache_class_size(cls);
+	if (batch < NMEM_TCACHE_BATCH_MIN)
+		return NMEM_TCACHE_BATCH_MIN;
+
+	if (batch > NMEM_TCACHE_BATCH_MAX)
+		return NMEM_TCACHE_BATCH_MAX;
+
+	return batch;
+}
+
+// Moves up to count blocks from a central list into a bin
+static void nmem_tcache_fetch(size_t cls, struct nmem_tcache_bin *bin,
+			      size_t count)
+{
+	struct nmem_tcache_central *central = &nmem_tcache_centrals[cls];
+	size_t size = nmem_tcache_class_size(cls);
+
+	NMUTEX_LOCK(central->mutex);
+
+	while (count != 0 && central->head != NULL) {
+		void *block = central->head;
+		central->head = *(void **)block;
+
+		*(void **)block = bin->head;
+		bin->head = block;
+		bin->count++;
+		count--;
+	}
+
+	while (count != 0) {
+		if (central->carve == NULL ||
+		    (size_t)(central->carve_end - central->carve) < size) {
+			size_t span_size = size * nmem_tcache_batch(cls);
+			if (span_size < NMEM_TCACHE_SPAN_SIZE)
+				span_size = NMEM_TCACHE_SPAN_SIZE;
+
+			char *span = NMEM_RAW_ALLOC(span_size);
+			if (span == NULL)
+				break;
+
+			central->carve = span;
+			central->carve_end = span + span_size;
+		}
+
+		void *block = central->carve;
+		central->carve += size;
+
+		*(void **)block = bin->head;
+		bin->head = block;
+		bin->count++;
+		count--;
+	}
+
+	NMUTEX_UNLOCK(central->mutex);
+}
+
+// Moves count blocks from the front of a bin to its central list
+static void nmem_tcache_release(size_t cls, struct nmem_tcache_bin *bin,
+				size_t count)
+{
+	if (count == 0)
+		return;
+
+	void *first = bin->head;
+	void *last = first;
+
+	size_t i;
+	for (i = 1; i < count; i++)
+		last = *(void **)last;
+
+	bin->head = *(void **)last;
+	bin->count -= count;
+
+	struct nmem_tcache_central *central = &nmem_tcache_centrals[cls];
+
+	NMUTEX_LOCK(central->mutex);
+	*(void **)last = central->head;
+	central->head = first;
+	NMUTEX_UNLOCK(central->mutex);
+}
+
+#ifdef _WIN32
+static VOID NTAPI nmem_tcache_thread_exit(PVOID param)
+#else /* ifndef _WIN32 */
+static void nmem_tcache_thread_exit(void *param)
+#endif /* ifndef _WIN32 */
+{
+	struct nmem_tcache_thread *thread = param;
+	if (thread == NULL)
+		return;
+
+	size_t cls;
+	for (cls = 0; cls < NMEM_TCACHE_CLASS_COUNT; cls++)
+		nmem_tcache_release(cls, &thread->bins[cls],
+				    thread->bins[cls].count);
+
+	// Frees from later destructors go straight to the central lists
+	nmem_tcache_local = NULL;
+	nmem_tcache_exited = true;
+
+	NMEM_RAW_FREE(thread);
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK nmem_tcache_setup(PINIT_ONCE once, PVOID param,
+				       PVOID *context)
+#else /* ifndef _WIN32 */
+static void nmem_tcache_setup(void)
+#endif /* ifndef _WIN32 */
+{
+	size_t cls;
+	for (cls = 0; cls < NMEM_TCACHE_CLASS_COUNT; cls++)
+		NMUTEX_INIT(nmem_tcache_centrals[cls].mutex);
+
+#ifdef _WIN32
+	nmem_tcache_key = FlsAlloc(nmem_tcache_thread_exit);
+	return TRUE;
+#else /* ifndef _WIN32 */
+	nmem_tcache_key_ready = pthread_key_create(&nmem_tcache_key,
+						   nmem_tcache_thread_exit) ==
+				0;
+#endif /* ifndef _WIN32 */
+}
+
+static void nmem_tcache_init(void)
+{
+#ifdef _WIN32
+	InitOnceExecuteOnce(&nmem_tcache_once, nmem_tcache_setup, NULL, NULL);
+#else /* ifndef _WIN32 */
+	pthread_once(&nmem_tcache_once, nmem_tcache_setup);
+#endif /* ifndef _WIN32 */
+}
+
+static struct nmem_tcache_thread *nmem_tcache_thread(void)
+{
+	struct nmem_tcache_thread *thread = nmem_tcache_local;
+	if (thread != NULL || nmem_tcache_exited)
+		return thread;
+
+	nmem_tcache_init();
+
+	thread = NMEM_RAW_ALLOC(sizeof(*thread));
+	if (thread == NULL)
+		return NULL;
+
+	memset(thread, 0, sizeof(*thread));
+
+	// Without the exit hook the cache would leak with the thread
+#ifdef _WIN32
+	bool stored = nmem_tcache_key != FLS_OUT_OF_INDEXES &&
+		      FlsSetValue(nmem_tcache_key, thread);
+#else /* ifndef _WIN32 */
+	bool stored = nmem_tcache_key_ready &&
+		      pthread_setspecific(nmem_tcache_key, thread) == 0;
+#endif /* ifndef _WIN32 */
+
+	if (!stored) {
+		NMEM_RAW_FREE(thread);
+		return NULL;
+	}
+
+	nmem_tcache_local = thread;
+	return thread;
+}
+
+NEPTUNE_API void *nmem_tcache_alloc(size_t size)
+{
+	if (size > NMEM_TCACHE_MAX_SIZE - NMEM_TCACHE_HEADER_SIZE) {
+		if (size > (size_t)-1 - NMEM_TCACHE_HEADER_SIZE)
+			return NULL;
+
+		size_t *large = NMEM_RAW_ALLOC(NMEM_TCACHE_HEADER_SIZE + size);
+		if (large == NULL)
+			return NULL;
+
+		large[0] = NMEM_TCACHE_LARGE;
+		large[1] = size;
+		return (char *)large + NMEM_TCACHE_HEADER_SIZE;
+	}
+
+	size_t cls = nmem_tcache_class(size + NMEM_TCACHE_HEADER_SIZE);
+
+	struct nmem_tcache_bin local = { NULL, 0 };
+	struct nmem_tcache_thread *thread = nmem_tcache_thread();
+
+	// No cache on this thread, take a single block centrally
+	struct nmem_tcache_bin *bin = thread != NULL ? &thread->bins[cls] :
+						       &local;
+
+	if (bin->head == NULL) {
+		nmem_tcache_init();
+		nmem_tcache_fetch(cls, bin,
+				  thread != NULL ? nmem_tcache_batch(cls) : 1);
+		if (bin->head == NULL)
+			return NULL;
+	}
+
+	size_t *block = bin->head;
+	bin->head = *(void **)block;
+	bin->count--;
+
+	block[0] = cls;
+	return (char *)block + NMEM_TCACHE_HEADER_SIZE;
+}
+
+NEPTUNE_API void nmem_tcache_free(void *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	size_t *block = (size_t *)((char *)ptr - NMEM_TCACHE_HEADER_SIZE);
+	size_t cls = block[0];
+
+	if (cls == NMEM_TCACHE_LARGE) {
+		NMEM_RAW_FREE(block);
+		return;
+	}
+
+	struct nmem_tcache_thread *thread = nmem_tcache_thread();
+	if (thread == NULL) {
+		struct nmem_tcache_bin local = { block, 1 };
+		*(void **)block = NULL;
+
+		nmem_tcache_release(cls, &local, 1);
+		return;
+	}
+
+	struct nmem_tcache_bin *bin = &thread->bins[cls];
+	*(void **)block = bin->head;
+	bin->head = block;
+	bin->count++;
+
+	size_t batch = nmem_tcache_batch(cls);
+	if (bin->count > batch * 2)
+		nmem_tcache_release(cls, bin, batch);
+}
+
+NEPTUNE_API void *nmem_tcache_realloc(void *ptr, size_t size)
+{
+	if (ptr == NULL)
+		return nmem_tcache_alloc(size);
+
+	if (size == 0) {
+		nmem_tcache_free(ptr);
+		return NULL;
+	}
+
+	size_t *block = (size_t *)((char *)ptr - NMEM_TCACHE_HEADER_SIZE);
+
+	size_t usable;
+	if (block[0] == NMEM_TCACHE_LARGE) {
+		usable = block[1];
+
+		// Large to large is left to the platform, it may grow in place
+		if (size > NMEM_TCACHE_MAX_SIZE - NMEM_TCACHE_HEADER_SIZE &&
+		    size <= (size_t)-1 - NMEM_TCACHE_HEADER_SIZE) {
+			size_t *large = NMEM_RAW_REALLOC(
+				block, NMEM_TCACHE_HEADER_SIZE + size);
+			if (large == NULL)
+				return NULL;
+
+			large[1] = size;
+			return (char *)large + NMEM_TCACHE_HEADER_SIZE;
+		}
+	} else {
+		usable = nmem_tcache_class_size(block[0]) -
+			 NMEM_TCACHE_HEADER_SIZE;
+		if (size <= usable)
+			return ptr;
+	}
+
+	void *moved = nmem_tcache_alloc(size);
+	if (moved == NULL)
+		return NULL;
+
+	memcpy(moved, ptr, usable < size ? usable : size);
+	nmem_tcache_free(ptr);
+	return moved;
+}
+
+#endif /* ifndef MODULE */
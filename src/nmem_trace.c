@@ -0,0 +1,532 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nmem_trace.h"
+
+#ifndef MODULE
+
+#include "nmem.h"
+#include "natomic.h"
+#include "nmutex.h"
+#include "log.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif /* ifndef _WIN32 */
+
+#ifdef _MSC_VER
+#define NMEM_TRACE_TLS __declspec(thread)
+#else /* ifndef _MSC_VER */
+#define NMEM_TRACE_TLS __thread
+#endif /* ifndef _MSC_VER */
+
+// Holds the site index and the requested size of a block
+#define NMEM_TRACE_HEADER_SIZE (2 * sizeof(size_t))
+
+// Site 0 collects the calls that found the table full
+#define NMEM_TRACE_OTHER 0
+
+struct nmem_trace_site {
+	natomic_ptr_t file; // const char *, NULL while the slot is free
+	int line;
+	natomic64_t live; // Published live bytes, see NMEM_TRACE_BATCH
+	natomic64_t peak;
+};
+
+// Written by the owning thread only, read by snapshots
+struct nmem_trace_counters {
+	natomic64_t allocs;
+	natomic64_t frees;
+	natomic64_t bytes;
+	natomic64_t delta; // Live bytes not yet published to the site
+	natomic64_t high; // Largest delta since the last publish
+	natomic64_t histogram[NMEM_TRACE_BUCKETS];
+};
+
+struct nmem_trace_thread {
+	struct nmem_trace_thread *prev;
+	struct nmem_trace_thread *next;
+
+	struct nmem_trace_counters counters[NMEM_TRACE_MAX_SITES];
+};
+
+static struct nmem_trace_site nmem_trace_sites[NMEM_TRACE_MAX_SITES] = {
+	{ NATOMIC_PTR_INIT((void *)"(other)"), 0, NATOMIC64_INIT(0),
+	  NATOMIC64_INIT(0) },
+};
+
+// Counters of exited threads and of calls made without a thread table
+static struct nmem_trace_thread nmem_trace_retired;
+static struct nmem_trace_thread *nmem_trace_threads = NULL;
+
+static NMUTEX nmem_trace_mutex;
+
+static NMEM_TRACE_TLS struct nmem_trace_thread *nmem_trace_local;
+static NMEM_TRACE_TLS bool nmem_trace_exited;
+
+#ifdef _WIN32
+static INIT_ONCE nmem_trace_once = INIT_ONCE_STATIC_INIT;
+static DWORD nmem_trace_key = FLS_OUT_OF_INDEXES;
+#else /* ifndef _WIN32 */
+static pthread_once_t nmem_trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t nmem_trace_key;
+static bool nmem_trace_key_ready;
+#endif /* ifndef _WIN32 */
+
+// Relaxed accesses let snapshots read counters while their owner updates them
+#define NMEM_TRACE_LOAD(ptr) ((int64_t)natomic64_load(ptr, NATOMIC_RELAXED))
+#define NMEM_TRACE_STORE(ptr, value) \
+	natomic64_store(ptr, (uint64_t)(value), NATOMIC_RELAXED)
+
+#define NMEM_TRACE_LOAD_FILE(site) \
+	((const char *)natomic_ptr_load(&(site)->file, NATOMIC_ACQUIRE))
+#define NMEM_TRACE_STORE_FILE(site, value) \
+	natomic_ptr_store(&(site)->file, (void *)(value), NATOMIC_RELEASE)
+
+static int64_t nmem_trace_publish(natomic64_t *live, int64_t delta)
+{
+	return (int64_t)natomic64_fetch_add(live, (uint64_t)delta,
+					    NATOMIC_RELAXED);
+}
+
+static void nmem_trace_raise(natomic64_t *peak, int64_t value)
+{
+	uint64_t seen = (uint64_t)NMEM_TRACE_LOAD(peak);
+	while ((int64_t)seen < value &&
+	       !natomic64_cas(peak, &seen, (uint64_t)value, NATOMIC_RELAXED))
+		;
+}
+
+#define NMEM_TRACE_ADD(ptr, value) \
+	NMEM_TRACE_STORE(ptr, NMEM_TRACE_LOAD(ptr) + (value))
+
+static size_t nmem_trace_bucket(size_t size)
+{
+	size_t bucket = 0;
+	size_t limit = 16;
+
+	while (size > limit && bucket < NMEM_TRACE_BUCKETS - 1) {
+		limit <<= 2;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+static size_t nmem_trace_site(const char *file, int line)
+{
+	size_t slots = NMEM_TRACE_MAX_SITES - 1;
+	size_t hash = ((size_t)(uintptr_t)file >> 3) ^
+		      ((size_t)line * 0x9e3779b1u);
+
+	size_t i;
+	for (i = 0; i < slots; i++) {
+		size_t index = 1 + (hash + i) % slots;
+		struct nmem_trace_site *site = &nmem_trace_sites[index];
+
+		const char *seen = NMEM_TRACE_LOAD_FILE(site);
+		if (seen == NULL) {
+			NMUTEX_LOCK(nmem_trace_mutex);
+
+			// Another thread may have claimed the slot meanwhile
+			seen = NMEM_TRACE_LOAD_FILE(site);
+			if (seen == NULL) {
+				site->line = line;
+				NMEM_TRACE_STORE_FILE(site, file);
+				seen = file;
+			}
+
+			NMUTEX_UNLOCK(nmem_trace_mutex);
+		}
+
+		if (seen == file && site->line == line)
+			return index;
+	}
+
+	return NMEM_TRACE_OTHER;
+}
+
+// Moves the unpublished live bytes of a counter into its site
+static void nmem_trace_flush(struct nmem_trace_counters *counters,
+			     size_t index)
+{
+	struct nmem_trace_site *site = &nmem_trace_sites[index];
+
+	int64_t delta = NMEM_TRACE_LOAD(&counters->delta);
+	int64_t live = nmem_trace_publish(&site->live, delta);
+	nmem_trace_raise(&site->peak, live + NMEM_TRACE_LOAD(&counters->high));
+
+	NMEM_TRACE_STORE(&counters->delta, 0);
+	NMEM_TRACE_STORE(&counters->high, 0);
+}
+
+static void nmem_trace_account(struct nmem_trace_counters *counters,
+			       size_t index, int64_t size)
+{
+	int64_t delta = NMEM_TRACE_LOAD(&counters->delta) + size;
+	NMEM_TRACE_STORE(&counters->delta, delta);
+
+	if (delta > NMEM_TRACE_LOAD(&counters->high))
+		NMEM_TRACE_STORE(&counters->high, delta);
+
+	if (delta >= NMEM_TRACE_BATCH || delta <= -NMEM_TRACE_BATCH)
+		nmem_trace_flush(counters, index);
+}
+
+#ifdef _WIN32
+static VOID NTAPI nmem_trace_thread_exit(PVOID param)
+#else /* ifndef _WIN32 */
+static void nmem_trace_thread_exit(void *param)
+#endif /* ifndef _WIN32 */
+{
+	struct nmem_trace_thread *thread = param;
+	if (thread == NULL)
+		return;
+
+	NMUTEX_LOCK(nmem_trace_mutex);
+
+	size_t i, b;
+	for (i = 0; i < NMEM_TRACE_MAX_SITES; i++) {
+		struct nmem_trace_counters *from = &thread->counters[i];
+		struct nmem_trace_counters *to = &nmem_trace_retired.counters[i];
+
+		nmem_trace_flush(from, i);
+
+		NMEM_TRACE_ADD(&to->allocs, NMEM_TRACE_LOAD(&from->allocs));
+		NMEM_TRACE_ADD(&to->frees, NMEM_TRACE_LOAD(&from->frees));
+		NMEM_TRACE_ADD(&to->bytes, NMEM_TRACE_LOAD(&from->bytes));
+
+		for (b = 0; b < NMEM_TRACE_BUCKETS; b++)
+			NMEM_TRACE_ADD(&to->histogram[b],
+				       NMEM_TRACE_LOAD(&from->histogram[b]));
+	}
+
+	if (thread->prev != NULL)
+		thread->prev->next = thread->next;
+	else
+		nmem_trace_threads = thread->next;
+
+	if (thread->next != NULL)
+		thread->next->prev = thread->prev;
+
+	NMUTEX_UNLOCK(nmem_trace_mutex);
+
+	// Calls from later destructors are counted as retired
+	nmem_trace_local = NULL;
+	nmem_trace_exited = true;
+
+	NMEM_RAW_FREE(thread);
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK nmem_trace_setup(PINIT_ONCE once, PVOID param,
+				      PVOID *context)
+#else /* ifndef _WIN32 */
+static void nmem_trace_setup(void)
+#endif /* ifndef _WIN32 */
+{
+	NMUTEX_INIT(nmem_trace_mutex);
+
+#ifdef _WIN32
+	nmem_trace_key = FlsAlloc(nmem_trace_thread_exit);
+	return TRUE;
+#else /* ifndef _WIN32 */
+	nmem_trace_key_ready = pthread_key_create(&nmem_trace_key,
+						  nmem_trace_thread_exit) == 0;
+#endif /* ifndef _WIN32 */
+}
+
+static void nmem_trace_init(void)
+{
+#ifdef _WIN32
+	InitOnceExecuteOnce(&nmem_trace_once, nmem_trace_setup, NULL, NULL);
+#else /* ifndef _WIN32 */
+	pthread_once(&nmem_trace_once, nmem_trace_setup);
+#endif /* ifndef _WIN32 */
+}
+
+static struct nmem_trace_thread *nmem_trace_thread(void)
+{
+	struct nmem_trace_thread *thread = nmem_trace_local;
+	if (thread != NULL || nmem_trace_exited)
+		return thread;
+
+	thread = NMEM_RAW_ALLOC(sizeof(*thread));
+	if (thread == NULL)
+		return NULL;
+
+	memset(thread, 0, sizeof(*thread));
+
+#ifdef _WIN32
+	bool stored = nmem_trace_key != FLS_OUT_OF_INDEXES &&
+		      FlsSetValue(nmem_trace_key, thread);
+#else /* ifndef _WIN32 */
+	bool stored = nmem_trace_key_ready &&
+		      pthread_setspecific(nmem_trace_key, thread) == 0;
+#endif /* ifndef _WIN32 */
+
+	if (!stored) {
+		NMEM_RAW_FREE(thread);
+		return NULL;
+	}
+
+	NMUTEX_LOCK(nmem_trace_mutex);
+
+	thread->next = nmem_trace_threads;
+	if (nmem_trace_threads != NULL)
+		nmem_trace_threads->prev = thread;
+
+	nmem_trace_threads = thread;
+
+	NMUTEX_UNLOCK(nmem_trace_mutex);
+
+	nmem_trace_local = thread;
+	return thread;
+}
+
+static void nmem_trace_record(size_t index, int64_t size, bool alloc)
+{
+	struct nmem_trace_thread *thread = nmem_trace_thread();
+
+	// Without a table of its own the thread shares the retired one
+	if (thread == NULL) {
+		NMUTEX_LOCK(nmem_trace_mutex);
+		thread = &nmem_trace_retired;
+	}
+
+	struct nmem_trace_counters *counters = &thread->counters[index];
+
+	if (alloc) {
+		NMEM_TRACE_ADD(&counters->allocs, 1);
+		NMEM_TRACE_ADD(&counters->bytes, size);
+		NMEM_TRACE_ADD(&counters->histogram[nmem_trace_bucket(size)],
+			       1);
+		nmem_trace_account(counters, index, size);
+	} else {
+		NMEM_TRACE_ADD(&counters->frees, 1);
+		nmem_trace_account(counters, index, -size);
+	}
+
+	if (thread == &nmem_trace_retired)
+		NMUTEX_UNLOCK(nmem_trace_mutex);
+}
+
+NEPTUNE_API void *nmem_trace_alloc(size_t size, const char *file, int line)
+{
+	if (size > (size_t)INT64_MAX - NMEM_TRACE_HEADER_SIZE)
+		return NULL;
+
+	size_t *block = NMEM_BASE_ALLOC(NMEM_TRACE_HEADER_SIZE + size);
+	if (block == NULL)
+		return NULL;
+
+	nmem_trace_init();
+
+	size_t index = nmem_trace_site(file, line);
+	block[0] = index;
+	block[1] = size;
+
+	nmem_trace_record(index, (int64_t)size, true);
+	return (char *)block + NMEM_TRACE_HEADER_SIZE;
+}
+
+NEPTUNE_API void nmem_trace_free(void *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	size_t *block = (size_t *)((char *)ptr - NMEM_TRACE_HEADER_SIZE);
+	nmem_trace_record(block[0], (int64_t)block[1], false);
+
+	NMEM_BASE_FREE(block);
+}
+
+NEPTUNE_API void *nmem_trace_realloc(void *ptr, size_t size, const char *file,
+				     int line)
+{
+	if (ptr == NULL)
+		return nmem_trace_alloc(size, file, line);
+
+	if (size == 0) {
+		nmem_trace_free(ptr);
+		return NULL;
+	}
+
+	if (size > (size_t)INT64_MAX - NMEM_TRACE_HEADER_SIZE)
+		return NULL;
+
+	size_t *block = (size_t *)((char *)ptr - NMEM_TRACE_HEADER_SIZE);
+	size_t old_index = block[0];
+	size_t old_size = block[1];
+
+	block = NMEM_BASE_REALLOC(block, NMEM_TRACE_HEADER_SIZE + size);
+	if (block == NULL)
+		return NULL;
+
+	size_t index = nmem_trace_site(file, line);
+	block[0] = index;
+	block[1] = size;
+
+	nmem_trace_record(old_index, (int64_t)old_size, false);
+	nmem_trace_record(index, (int64_t)size, true);
+	return (char *)block + NMEM_TRACE_HEADER_SIZE;
+}
+
+static void nmem_trace_sum(nmem_trace_stat_t *stat,
+			   struct nmem_trace_counters *counters,
+			   int64_t *high)
+{
+	stat->allocs += (uint64_t)NMEM_TRACE_LOAD(&counters->allocs);
+	stat->frees += (uint64_t)NMEM_TRACE_LOAD(&counters->frees);
+	stat->bytes += (uint64_t)NMEM_TRACE_LOAD(&counters->bytes);
+	stat->live += NMEM_TRACE_LOAD(&counters->delta);
+	*high += NMEM_TRACE_LOAD(&counters->high);
+
+	size_t b;
+	for (b = 0; b < NMEM_TRACE_BUCKETS; b++)
+		stat->histogram[b] +=
+			(uint64_t)NMEM_TRACE_LOAD(&counters->histogram[b]);
+}
+
+static int nmem_trace_compare(const void *a, const void *b)
+{
+	const nmem_trace_stat_t *x = a;
+	const nmem_trace_stat_t *y = b;
+
+	if (x->bytes != y->bytes)
+		return x->bytes < y->bytes ? 1 : -1;
+
+	return x->allocs < y->allocs ? 1 : x->allocs > y->allocs ? -1 : 0;
+}
+
+NEPTUNE_API size_t nmem_trace_snapshot(nmem_trace_stat_t *stats, size_t count)
+{
+	nmem_trace_init();
+
+	nmem_trace_stat_t *all =
+		NMEM_RAW_ALLOC(NMEM_TRACE_MAX_SITES * sizeof(*all));
+	if (all == NULL)
+		return 0;
+
+	size_t used = 0;
+
+	NMUTEX_LOCK(nmem_trace_mutex);
+
+	size_t i;
+	for (i = 0; i < NMEM_TRACE_MAX_SITES; i++) {
+		struct nmem_trace_site *site = &nmem_trace_sites[i];
+		const char *file = NMEM_TRACE_LOAD_FILE(site);
+		if (file == NULL)
+			continue;
+
+		nmem_trace_stat_t *stat = &all[used];
+		memset(stat, 0, sizeof(*stat));
+
+		int64_t live = NMEM_TRACE_LOAD(&site->live);
+		int64_t high = 0;
+
+		nmem_trace_sum(stat, &nmem_trace_retired.counters[i], &high);
+
+		struct nmem_trace_thread *thread;
+		for (thread = nmem_trace_threads; thread != NULL;
+		     thread = thread->next)
+			nmem_trace_sum(stat, &thread->counters[i], &high);
+
+		if (stat->allocs == 0 && stat->frees == 0)
+			continue;
+
+		int64_t peak = NMEM_TRACE_LOAD(&site->peak);
+		if (live + high > peak)
+			peak = live + high;
+
+		stat->file = file;
+		stat->line = site->line;
+		stat->live += live;
+		stat->live_blocks = (int64_t)(stat->allocs - stat->frees);
+		stat->peak = peak > 0 ? (uint64_t)peak : 0;
+		used++;
+	}
+
+	NMUTEX_UNLOCK(nmem_trace_mutex);
+
+	if (stats == NULL) {
+		NMEM_RAW_FREE(all);
+		return used;
+	}
+
+	qsort(all, used, sizeof(*all), nmem_trace_compare);
+
+	if (count > used)
+		count = used;
+
+	memcpy(stats, all, count * sizeof(*stats));
+	NMEM_RAW_FREE(all);
+	return count;
+}
+
+NEPTUNE_API void nmem_trace_dump(size_t top)
+{
+#ifdef __LOG_H__
+	if (!log_can_out())
+		return;
+
+	nmem_trace_stat_t *stats =
+		NMEM_RAW_ALLOC(NMEM_TRACE_MAX_SITES * sizeof(*stats));
+	if (stats == NULL)
+		return;
+
+	size_t count = nmem_trace_snapshot(stats, NMEM_TRACE_MAX_SITES);
+
+	size_t i;
+	for (i = 0; i < count && i < top; i++) {
+		nmem_trace_stat_t *stat = &stats[i];
+		LOG_INFO("nmem %s:%d allocs=%llu frees=%llu bytes=%llu "
+			 "live=%lld peak=%llu",
+			 stat->file, stat->line,
+			 (unsigned long long)stat->allocs,
+			 (unsigned long long)stat->frees,
+			 (unsigned long long)stat->bytes,
+			 (long long)stat->live, (unsigned long long)stat->peak);
+	}
+
+	for (i = 0; i < count; i++) {
+		nmem_trace_stat_t *stat = &stats[i];
+		if (stat->live_blocks > 0)
+			LOG_WARN("nmem leak %s:%d blocks=%lld bytes=%lld",
+				 stat->file, stat->line,
+				 (long long)stat->live_blocks,
+				 (long long)stat->live);
+	}
+
+	NMEM_RAW_FREE(stats);
+#endif /* ifdef __LOG_H__ */
+}
+
+NEPTUNE_API void nmem_trace_destroy(void)
+{
+	// Thread tables stay alive, their threads may still be running
+	nmem_trace_dump(NMEM_TRACE_DUMP_TOP);
+}
+
+#endif /* ifndef MODULE */
@@ -25,26 +25,77 @@
 #include "nmutex.h"
 
 #ifndef MODULE
+#if defined(__linux__)
 
-#ifdef _WIN32
+#include "nwait.h"
 
-NEPTUNE_API HANDLE nmutex_init()
+NEPTUNE_API void nmutex_init(nmutex_t *mutex)
 {
-	return CreateMutex(NULL, FALSE, NULL);
+	natomic32_store(&mutex->state, 0, NATOMIC_RELAXED);
+	natomic32_store(&mutex->spin, 0, NATOMIC_RELAXED);
 }
 
-NEPTUNE_API void nmutex_lock(HANDLE nmutex)
+// Moves the spin estimate an eighth of the way towards the last run
+static void nmutex_adapt(nmutex_t *mutex, uint32_t estimate, uint32_t rounds)
 {
-	WaitForSingleObject(nmutex, INFINITE);
+	int32_t step = ((int32_t)rounds - (int32_t)estimate) / 8;
+	natomic32_store(&mutex->spin, (uint32_t)((int32_t)estimate + step),
+			NATOMIC_RELAXED);
 }
 
-#else /* ifndef _WIN32 */
+// Spins while the holder is likely running, returns true on acquiring
+static bool nmutex_spin(nmutex_t *mutex)
+{
+	uint32_t estimate = natomic32_load(&mutex->spin, NATOMIC_RELAXED);
+
+	uint32_t limit = estimate * 2 + NMUTEX_SPIN_MIN;
+	if (limit > NMUTEX_SPIN_MAX)
+		limit = NMUTEX_SPIN_MAX;
+
+	uint32_t rounds;
+	for (rounds = 0; rounds < limit; rounds++) {
+		uint32_t state = natomic32_load(&mutex->state, NATOMIC_RELAXED);
+
+		// Sleepers mean long hold times, spinning would be wasted
+		if (state == 2)
+			break;
+
+		uint32_t expected = 0;
+		if (state == 0 &&
+		    natomic32_cas(&mutex->state, &expected, 1,
+				  NATOMIC_ACQUIRE)) {
+			nmutex_adapt(mutex, estimate, rounds);
+			return true;
+		}
+
+		NATOMIC_PAUSE();
+	}
+
+	nmutex_adapt(mutex, estimate, limit);
+	return false;
+}
+
+NEPTUNE_API void nmutex_lock_slow(nmutex_t *mutex)
+{
+	if (nmutex_spin(mutex))
+		return;
+
+	// Marking the lock contended makes its holder wake us on unlock
+	while (natomic32_exchange(&mutex->state, 2, NATOMIC_ACQUIRE) != 0)
+		nwait_on_address(&mutex->state, 2);
+}
+
+NEPTUNE_API void nmutex_wake(nmutex_t *mutex)
+{
+	nwake(&mutex->state);
+}
+
+#elif !defined(_WIN32) /* if defined(__linux__) */
 
 NEPTUNE_API void nmutex_init(pthread_mutex_t *mutex)
 {
 	pthread_mutex_init(mutex, NULL);
 }
 
-#endif /* ifndef _WIN32 */
-
+#endif /* if defined(__linux__) */
 #endif /* ifndef MODULE */
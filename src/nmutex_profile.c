@@ -0,0 +1,486 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nmutex.h"
+
+#if defined(NMUTEX_PROFILE) && !defined(MODULE)
+
+#include "nmem.h"
+#include "natomic.h"
+#include "ntime.h"
+#include "log.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif /* ifndef _WIN32 */
+
+#ifdef _MSC_VER
+#define NMUTEX_PROFILE_TLS __declspec(thread)
+#else /* ifndef _MSC_VER */
+#define NMUTEX_PROFILE_TLS __thread
+#endif /* ifndef _MSC_VER */
+
+// Site 0 collects the locks that found the table full
+#define NMUTEX_PROFILE_OTHER 0
+
+struct nmutex_profile_site {
+	natomic_ptr_t file; // const char *, NULL while the slot is free
+	const char *name;
+};
+
+// Written by the owning thread only, read by snapshots
+struct nmutex_profile_counters {
+	natomic64_t acquires;
+	natomic64_t contended;
+	natomic64_t wait_total;
+	natomic64_t wait_max;
+	natomic64_t hold_total;
+	natomic64_t hold_histogram[NMUTEX_PROFILE_BUCKETS];
+};
+
+struct nmutex_profile_thread {
+	struct nmutex_profile_thread *prev;
+	struct nmutex_profile_thread *next;
+
+	struct nmutex_profile_counters counters[NMUTEX_PROFILE_MAX_SITES];
+};
+
+static struct nmutex_profile_site
+	nmutex_profile_sites[NMUTEX_PROFILE_MAX_SITES] = {
+		{ NATOMIC_PTR_INIT((void *)""), "(other)" },
+	};
+
+// Counters of exited threads and of locks taken without a thread table
+static struct nmutex_profile_thread nmutex_profile_retired;
+static struct nmutex_profile_thread *nmutex_profile_threads = NULL;
+
+// Guards the tables above, must not be profiled itself
+static NMUTEX_BASE nmutex_profile_mutex = NMUTEX_BASE_INITIALIZER;
+
+static NMUTEX_PROFILE_TLS struct nmutex_profile_thread *nmutex_profile_local;
+static NMUTEX_PROFILE_TLS bool nmutex_profile_exited;
+
+#ifdef _WIN32
+static INIT_ONCE nmutex_profile_once = INIT_ONCE_STATIC_INIT;
+static DWORD nmutex_profile_key = FLS_OUT_OF_INDEXES;
+#else /* ifndef _WIN32 */
+static pthread_once_t nmutex_profile_once = PTHREAD_ONCE_INIT;
+static pthread_key_t nmutex_profile_key;
+static bool nmutex_profile_key_ready;
+#endif /* ifndef _WIN32 */
+
+// Relaxed accesses let snapshots read counters while their owner updates them
+#define NMUTEX_PROFILE_LOAD(ptr) ((int64_t)natomic64_load(ptr, NATOMIC_RELAXED))
+#define NMUTEX_PROFILE_STORE(ptr, value) \
+	natomic64_store(ptr, (uint64_t)(value), NATOMIC_RELAXED)
+
+#define NMUTEX_PROFILE_LOAD_FILE(site) \
+	((const char *)natomic_ptr_load(&(site)->file, NATOMIC_ACQUIRE))
+#define NMUTEX_PROFILE_STORE_FILE(site, value) \
+	natomic_ptr_store(&(site)->file, (void *)(value), NATOMIC_RELEASE)
+
+#define NMUTEX_PROFILE_ADD(ptr, value) \
+	NMUTEX_PROFILE_STORE(ptr, NMUTEX_PROFILE_LOAD(ptr) + (value))
+
+static size_t nmutex_profile_bucket(uint64_t nsec)
+{
+	size_t bucket = 0;
+	uint64_t limit = 256;
+
+	while (nsec > limit && bucket < NMUTEX_PROFILE_BUCKETS - 1) {
+		limit <<= 2;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+// Call sites of the same lock share a slot as long as they share literals
+static size_t nmutex_profile_site(const char *file, const char *name)
+{
+	size_t slots = NMUTEX_PROFILE_MAX_SITES - 1;
+	size_t hash = ((size_t)(uintptr_t)file >> 3) ^
+		      ((size_t)(uintptr_t)name * 0x9e3779b1u);
+
+	size_t i;
+	for (i = 0; i < slots; i++) {
+		size_t index = 1 + (hash + i) % slots;
+		struct nmutex_profile_site *site = &nmutex_profile_sites[index];
+
+		const char *seen = NMUTEX_PROFILE_LOAD_FILE(site);
+		if (seen == NULL) {
+			NMUTEX_BASE_LOCK(nmutex_profile_mutex);
+
+			// Another thread may have claimed the slot meanwhile
+			seen = NMUTEX_PROFILE_LOAD_FILE(site);
+			if (seen == NULL) {
+				site->name = name;
+				NMUTEX_PROFILE_STORE_FILE(site, file);
+				seen = file;
+			}
+
+			NMUTEX_BASE_UNLOCK(nmutex_profile_mutex);
+		}
+
+		if (seen == file && site->name == name)
+			return index;
+	}
+
+	return NMUTEX_PROFILE_OTHER;
+}
+
+static void nmutex_profile_fold(struct nmutex_profile_counters *to,
+				struct nmutex_profile_counters *from)
+{
+	NMUTEX_PROFILE_ADD(&to->acquires, NMUTEX_PROFILE_LOAD(&from->acquires));
+	NMUTEX_PROFILE_ADD(&to->contended,
+			   NMUTEX_PROFILE_LOAD(&from->contended));
+	NMUTEX_PROFILE_ADD(&to->wait_total,
+			   NMUTEX_PROFILE_LOAD(&from->wait_total));
+	NMUTEX_PROFILE_ADD(&to->hold_total,
+			   NMUTEX_PROFILE_LOAD(&from->hold_total));
+
+	int64_t wait_max = NMUTEX_PROFILE_LOAD(&from->wait_max);
+	if (wait_max > NMUTEX_PROFILE_LOAD(&to->wait_max))
+		NMUTEX_PROFILE_STORE(&to->wait_max, wait_max);
+
+	size_t b;
+	for (b = 0; b < NMUTEX_PROFILE_BUCKETS; b++) {
+		int64_t count = NMUTEX_PROFILE_LOAD(&from->hold_histogram[b]);
+		NMUTEX_PROFILE_ADD(&to->hold_histogram[b], count);
+	}
+}
+
+#ifdef _WIN32
+static VOID NTAPI nmutex_profile_thread_exit(PVOID param)
+#else /* ifndef _WIN32 */
+static void nmutex_profile_thread_exit(void *param)
+#endif /* ifndef _WIN32 */
+{
+	struct nmutex_profile_thread *thread = param;
+	if (thread == NULL)
+		return;
+
+	NMUTEX_BASE_LOCK(nmutex_profile_mutex);
+
+	size_t i;
+	for (i = 0; i < NMUTEX_PROFILE_MAX_SITES; i++)
+		nmutex_profile_fold(&nmutex_profile_retired.counters[i],
+				    &thread->counters[i]);
+
+	if (thread->prev != NULL)
+		thread->prev->next = thread->next;
+	else
+		nmutex_profile_threads = thread->next;
+
+	if (thread->next != NULL)
+		thread->next->prev = thread->prev;
+
+	NMUTEX_BASE_UNLOCK(nmutex_profile_mutex);
+
+	// Locks taken by later destructors are counted as retired
+	nmutex_profile_local = NULL;
+	nmutex_profile_exited = true;
+
+	NMEM_RAW_FREE(thread);
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK nmutex_profile_setup(PINIT_ONCE once, PVOID param,
+					  PVOID *context)
+{
+	nmutex_profile_key = FlsAlloc(nmutex_profile_thread_exit);
+	return TRUE;
+}
+#else /* ifndef _WIN32 */
+static void nmutex_profile_setup(void)
+{
+	nmutex_profile_key_ready =
+		pthread_key_create(&nmutex_profile_key,
+				   nmutex_profile_thread_exit) == 0;
+}
+#endif /* ifndef _WIN32 */
+
+static struct nmutex_profile_thread *nmutex_profile_thread(void)
+{
+	struct nmutex_profile_thread *thread = nmutex_profile_local;
+	if (thread != NULL || nmutex_profile_exited)
+		return thread;
+
+#ifdef _WIN32
+	InitOnceExecuteOnce(&nmutex_profile_once, nmutex_profile_setup, NULL,
+			    NULL);
+#else /* ifndef _WIN32 */
+	pthread_once(&nmutex_profile_once, nmutex_profile_setup);
+#endif /* ifndef _WIN32 */
+
+	thread = NMEM_RAW_ALLOC(sizeof(*thread));
+	if (thread == NULL)
+		return NULL;
+
+	memset(thread, 0, sizeof(*thread));
+
+#ifdef _WIN32
+	bool stored = nmutex_profile_key != FLS_OUT_OF_INDEXES &&
+		      FlsSetValue(nmutex_profile_key, thread);
+#else /* ifndef _WIN32 */
+	bool stored = nmutex_profile_key_ready &&
+		      pthread_setspecific(nmutex_profile_key, thread) == 0;
+#endif /* ifndef _WIN32 */
+
+	if (!stored) {
+		NMEM_RAW_FREE(thread);
+		return NULL;
+	}
+
+	NMUTEX_BASE_LOCK(nmutex_profile_mutex);
+
+	thread->next = nmutex_profile_threads;
+	if (nmutex_profile_threads != NULL)
+		nmutex_profile_threads->prev = thread;
+
+	nmutex_profile_threads = thread;
+
+	NMUTEX_BASE_UNLOCK(nmutex_profile_mutex);
+
+	nmutex_profile_local = thread;
+	return thread;
+}
+
+// Returns the counters to update, locking the retired table when shared
+static struct nmutex_profile_counters *nmutex_profile_begin(size_t index,
+							     bool *shared)
+{
+	struct nmutex_profile_thread *thread = nmutex_profile_thread();
+
+	*shared = thread == NULL;
+	if (!*shared)
+		return &thread->counters[index];
+
+	NMUTEX_BASE_LOCK(nmutex_profile_mutex);
+	return &nmutex_profile_retired.counters[index];
+}
+
+NEPTUNE_API void nmutex_profile_init(nmutex_profiled_t *mutex)
+{
+	NMUTEX_BASE_INIT(mutex->base);
+	mutex->acquired = 0;
+	mutex->site = NMUTEX_PROFILE_OTHER;
+}
+
+NEPTUNE_API void nmutex_profile_lock(nmutex_profiled_t *mutex,
+				     const char *file, const char *name)
+{
+	size_t index = nmutex_profile_site(file, name);
+
+	int64_t wait = -1;
+	if (!NMUTEX_BASE_TRYLOCK(mutex->base)) {
+		ntime_t start = ntime_get_nsec();
+		NMUTEX_BASE_LOCK(mutex->base);
+		wait = (int64_t)(ntime_get_nsec() - start);
+	}
+
+	bool shared;
+	struct nmutex_profile_counters *counters =
+		nmutex_profile_begin(index, &shared);
+
+	NMUTEX_PROFILE_ADD(&counters->acquires, 1);
+
+	if (wait >= 0) {
+		NMUTEX_PROFILE_ADD(&counters->contended, 1);
+		NMUTEX_PROFILE_ADD(&counters->wait_total, wait);
+
+		if (wait > NMUTEX_PROFILE_LOAD(&counters->wait_max))
+			NMUTEX_PROFILE_STORE(&counters->wait_max, wait);
+	}
+
+	if (shared)
+		NMUTEX_BASE_UNLOCK(nmutex_profile_mutex);
+
+	mutex->site = (uint32_t)index;
+	mutex->acquired = ntime_get_nsec();
+}
+
+NEPTUNE_API void nmutex_profile_unlock(nmutex_profiled_t *mutex)
+{
+	uint64_t hold = ntime_get_nsec() - mutex->acquired;
+	size_t index = mutex->site;
+
+	NMUTEX_BASE_UNLOCK(mutex->base);
+
+	bool shared;
+	struct nmutex_profile_counters *counters =
+		nmutex_profile_begin(index, &shared);
+
+	size_t bucket = nmutex_profile_bucket(hold);
+	NMUTEX_PROFILE_ADD(&counters->hold_total, (int64_t)hold);
+	NMUTEX_PROFILE_ADD(&counters->hold_histogram[bucket], 1);
+
+	if (shared)
+		NMUTEX_BASE_UNLOCK(nmutex_profile_mutex);
+}
+
+static int nmutex_profile_compare(const void *a, const void *b)
+{
+	const nmutex_profile_stat_t *x = a;
+	const nmutex_profile_stat_t *y = b;
+
+	if (x->wait_total != y->wait_total)
+		return x->wait_total < y->wait_total ? 1 : -1;
+
+	if (x->acquires != y->acquires)
+		return x->acquires < y->acquires ? 1 : -1;
+
+	return 0;
+}
+
+// Adds a thread's counters for a site to a stat
+static void nmutex_profile_sum(nmutex_profile_stat_t *stat,
+			       struct nmutex_profile_counters *counters)
+{
+	stat->acquires += (uint64_t)NMUTEX_PROFILE_LOAD(&counters->acquires);
+	stat->contended += (uint64_t)NMUTEX_PROFILE_LOAD(&counters->contended);
+	stat->wait_total +=
+		(uint64_t)NMUTEX_PROFILE_LOAD(&counters->wait_total);
+	stat->hold_total +=
+		(uint64_t)NMUTEX_PROFILE_LOAD(&counters->hold_total);
+
+	uint64_t wait_max = (uint64_t)NMUTEX_PROFILE_LOAD(&counters->wait_max);
+	if (wait_max > stat->wait_max)
+		stat->wait_max = wait_max;
+
+	size_t b;
+	for (b = 0; b < NMUTEX_PROFILE_BUCKETS; b++)
+		stat->hold_histogram[b] += (uint64_t)NMUTEX_PROFILE_LOAD(
+			&counters->hold_histogram[b]);
+}
+
+NEPTUNE_API size_t nmutex_profile_snapshot(nmutex_profile_stat_t *stats,
+					   size_t count)
+{
+	nmutex_profile_stat_t *all =
+		NMEM_RAW_ALLOC(NMUTEX_PROFILE_MAX_SITES * sizeof(*all));
+	if (all == NULL)
+		return 0;
+
+	size_t used = 0;
+
+	NMUTEX_BASE_LOCK(nmutex_profile_mutex);
+
+	size_t i, j;
+	for (i = 0; i < NMUTEX_PROFILE_MAX_SITES; i++) {
+		struct nmutex_profile_site *site = &nmutex_profile_sites[i];
+		const char *file = NMUTEX_PROFILE_LOAD_FILE(site);
+		if (file == NULL)
+			continue;
+
+		// Sites with equal names from different literals are one lock
+		nmutex_profile_stat_t *stat = NULL;
+		for (j = 0; j < used; j++) {
+			if (strcmp(all[j].file, file) == 0 &&
+			    strcmp(all[j].name, site->name) == 0) {
+				stat = &all[j];
+				break;
+			}
+		}
+
+		if (stat == NULL) {
+			stat = &all[used++];
+			memset(stat, 0, sizeof(*stat));
+			stat->file = file;
+			stat->name = site->name;
+		}
+
+		nmutex_profile_sum(stat, &nmutex_profile_retired.counters[i]);
+
+		struct nmutex_profile_thread *thread;
+		for (thread = nmutex_profile_threads; thread != NULL;
+		     thread = thread->next)
+			nmutex_profile_sum(stat, &thread->counters[i]);
+	}
+
+	NMUTEX_BASE_UNLOCK(nmutex_profile_mutex);
+
+	// Drop the slots that never saw an acquisition, like "(other)"
+	size_t kept = 0;
+	for (i = 0; i < used; i++) {
+		if (all[i].acquires != 0)
+			all[kept++] = all[i];
+	}
+
+	if (stats == NULL) {
+		NMEM_RAW_FREE(all);
+		return kept;
+	}
+
+	qsort(all, kept, sizeof(*all), nmutex_profile_compare);
+
+	if (count > kept)
+		count = kept;
+
+	memcpy(stats, all, count * sizeof(*stats));
+	NMEM_RAW_FREE(all);
+	return count;
+}
+
+NEPTUNE_API void nmutex_profile_dump(size_t top)
+{
+#ifdef __LOG_H__
+	if (!log_can_out())
+		return;
+
+	nmutex_profile_stat_t *stats =
+		NMEM_RAW_ALLOC(NMUTEX_PROFILE_MAX_SITES * sizeof(*stats));
+	if (stats == NULL)
+		return;
+
+	if (top > NMUTEX_PROFILE_MAX_SITES)
+		top = NMUTEX_PROFILE_MAX_SITES;
+
+	size_t count = nmutex_profile_snapshot(stats, top);
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		nmutex_profile_stat_t *stat = &stats[i];
+		LOG_INFO("nmutex %s:%s acquires=%llu contended=%llu "
+			 "wait=%lluns wait_max=%lluns hold=%lluns",
+			 stat->file, stat->name,
+			 (unsigned long long)stat->acquires,
+			 (unsigned long long)stat->contended,
+			 (unsigned long long)stat->wait_total,
+			 (unsigned long long)stat->wait_max,
+			 (unsigned long long)stat->hold_total);
+	}
+
+	NMEM_RAW_FREE(stats);
+#endif /* ifdef __LOG_H__ */
+}
+
+NEPTUNE_API void nmutex_profile_destroy(void)
+{
+	// Thread tables stay alive, their threads may still be running
+	nmutex_profile_dump(NMUTEX_PROFILE_DUMP_TOP);
+}
+
+#endif /* if defined(NMUTEX_PROFILE) && !defined(MODULE) */
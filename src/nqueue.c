@@ -0,0 +1,250 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nqueue.h"
+
+static uint64_t nqueue_capacity(size_t capacity)
+{
+	uint64_t rounded = 2;
+	while (rounded < capacity)
+		rounded <<= 1;
+
+	return rounded;
+}
+
+NEPTUNE_API nerror_t nspsc_init(nspsc_t *queue, size_t capacity)
+{
+	uint64_t size = nqueue_capacity(capacity);
+
+	queue->slots = N_ALLOC_ALIGNED(size * sizeof(void *), NMEM_CACHE_LINE);
+	if (queue->slots == NULL)
+		return GET_ERR(NMEM_ALLOC_ERROR);
+
+	queue->mask = size - 1;
+	natomic64_store(&queue->tail, 0, NATOMIC_RELAXED);
+	natomic64_store(&queue->head, 0, NATOMIC_RELAXED);
+	queue->head_cache = 0;
+	queue->tail_cache = 0;
+
+	return N_OK;
+}
+
+NEPTUNE_API void nspsc_destroy(nspsc_t *queue)
+{
+	N_FREE_ALIGNED(queue->slots);
+	queue->slots = NULL;
+}
+
+NEPTUNE_API size_t nspsc_push_batch(nspsc_t *queue, void *const *items,
+				    size_t count)
+{
+	uint64_t tail = natomic64_load(&queue->tail, NATOMIC_RELAXED);
+	uint64_t capacity = queue->mask + 1;
+
+	// Only look at the consumer's index when the cached one says full
+	uint64_t space = capacity - (tail - queue->head_cache);
+	if (space < count) {
+		queue->head_cache =
+			natomic64_load(&queue->head, NATOMIC_ACQUIRE);
+		space = capacity - (tail - queue->head_cache);
+	}
+
+	if (count > space)
+		count = (size_t)space;
+
+	size_t i;
+	for (i = 0; i < count; i++)
+		queue->slots[(tail + i) & queue->mask] = items[i];
+
+	if (count != 0)
+		natomic64_store(&queue->tail, tail + count, NATOMIC_RELEASE);
+
+	return count;
+}
+
+NEPTUNE_API size_t nspsc_pop_batch(nspsc_t *queue, void **items, size_t count)
+{
+	uint64_t head = natomic64_load(&queue->head, NATOMIC_RELAXED);
+
+	// Only look at the producer's index when the cached one says empty
+	uint64_t ready = queue->tail_cache - head;
+	if (ready < count) {
+		queue->tail_cache =
+			natomic64_load(&queue->tail, NATOMIC_ACQUIRE);
+		ready = queue->tail_cache - head;
+	}
+
+	if (count > ready)
+		count = (size_t)ready;
+
+	size_t i;
+	for (i = 0; i < count; i++)
+		items[i] = queue->slots[(head + i) & queue->mask];
+
+	if (count != 0)
+		natomic64_store(&queue->head, head + count, NATOMIC_RELEASE);
+
+	return count;
+}
+
+NEPTUNE_API bool nspsc_push(nspsc_t *queue, void *item)
+{
+	return nspsc_push_batch(queue, &item, 1) == 1;
+}
+
+NEPTUNE_API bool nspsc_pop(nspsc_t *queue, void **item)
+{
+	return nspsc_pop_batch(queue, item, 1) == 1;
+}
+
+NEPTUNE_API nerror_t nmpmc_init(nmpmc_t *queue, size_t capacity)
+{
+	uint64_t size = nqueue_capacity(capacity);
+
+	queue->cells = N_ALLOC_ALIGNED(size * sizeof(struct nmpmc_cell),
+				       NMEM_CACHE_LINE);
+	if (queue->cells == NULL)
+		return GET_ERR(NMEM_ALLOC_ERROR);
+
+	uint64_t i;
+	for (i = 0; i < size; i++) {
+		natomic64_store(&queue->cells[i].sequence, i, NATOMIC_RELAXED);
+		queue->cells[i].item = NULL;
+	}
+
+	queue->mask = size - 1;
+	natomic64_store(&queue->tail, 0, NATOMIC_RELAXED);
+	natomic64_store(&queue->head, 0, NATOMIC_RELAXED);
+
+	return N_OK;
+}
+
+NEPTUNE_API void nmpmc_destroy(nmpmc_t *queue)
+{
+	N_FREE_ALIGNED(queue->cells);
+	queue->cells = NULL;
+}
+
+/*
+ * Counts the cells from pos on whose sequence is pos + offset, i.e. free
+ * cells for producers (offset 0) or filled ones for consumers (offset 1).
+ * Returns -1 if the first cell shows pos is stale, another thread moved
+ * the index past it.
+ */
+static int64_t nmpmc_ready(nmpmc_t *queue, uint64_t pos, uint64_t offset,
+			   size_t count)
+{
+	size_t n;
+	for (n = 0; n < count; n++) {
+		struct nmpmc_cell *cell = &queue->cells[(pos + n) & queue->mask];
+		uint64_t seq = natomic64_load(&cell->sequence, NATOMIC_ACQUIRE);
+
+		int64_t diff = (int64_t)(seq - (pos + n + offset));
+		if (diff == 0)
+			continue;
+
+		if (diff > 0 && n == 0)
+			return -1;
+
+		break;
+	}
+
+	return (int64_t)n;
+}
+
+NEPTUNE_API size_t nmpmc_push_batch(nmpmc_t *queue, void *const *items,
+				    size_t count)
+{
+	if (count == 0)
+		return 0;
+
+	uint64_t pos = natomic64_load(&queue->tail, NATOMIC_RELAXED);
+
+	int64_t n;
+	while (true) {
+		n = nmpmc_ready(queue, pos, 0, count);
+		if (n == 0)
+			return 0;
+
+		// Cells checked free can only be claimed by moving tail past them
+		if (n > 0 && natomic64_cas(&queue->tail, &pos, pos + (uint64_t)n,
+					   NATOMIC_RELAXED))
+			break;
+
+		if (n < 0)
+			pos = natomic64_load(&queue->tail, NATOMIC_RELAXED);
+	}
+
+	int64_t i;
+	for (i = 0; i < n; i++) {
+		struct nmpmc_cell *cell = &queue->cells[(pos + i) & queue->mask];
+		cell->item = items[i];
+		natomic64_store(&cell->sequence, pos + i + 1, NATOMIC_RELEASE);
+	}
+
+	return (size_t)n;
+}
+
+NEPTUNE_API size_t nmpmc_pop_batch(nmpmc_t *queue, void **items, size_t count)
+{
+	if (count == 0)
+		return 0;
+
+	uint64_t pos = natomic64_load(&queue->head, NATOMIC_RELAXED);
+
+	int64_t n;
+	while (true) {
+		n = nmpmc_ready(queue, pos, 1, count);
+		if (n == 0)
+			return 0;
+
+		if (n > 0 && natomic64_cas(&queue->head, &pos, pos + (uint64_t)n,
+					   NATOMIC_RELAXED))
+			break;
+
+		if (n < 0)
+			pos = natomic64_load(&queue->head, NATOMIC_RELAXED);
+	}
+
+	// Each cell becomes free for the producer one lap later
+	int64_t i;
+	for (i = 0; i < n; i++) {
+		struct nmpmc_cell *cell = &queue->cells[(pos + i) & queue->mask];
+		items[i] = cell->item;
+		natomic64_store(&cell->sequence, pos + i + queue->mask + 1,
+				NATOMIC_RELEASE);
+	}
+
+	return (size_t)n;
+}
+
+NEPTUNE_API bool nmpmc_push(nmpmc_t *queue, void *item)
+{
+	return nmpmc_push_batch(queue, &item, 1) == 1;
+}
+
+NEPTUNE_API bool nmpmc_pop(nmpmc_t *queue, void **item)
+{
+	return nmpmc_pop_batch(queue, item, 1) == 1;
+}
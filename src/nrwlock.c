@@ -0,0 +1,49 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if !defined(MODULE) && !defined(_WIN32)
+#define _GNU_SOURCE
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+
+#include "nrwlock.h"
+
+#if !defined(MODULE) && !defined(_WIN32)
+
+NEPTUNE_API void nrwlock_init(pthread_rwlock_t *lock, bool prefer_writers)
+{
+	pthread_rwlockattr_t attr;
+	pthread_rwlockattr_init(&attr);
+
+#ifdef __GLIBC__
+	pthread_rwlockattr_setkind_np(
+		&attr, prefer_writers ?
+			       PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP :
+			       PTHREAD_RWLOCK_PREFER_READER_NP);
+#endif /* ifdef __GLIBC__ */
+
+	pthread_rwlock_init(lock, &attr);
+	pthread_rwlockattr_destroy(&attr);
+}
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
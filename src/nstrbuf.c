@@ -0,0 +1,134 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nstrbuf.h"
+
+NEPTUNE_API void nstrbuf_init(nstrbuf_t *sb)
+{
+	sb->data = NULL;
+	sb->length = 0;
+	sb->capacity = NSTRBUF_SMALL_SIZE;
+	sb->small[0] = '\0';
+}
+
+NEPTUNE_API void nstrbuf_destroy(nstrbuf_t *sb)
+{
+	nvec_release(sb->data, NULL);
+	nstrbuf_init(sb);
+}
+
+NEPTUNE_API void nstrbuf_clear(nstrbuf_t *sb)
+{
+	sb->length = 0;
+	NSTRBUF_DATA(sb)[0] = '\0';
+}
+
+NEPTUNE_API nerror_t nstrbuf_reserve(nstrbuf_t *sb, size_t length)
+{
+	if (length >= (size_t)-1)
+		return GET_ERR(NMEM_ALLOC_ERROR);
+
+	if (length < sb->capacity)
+		return N_OK;
+
+	char *data = nvec_grow(NSTRBUF_DATA(sb), sb->small, sb->length + 1, 1,
+			       &sb->capacity, length + 1);
+	if (data == NULL)
+		return GET_ERR(NMEM_ALLOC_ERROR);
+
+	sb->data = data;
+	return N_OK;
+}
+
+NEPTUNE_API nerror_t nstrbuf_append(nstrbuf_t *sb, const char *str,
+				    size_t length)
+{
+	if (length > (size_t)-1 - 1 - sb->length)
+		return GET_ERR(NMEM_ALLOC_ERROR);
+
+	RET_ERR(nstrbuf_reserve(sb, sb->length + length));
+
+	char *data = NSTRBUF_DATA(sb);
+	memcpy(data + sb->length, str, length);
+
+	sb->length += length;
+	data[sb->length] = '\0';
+	return N_OK;
+}
+
+NEPTUNE_API nerror_t nstrbuf_append_str(nstrbuf_t *sb, const char *str)
+{
+	return nstrbuf_append(sb, str, strlen(str));
+}
+
+NEPTUNE_API nerror_t nstrbuf_append_char(nstrbuf_t *sb, char c)
+{
+	return nstrbuf_append(sb, &c, 1);
+}
+
+NEPTUNE_API nerror_t nstrbuf_vprintf(nstrbuf_t *sb, const char *format,
+				     va_list list)
+{
+	size_t room = sb->capacity - sb->length;
+
+	va_list args_copy;
+	va_copy(args_copy, list);
+	int written = vsnprintf(NSTRBUF_DATA(sb) + sb->length, room, format,
+				args_copy);
+	va_end(args_copy);
+
+	if (written < 0) {
+		NSTRBUF_DATA(sb)[sb->length] = '\0';
+		return GET_ERR(NMEM_FORMAT_ERROR);
+	}
+
+	// Formatted in place, the common case once the capacity has settled
+	if ((size_t)written < room) {
+		sb->length += (size_t)written;
+		return N_OK;
+	}
+
+	nerror_t error = nstrbuf_reserve(sb, sb->length + (size_t)written);
+	if (HAS_ERR(error)) {
+		NSTRBUF_DATA(sb)[sb->length] = '\0';
+		return error;
+	}
+
+	vsnprintf(NSTRBUF_DATA(sb) + sb->length, (size_t)written + 1, format,
+		  list);
+
+	sb->length += (size_t)written;
+	return N_OK;
+}
+
+NEPTUNE_API nerror_t nstrbuf_printf(nstrbuf_t *sb, const char *format, ...)
+{
+	va_list list;
+	va_start(list, format);
+
+	nerror_t error = nstrbuf_vprintf(sb, format, list);
+
+	va_end(list);
+	return error;
+}
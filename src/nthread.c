@@ -0,0 +1,547 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nthread.h"
+#include "nmem.h"
+#include "nmem_pool.h"
+#include "nwait.h"
+
+#ifdef MODULE
+
+#include <linux/workqueue.h>
+
+#else /* ifndef MODULE */
+
+#include "nqueue.h"
+
+#ifdef _WIN32
+
+#define NTHREAD_TLS __declspec(thread)
+
+#else /* ifndef _WIN32 */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define NTHREAD_TLS __thread
+
+#endif /* ifndef _WIN32 */
+#endif /* ifndef MODULE */
+
+struct nthread_task {
+#ifdef MODULE
+	struct work_struct work;
+#endif /* ifdef MODULE */
+	nthread_fn fn;
+	void *ctx;
+	nthread_group_t *group;
+};
+
+static nmem_pool_t nthread_task_pool;
+
+static void nthread_run(struct nthread_task *task)
+{
+	nthread_group_t *group = task->group;
+
+	task->fn(task->ctx);
+	NMEM_POOL_FREE(&nthread_task_pool, task);
+
+	// The group may be gone once its count hits zero, waking is still safe
+	if (natomic32_fetch_add(&group->pending, (uint32_t)-1,
+				NATOMIC_ACQ_REL) == 1)
+		nwake_all(&group->pending);
+}
+
+#ifdef MODULE
+
+static struct workqueue_struct *nthread_wq = NULL;
+
+static void nthread_work_fn(struct work_struct *work)
+{
+	nthread_run(container_of(work, struct nthread_task, work));
+}
+
+NEPTUNE_API nerror_t nthread_init(void)
+{
+	if (HAS_ERR(nmem_pool_init(&nthread_task_pool, "nthread_task",
+				   sizeof(struct nthread_task))))
+		return GET_ERR(NTHREAD_ALLOC_ERROR);
+
+	nthread_wq = alloc_workqueue("neptune", WQ_UNBOUND, 0);
+	if (nthread_wq == NULL) {
+		nmem_pool_destroy(&nthread_task_pool);
+		return GET_ERR(NTHREAD_CREATE_ERROR);
+	}
+
+	return N_OK;
+}
+
+NEPTUNE_API void nthread_destroy(void)
+{
+	if (nthread_wq == NULL)
+		return;
+
+	destroy_workqueue(nthread_wq);
+	nthread_wq = NULL;
+
+	nmem_pool_destroy(&nthread_task_pool);
+}
+
+NEPTUNE_API size_t nthread_workers(void)
+{
+	return nthread_wq != NULL ? num_online_cpus() : 0;
+}
+
+NEPTUNE_API void nthread_submit(nthread_group_t *group, nthread_fn fn,
+				void *ctx)
+{
+	struct nthread_task *task = NULL;
+	if (nthread_wq != NULL)
+		task = NMEM_POOL_ALLOC(&nthread_task_pool);
+
+	if (task == NULL) {
+		fn(ctx);
+		return;
+	}
+
+	task->fn = fn;
+	task->ctx = ctx;
+	task->group = group;
+	natomic32_fetch_add(&group->pending, 1, NATOMIC_RELAXED);
+
+	INIT_WORK(&task->work, nthread_work_fn);
+	queue_work(nthread_wq, &task->work);
+}
+
+NEPTUNE_API void nthread_wait(nthread_group_t *group)
+{
+	uint32_t pending;
+	while ((pending = natomic32_load(&group->pending, NATOMIC_ACQUIRE)) !=
+	       0)
+		nwait_on_address(&group->pending, pending);
+}
+
+#else /* ifndef MODULE */
+
+#define NTHREAD_DEQUE_MASK (NTHREAD_DEQUE_SIZE - 1)
+
+// Chase-Lev deque: the owner pushes and pops at bottom, thieves take top
+struct nthread_deque {
+	natomic64_t top;
+	NMEM_CACHE_PAD(top_pad, sizeof(natomic64_t));
+	natomic64_t bottom;
+	NMEM_CACHE_PAD(bottom_pad, sizeof(natomic64_t));
+	natomic_ptr_t tasks[NTHREAD_DEQUE_SIZE];
+};
+
+struct NMEM_CACHE_ALIGNED nthread_worker {
+	struct nthread_deque deque;
+	uint32_t seed; // Victim selection state
+#ifdef _WIN32
+	HANDLE thread;
+#else /* ifndef _WIN32 */
+	pthread_t thread;
+#endif /* ifndef _WIN32 */
+};
+
+static struct nthread_worker *nthread_pool = NULL;
+static size_t nthread_count = 0; // Deques, fixed while workers run
+static size_t nthread_running = 0; // Workers started
+
+static NTHREAD_TLS struct nthread_worker *nthread_self;
+
+// Tasks submitted by threads outside the pool
+static nmpmc_t nthread_queue;
+
+// Bumped on every submit, sleepers go back to work when it moved
+static natomic32_t nthread_epoch = NATOMIC32_INIT(0);
+static natomic32_t nthread_sleepers = NATOMIC32_INIT(0);
+static natomic32_t nthread_stopping = NATOMIC32_INIT(0);
+
+static bool nthread_deque_push(struct nthread_deque *deque,
+			       struct nthread_task *task)
+{
+	uint64_t bottom = natomic64_load(&deque->bottom, NATOMIC_RELAXED);
+	uint64_t top = natomic64_load(&deque->top, NATOMIC_ACQUIRE);
+	if (bottom - top >= NTHREAD_DEQUE_SIZE)
+		return false;
+
+	natomic_ptr_store(&deque->tasks[bottom & NTHREAD_DEQUE_MASK], task,
+			  NATOMIC_RELAXED);
+	natomic64_store(&deque->bottom, bottom + 1, NATOMIC_RELEASE);
+	return true;
+}
+
+static struct nthread_task *nthread_deque_pop(struct nthread_deque *deque)
+{
+	uint64_t bottom = natomic64_load(&deque->bottom, NATOMIC_RELAXED) - 1;
+	natomic64_store(&deque->bottom, bottom, NATOMIC_RELAXED);
+	natomic_fence(NATOMIC_SEQ_CST);
+	uint64_t top = natomic64_load(&deque->top, NATOMIC_RELAXED);
+
+	int64_t left = (int64_t)(bottom - top);
+	if (left < 0) {
+		natomic64_store(&deque->bottom, bottom + 1, NATOMIC_RELAXED);
+		return NULL;
+	}
+
+	struct nthread_task *task = natomic_ptr_load(
+		&deque->tasks[bottom & NTHREAD_DEQUE_MASK], NATOMIC_RELAXED);
+	if (left > 0)
+		return task;
+
+	// The last task, thieves may be after it too
+	if (!natomic64_cas(&deque->top, &top, top + 1, NATOMIC_SEQ_CST))
+		task = NULL;
+
+	natomic64_store(&deque->bottom, bottom + 1, NATOMIC_RELAXED);
+	return task;
+}
+
+static struct nthread_task *nthread_deque_steal(struct nthread_deque *deque)
+{
+	uint64_t top = natomic64_load(&deque->top, NATOMIC_ACQUIRE);
+	natomic_fence(NATOMIC_SEQ_CST);
+	uint64_t bottom = natomic64_load(&deque->bottom, NATOMIC_ACQUIRE);
+
+	if ((int64_t)(bottom - top) <= 0)
+		return NULL;
+
+	struct nthread_task *task = natomic_ptr_load(
+		&deque->tasks[top & NTHREAD_DEQUE_MASK], NATOMIC_RELAXED);
+	if (!natomic64_cas(&deque->top, &top, top + 1, NATOMIC_SEQ_CST))
+		return NULL;
+
+	return task;
+}
+
+// Own deque first, then the shared queue, then the other workers
+static struct nthread_task *nthread_find(struct nthread_worker *self)
+{
+	struct nthread_task *task;
+
+	if (self != NULL) {
+		task = nthread_deque_pop(&self->deque);
+		if (task != NULL)
+			return task;
+	}
+
+	void *item;
+	if (nmpmc_pop(&nthread_queue, &item))
+		return item;
+
+	size_t start = 0;
+	if (self != NULL) {
+		self->seed ^= self->seed << 13;
+		self->seed ^= self->seed >> 17;
+		self->seed ^= self->seed << 5;
+		start = self->seed % nthread_count;
+	}
+
+	size_t i;
+	for (i = 0; i < nthread_count; i++) {
+		struct nthread_worker *victim =
+			&nthread_pool[(start + i) % nthread_count];
+		if (victim == self)
+			continue;
+
+		task = nthread_deque_steal(&victim->deque);
+		if (task != NULL)
+			return task;
+	}
+
+	return NULL;
+}
+
+static void nthread_notify(void)
+{
+	natomic32_fetch_add(&nthread_epoch, 1, NATOMIC_SEQ_CST);
+	if (natomic32_load(&nthread_sleepers, NATOMIC_SEQ_CST) != 0)
+		nwake(&nthread_epoch);
+}
+
+static void nthread_work(struct nthread_worker *self)
+{
+	nthread_self = self;
+
+	while (true) {
+		// Read before searching, a submit after the search moves it
+		uint32_t epoch = natomic32_load(&nthread_epoch, NATOMIC_SEQ_CST);
+
+		struct nthread_task *task = nthread_find(self);
+		if (task != NULL) {
+			nthread_run(task);
+			continue;
+		}
+
+		if (natomic32_load(&nthread_stopping, NATOMIC_ACQUIRE) != 0)
+			break;
+
+		// Pairs with nthread_notify bumping the epoch then reading this
+		natomic32_fetch_add(&nthread_sleepers, 1, NATOMIC_SEQ_CST);
+		if (natomic32_load(&nthread_epoch, NATOMIC_SEQ_CST) == epoch)
+			nwait_on_address(&nthread_epoch, epoch);
+		natomic32_fetch_add(&nthread_sleepers, (uint32_t)-1,
+				    NATOMIC_RELAXED);
+	}
+
+	nthread_self = NULL;
+}
+
+#ifdef _WIN32
+
+static DWORD WINAPI nthread_worker_main(LPVOID param)
+{
+	nthread_work(param);
+	return 0;
+}
+
+#else /* ifndef _WIN32 */
+
+static void *nthread_worker_main(void *param)
+{
+	nthread_work(param);
+	return NULL;
+}
+
+#endif /* ifndef _WIN32 */
+
+static size_t nthread_cpu_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else /* ifndef _WIN32 */
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (size_t)count : 1;
+#endif /* ifndef _WIN32 */
+}
+
+NEPTUNE_API nerror_t nthread_init(void)
+{
+	size_t count = NTHREAD_WORKERS;
+	if (count == 0)
+		count = nthread_cpu_count();
+
+	if (count > NTHREAD_MAX_WORKERS)
+		count = NTHREAD_MAX_WORKERS;
+
+	if (HAS_ERR(nmem_pool_init(&nthread_task_pool, "nthread_task",
+				   sizeof(struct nthread_task))))
+		return GET_ERR(NTHREAD_ALLOC_ERROR);
+
+	if (HAS_ERR(nmpmc_init(&nthread_queue, NTHREAD_QUEUE_SIZE))) {
+		nmem_pool_destroy(&nthread_task_pool);
+		return GET_ERR(NTHREAD_ALLOC_ERROR);
+	}
+
+	nthread_pool = N_ALLOC_ALIGNED(count * sizeof(struct nthread_worker),
+				       NMEM_CACHE_LINE);
+	if (nthread_pool == NULL) {
+		nmpmc_destroy(&nthread_queue);
+		nmem_pool_destroy(&nthread_task_pool);
+		return GET_ERR(NTHREAD_ALLOC_ERROR);
+	}
+
+	memset(nthread_pool, 0, count * sizeof(struct nthread_worker));
+	natomic32_store(&nthread_stopping, 0, NATOMIC_RELAXED);
+
+	// Workers steal from each other, all deques must exist first
+	size_t i;
+	for (i = 0; i < count; i++)
+		nthread_pool[i].seed = (uint32_t)(i * 0x9e3779b9u) | 1;
+
+	nthread_count = count;
+
+	size_t started;
+	for (started = 0; started < count; started++) {
+		struct nthread_worker *worker = &nthread_pool[started];
+#ifdef _WIN32
+		worker->thread = CreateThread(NULL, 0, nthread_worker_main,
+					      worker, 0, NULL);
+		if (worker->thread == NULL)
+			break;
+#else /* ifndef _WIN32 */
+		if (pthread_create(&worker->thread, NULL, nthread_worker_main,
+				   worker) != 0)
+			break;
+#endif /* ifndef _WIN32 */
+	}
+
+	if (started == 0) {
+		nthread_count = 0;
+		N_FREE_ALIGNED(nthread_pool);
+		nthread_pool = NULL;
+		nmpmc_destroy(&nthread_queue);
+		nmem_pool_destroy(&nthread_task_pool);
+		return GET_ERR(NTHREAD_CREATE_ERROR);
+	}
+
+	// Workers that did not start keep empty deques, stealing skips them
+	nthread_running = started;
+	return N_OK;
+}
+
+NEPTUNE_API void nthread_destroy(void)
+{
+	if (nthread_pool == NULL)
+		return;
+
+	natomic32_store(&nthread_stopping, 1, NATOMIC_RELEASE);
+	natomic32_fetch_add(&nthread_epoch, 1, NATOMIC_SEQ_CST);
+	nwake_all(&nthread_epoch);
+
+	size_t i;
+	for (i = 0; i < nthread_running; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(nthread_pool[i].thread, INFINITE);
+		CloseHandle(nthread_pool[i].thread);
+#else /* ifndef _WIN32 */
+		pthread_join(nthread_pool[i].thread, NULL);
+#endif /* ifndef _WIN32 */
+	}
+
+	nthread_running = 0;
+	nthread_count = 0;
+	N_FREE_ALIGNED(nthread_pool);
+	nthread_pool = NULL;
+
+	nmpmc_destroy(&nthread_queue);
+	nmem_pool_destroy(&nthread_task_pool);
+}
+
+NEPTUNE_API size_t nthread_workers(void)
+{
+	return nthread_running;
+}
+
+NEPTUNE_API void nthread_submit(nthread_group_t *group, nthread_fn fn,
+				void *ctx)
+{
+	struct nthread_task *task = NULL;
+	if (nthread_running != 0)
+		task = NMEM_POOL_ALLOC(&nthread_task_pool);
+
+	if (task == NULL) {
+		fn(ctx);
+		return;
+	}
+
+	task->fn = fn;
+	task->ctx = ctx;
+	task->group = group;
+	natomic32_fetch_add(&group->pending, 1, NATOMIC_RELAXED);
+
+	struct nthread_worker *self = nthread_self;
+	bool queued = self != NULL ? nthread_deque_push(&self->deque, task) :
+				     nmpmc_push(&nthread_queue, task);
+	if (!queued) {
+		nthread_run(task);
+		return;
+	}
+
+	nthread_notify();
+}
+
+NEPTUNE_API void nthread_wait(nthread_group_t *group)
+{
+	struct nthread_worker *self = nthread_self;
+
+	uint32_t pending;
+	while ((pending = natomic32_load(&group->pending, NATOMIC_ACQUIRE)) !=
+	       0) {
+		struct nthread_task *task = nthread_find(self);
+		if (task != NULL) {
+			nthread_run(task);
+			continue;
+		}
+
+		// Nothing left to help with, the rest is running elsewhere
+		nwait_on_address(&group->pending, pending);
+	}
+}
+
+#endif /* ifndef MODULE */
+
+struct nthread_for {
+	natomic64_t next; // First index not handed out yet
+	uint64_t end;
+	uint64_t grain;
+	nthread_range_fn fn;
+	void *ctx;
+};
+
+static void nthread_for_run(void *param)
+{
+	struct nthread_for *loop = param;
+
+	while (true) {
+		uint64_t begin = natomic64_fetch_add(&loop->next, loop->grain,
+						     NATOMIC_RELAXED);
+		if (begin >= loop->end)
+			break;
+
+		uint64_t end = loop->end - begin > loop->grain ?
+				       begin + loop->grain :
+				       loop->end;
+		loop->fn(loop->ctx, (size_t)begin, (size_t)end);
+	}
+}
+
+NEPTUNE_API void nthread_parallel_for(size_t begin, size_t end, size_t grain,
+				      nthread_range_fn fn, void *ctx)
+{
+	if (begin >= end)
+		return;
+
+	size_t workers = nthread_workers();
+	size_t length = end - begin;
+
+	// Several chunks per thread leave room for balancing
+	if (grain == 0)
+		grain = length / ((workers + 1) * 8);
+	if (grain == 0)
+		grain = 1;
+
+	size_t helpers = (length - 1) / grain;
+	if (helpers > workers)
+		helpers = workers;
+
+	struct nthread_for loop;
+	natomic64_store(&loop.next, begin, NATOMIC_RELAXED);
+	loop.end = end;
+	loop.grain = grain;
+	loop.fn = fn;
+	loop.ctx = ctx;
+
+	nthread_group_t group = NTHREAD_GROUP_INIT;
+
+	size_t i;
+	for (i = 0; i < helpers; i++)
+		nthread_submit(&group, nthread_for_run, &loop);
+
+	nthread_for_run(&loop);
+	nthread_wait(&group);
+}
@@ -26,8 +26,15 @@
 
 ntime_t ntime_start;
 
-#ifndef MODULE
+#ifdef MODULE
+#include <linux/timekeeping.h>
+#else /* ifndef MODULE */
 #include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif /* ifdef _WIN32 */
+
 #endif /* ifndef MODULE */
 
 NEPTUNE_API nerror_t ntime_init(void)
@@ -57,6 +64,36 @@ NEPTUNE_API ntime_t ntime_get_elapsed(void)
 	return ntime_get_unix() - ntime_start;
 }
 
+NEPTUNE_API ntime_t ntime_get_nsec(void)
+{
+#ifdef MODULE
+
+	return (ntime_t)ktime_get_ns();
+
+#elif defined(_WIN32)
+
+	static LARGE_INTEGER frequency;
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	// Split to keep counter * 1e9 from overflowing
+	ntime_t ticks = (ntime_t)counter.QuadPart;
+	ntime_t freq = (ntime_t)frequency.QuadPart;
+	return (ticks / freq) * 1000000000ull +
+	       (ticks % freq) * 1000000000ull / freq;
+
+#else /* if !defined(MODULE) && !defined(_WIN32) */
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ntime_t)ts.tv_sec * 1000000000ull + (ntime_t)ts.tv_nsec;
+
+#endif /* if !defined(MODULE) && !defined(_WIN32) */
+}
+
 NEPTUNE_API void ntime_get_elapsed_str(char *str)
 {
 	ntime_t sec = ntime_get_elapsed();
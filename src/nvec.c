@@ -0,0 +1,63 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nvec.h"
+
+NEPTUNE_API void *nvec_grow(void *data, const void *inline_data,
+			    size_t length, size_t element_size,
+			    size_t *capacity, size_t min_capacity)
+{
+	size_t max_capacity = (size_t)-1 / element_size;
+	if (min_capacity > max_capacity)
+		return NULL;
+
+	// Doubling keeps the total copy cost linear in the final length
+	size_t new_capacity = *capacity < NVEC_MIN_CAPACITY ?
+				      NVEC_MIN_CAPACITY :
+				      *capacity;
+	while (new_capacity < min_capacity)
+		new_capacity = new_capacity > max_capacity / 2 ?
+				       max_capacity :
+				       new_capacity * 2;
+
+	void *new_data;
+	if (data != NULL && data == inline_data) {
+		new_data = N_ALLOC(new_capacity * element_size);
+		if (new_data != NULL)
+			memcpy(new_data, data, length * element_size);
+	} else {
+		new_data = N_REALLOC(data, new_capacity * element_size);
+	}
+
+	if (new_data != NULL)
+		*capacity = new_capacity;
+
+	return new_data;
+}
+
+NEPTUNE_API void nvec_release(void *data, const void *inline_data)
+{
+	if (data != NULL && data != inline_data)
+		N_FREE(data);
+}
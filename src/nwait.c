@@ -0,0 +1,201 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "nwait.h"
+
+#ifdef MODULE
+
+#include <linux/wait_bit.h>
+
+NEPTUNE_API void nwait_on_address(natomic32_t *address, uint32_t expected)
+{
+	wait_var_event(address,
+		       natomic32_load(address, NATOMIC_ACQUIRE) != expected);
+}
+
+NEPTUNE_API void nwake(natomic32_t *address)
+{
+	// wake_up_var needs the new value visible before it checks waiters
+	smp_mb();
+	wake_up_var(address);
+}
+
+NEPTUNE_API void nwake_all(natomic32_t *address)
+{
+	smp_mb();
+	wake_up_var(address);
+}
+
+#elif defined(_WIN32) /* ifdef MODULE */
+
+#ifdef _MSC_VER
+#pragma comment(lib, "synchronization")
+#endif /* ifdef _MSC_VER */
+
+NEPTUNE_API void nwait_on_address(natomic32_t *address, uint32_t expected)
+{
+	WaitOnAddress((volatile VOID *)address, &expected, sizeof(expected),
+		      INFINITE);
+}
+
+NEPTUNE_API void nwake(natomic32_t *address)
+{
+	WakeByAddressSingle((PVOID)address);
+}
+
+NEPTUNE_API void nwake_all(natomic32_t *address)
+{
+	WakeByAddressAll((PVOID)address);
+}
+
+#elif defined(__linux__) /* ifdef MODULE */
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+NEPTUNE_API void nwait_on_address(natomic32_t *address, uint32_t expected)
+{
+	syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL,
+		0);
+}
+
+NEPTUNE_API void nwake(natomic32_t *address)
+{
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+NEPTUNE_API void nwake_all(natomic32_t *address)
+{
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL,
+		0);
+}
+
+#else /* ifdef MODULE */
+
+// Addresses share buckets, so every wake is a broadcast
+#define NWAIT_BUCKETS 64
+
+struct nwait_bucket {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+static struct nwait_bucket nwait_buckets[NWAIT_BUCKETS];
+static pthread_once_t nwait_once = PTHREAD_ONCE_INIT;
+
+static void nwait_init_buckets(void)
+{
+	size_t i;
+	for (i = 0; i < NWAIT_BUCKETS; i++) {
+		pthread_mutex_init(&nwait_buckets[i].mutex, NULL);
+		pthread_cond_init(&nwait_buckets[i].cond, NULL);
+	}
+}
+
+static struct nwait_bucket *nwait_bucket(natomic32_t *address)
+{
+	pthread_once(&nwait_once, nwait_init_buckets);
+	return &nwait_buckets[((uintptr_t)address >> 2) % NWAIT_BUCKETS];
+}
+
+NEPTUNE_API void nwait_on_address(natomic32_t *address, uint32_t expected)
+{
+	struct nwait_bucket *bucket = nwait_bucket(address);
+
+	pthread_mutex_lock(&bucket->mutex);
+	if (natomic32_load(address, NATOMIC_ACQUIRE) == expected)
+		pthread_cond_wait(&bucket->cond, &bucket->mutex);
+	pthread_mutex_unlock(&bucket->mutex);
+}
+
+NEPTUNE_API void nwake(natomic32_t *address)
+{
+	nwake_all(address);
+}
+
+NEPTUNE_API void nwake_all(natomic32_t *address)
+{
+	struct nwait_bucket *bucket = nwait_bucket(address);
+
+	pthread_mutex_lock(&bucket->mutex);
+	pthread_cond_broadcast(&bucket->cond);
+	pthread_mutex_unlock(&bucket->mutex);
+}
+
+#endif /* ifdef MODULE */
+
+NEPTUNE_API void nevent_set(nevent_t *event)
+{
+	if (natomic32_exchange(&event->state, 1, NATOMIC_ACQ_REL) == 2)
+		nwake_all(&event->state);
+}
+
+NEPTUNE_API void nevent_reset(nevent_t *event)
+{
+	uint32_t set = 1;
+	natomic32_cas(&event->state, &set, 0, NATOMIC_RELAXED);
+}
+
+NEPTUNE_API void nevent_wait(nevent_t *event)
+{
+	uint32_t state = natomic32_load(&event->state, NATOMIC_ACQUIRE);
+
+	while (state != 1) {
+		// Mark the event so that nevent_set knows to wake someone
+		if (state == 0 && !natomic32_cas(&event->state, &state, 2,
+						 NATOMIC_ACQUIRE))
+			continue;
+
+		nwait_on_address(&event->state, 2);
+		state = natomic32_load(&event->state, NATOMIC_ACQUIRE);
+	}
+}
+
+NEPTUNE_API uint32_t ncond_prepare(ncond_t *cond)
+{
+	natomic32_fetch_add(&cond->waiters, 1, NATOMIC_SEQ_CST);
+	return natomic32_load(&cond->sequence, NATOMIC_SEQ_CST);
+}
+
+NEPTUNE_API void ncond_park(ncond_t *cond, uint32_t sequence)
+{
+	nwait_on_address(&cond->sequence, sequence);
+	natomic32_fetch_add(&cond->waiters, (uint32_t)-1, NATOMIC_RELAXED);
+}
+
+NEPTUNE_API void ncond_signal(ncond_t *cond)
+{
+	natomic32_fetch_add(&cond->sequence, 1, NATOMIC_SEQ_CST);
+	if (natomic32_load(&cond->waiters, NATOMIC_SEQ_CST) != 0)
+		nwake(&cond->sequence);
+}
+
+NEPTUNE_API void ncond_broadcast(ncond_t *cond)
+{
+	natomic32_fetch_add(&cond->sequence, 1, NATOMIC_SEQ_CST);
+	if (natomic32_load(&cond->waiters, NATOMIC_SEQ_CST) != 0)
+		nwake_all(&cond->sequence);
+}
@@ -0,0 +1,610 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * nfile I/O benchmark.
+ *
+ * Measures sequential and random reads and writes through each nfile path
+ * next to the raw system calls they wrap, over a range of block sizes and
+ * thread counts, on every directory given (tmpfs and a local disk by
+ * default). Each run prints one JSON object per line:
+ *
+ *   {"dir":"/dev/shm","fs":"tmpfs","path":"positional","op":"rand_read",
+ *    "block":4096,"threads":4,"bytes":..,"seconds":..,"mb_s":..,"iops":..,
+ *    "p50_us":..,"p90_us":..,"p99_us":..,"p999_us":..,"max_us":..}
+ *
+ * Paths:
+ * - stdio: nfile_read / nfile_write on the stream, nfile_write_o for random
+ *   writes; one thread since the stream position is shared.
+ * - positional: nfile_read_o.
+ * - mapped: copies out of a file mapped by nfile_read_all; skipped when the
+ *   size is below NFILE_READ_ALL_MAP_SIZE, since the file is then copied.
+ * - stream: nfile_stream_write.
+ * - raw / raw_vectored: pread, pwrite, preadv and pwritev on a descriptor,
+ *   the baseline the wrappers are compared with.
+ *
+ * Reads run against a warm page cache.
+ *
+ * Usage: bench_nfile [-s size_mib] [-b block]... [-t threads]... [-d dir]...
+ */
+
+#include "neptune.h"
+#include "nfile.h"
+#include "nfile_stream.h"
+#include "ntime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int main()
+{
+	printf("bench_nfile is not supported on this platform\n");
+	return EXIT_SUCCESS;
+}
+
+#else /* ifndef _WIN32 */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#define BENCH_MAX_LIST 16
+#define BENCH_MAX_THREADS 64
+#define BENCH_VECTOR_COUNT 4
+#define BENCH_TMPFS_MAGIC 0x01021994
+
+struct bench_run;
+struct bench_thread;
+
+typedef ssize_t (*bench_op_fn)(struct bench_thread *thread, uint64_t offset);
+
+struct bench_path {
+	const char *name;
+	bench_op_fn read;
+	bench_op_fn rand_read;
+	bench_op_fn write;
+	bench_op_fn rand_write;
+	bool threaded; // false when the path shares a stream position
+	bool fd; // Uses a raw descriptor instead of an nfile
+};
+
+struct bench_run {
+	const struct bench_path *path;
+	const char *file_path;
+	bench_op_fn op;
+	bool random;
+
+	uint64_t file_size;
+	size_t block;
+	size_t threads;
+
+	int fd;
+	nfile_t file;
+	nfile_data_t mapped;
+	nfile_stream_t stream;
+};
+
+struct bench_thread {
+	struct bench_run *run;
+	pthread_t id;
+
+	uint64_t first; // First offset of the sequential region
+	size_t ops;
+	uint64_t seed;
+
+	char *buffer;
+	ntime_t *latency;
+	bool failed;
+};
+
+static ssize_t bench_stdio_read(struct bench_thread *thread, uint64_t offset)
+{
+	return nfile_read(thread->run->file, thread->buffer,
+			  (ssize_t)thread->run->block);
+}
+
+static ssize_t bench_stdio_write(struct bench_thread *thread, uint64_t offset)
+{
+	return nfile_write(thread->run->file, thread->buffer,
+			   (ssize_t)thread->run->block);
+}
+
+static ssize_t bench_stdio_write_o(struct bench_thread *thread, uint64_t offset)
+{
+	return nfile_write_o(thread->run->file, (ssize_t)offset, thread->buffer,
+			     (ssize_t)thread->run->block);
+}
+
+static ssize_t bench_positional_read(struct bench_thread *thread,
+				     uint64_t offset)
+{
+	return nfile_read_o(thread->run->file, (ssize_t)offset, thread->buffer,
+			    (ssize_t)thread->run->block);
+}
+
+static ssize_t bench_mapped_read(struct bench_thread *thread, uint64_t offset)
+{
+	memcpy(thread->buffer, (char *)thread->run->mapped.data + offset,
+	       thread->run->block);
+	return (ssize_t)thread->run->block;
+}
+
+static ssize_t bench_stream_write(struct bench_thread *thread, uint64_t offset)
+{
+	if (HAS_ERR(nfile_stream_write(&thread->run->stream, thread->buffer,
+				       thread->run->block)))
+		return -1;
+
+	return (ssize_t)thread->run->block;
+}
+
+static ssize_t bench_raw_read(struct bench_thread *thread, uint64_t offset)
+{
+	return pread(thread->run->fd, thread->buffer, thread->run->block,
+		     (off_t)offset);
+}
+
+static ssize_t bench_raw_write(struct bench_thread *thread, uint64_t offset)
+{
+	return pwrite(thread->run->fd, thread->buffer, thread->run->block,
+		      (off_t)offset);
+}
+
+static void bench_vector(struct bench_thread *thread, struct iovec *iov)
+{
+	size_t part = thread->run->block / BENCH_VECTOR_COUNT;
+
+	size_t i;
+	for (i = 0; i < BENCH_VECTOR_COUNT; i++) {
+		iov[i].iov_base = thread->buffer + i * part;
+		iov[i].iov_len = part;
+	}
+}
+
+static ssize_t bench_vector_read(struct bench_thread *thread, uint64_t offset)
+{
+	struct iovec iov[BENCH_VECTOR_COUNT];
+	bench_vector(thread, iov);
+
+	return preadv(thread->run->fd, iov, BENCH_VECTOR_COUNT, (off_t)offset);
+}
+
+static ssize_t bench_vector_write(struct bench_thread *thread, uint64_t offset)
+{
+	struct iovec iov[BENCH_VECTOR_COUNT];
+	bench_vector(thread, iov);
+
+	return pwritev(thread->run->fd, iov, BENCH_VECTOR_COUNT,
+		       (off_t)offset);
+}
+
+static const struct bench_path bench_paths[] = {
+	{ "stdio", bench_stdio_read, NULL, bench_stdio_write,
+	  bench_stdio_write_o, false, false },
+	{ "positional", bench_positional_read, bench_positional_read, NULL,
+	  NULL, true, false },
+	{ "mapped", bench_mapped_read, bench_mapped_read, NULL, NULL, true,
+	  false },
+	{ "stream", NULL, NULL, bench_stream_write, NULL, false, false },
+	{ "raw", bench_raw_read, bench_raw_read, bench_raw_write,
+	  bench_raw_write, true, true },
+	{ "raw_vectored", bench_vector_read, bench_vector_read,
+	  bench_vector_write, bench_vector_write, true, true },
+};
+
+static uint64_t bench_random(uint64_t *seed)
+{
+	uint64_t x = *seed;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*seed = x;
+	return x;
+}
+
+static void *bench_worker(void *param)
+{
+	struct bench_thread *thread = param;
+	struct bench_run *run = thread->run;
+	uint64_t blocks = run->file_size / run->block;
+
+	size_t i;
+	for (i = 0; i < thread->ops; i++) {
+		uint64_t offset = thread->first + i * run->block;
+		if (run->random)
+			offset = (bench_random(&thread->seed) % blocks) *
+				 run->block;
+
+		ntime_t start = ntime_get_nsec();
+		ssize_t ret = run->op(thread, offset);
+		thread->latency[i] = ntime_get_nsec() - start;
+
+		if (ret != (ssize_t)run->block) {
+			thread->failed = true;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+	ntime_t x = *(const ntime_t *)a;
+	ntime_t y = *(const ntime_t *)b;
+	return (x > y) - (x < y);
+}
+
+static double bench_percentile(const ntime_t *sorted, size_t count,
+			       double percentile)
+{
+	size_t index = (size_t)(percentile * (double)(count - 1));
+	return (double)sorted[index] / 1000.0;
+}
+
+// Fills the file with data so reads never hit a hole or the end
+static bool bench_prepare(const char *path, uint64_t size)
+{
+	struct stat st;
+	if (stat(path, &st) == 0 && (uint64_t)st.st_size == size &&
+	    (uint64_t)st.st_blocks * 512 >= size)
+		return true;
+
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+
+	char block[64 * 1024];
+	memset(block, 0x5a, sizeof(block));
+
+	uint64_t done = 0;
+	while (done < size) {
+		size_t length = sizeof(block);
+		if (size - done < length)
+			length = (size_t)(size - done);
+
+		ssize_t ret = write(fd, block, length);
+		if (ret <= 0) {
+			close(fd);
+			return false;
+		}
+
+		done += (uint64_t)ret;
+	}
+
+	close(fd);
+	return true;
+}
+
+static bool bench_open(struct bench_run *run, bool write)
+{
+	nfile_path_t path = (nfile_path_t)run->file_path;
+
+	if (run->path->fd) {
+		run->fd = write ? open(path, O_WRONLY | O_CREAT, 0644) :
+				  open(path, O_RDONLY);
+		return run->fd >= 0;
+	}
+
+	if (run->path->read == bench_mapped_read) {
+		if (HAS_ERR(nfile_read_all(path, NULL, &run->mapped)))
+			return false;
+
+		// A heap copy must not be reported under the mapped label
+		if (!run->mapped.mapped) {
+			fprintf(stderr, "%s was not mapped\n", run->file_path);
+			nfile_data_release(&run->mapped, NULL);
+			return false;
+		}
+
+		return true;
+	}
+
+	if (run->path->write == bench_stream_write)
+		return !HAS_ERR(nfile_stream_open(&run->stream, path, 0, 0));
+
+	run->file = write ? nfile_open_w(path) : nfile_open_r(path);
+	return run->file != NULL;
+}
+
+// Runs inside the timed region so buffered data is counted
+static bool bench_close(struct bench_run *run)
+{
+	if (run->path->fd)
+		return close(run->fd) == 0;
+
+	if (run->path->read == bench_mapped_read) {
+		nfile_data_release(&run->mapped, NULL);
+		return true;
+	}
+
+	if (run->path->write == bench_stream_write)
+		return !HAS_ERR(nfile_stream_close(&run->stream));
+
+	NFILE_FLUSH(run->file);
+	NFILE_CLOSE(run->file);
+	return true;
+}
+
+static void bench_report(const char *dir, const char *fs,
+			 const struct bench_run *run, const char *op,
+			 ntime_t elapsed, ntime_t *latency, size_t count)
+{
+	qsort(latency, count, sizeof(*latency), bench_compare);
+
+	double seconds = (double)elapsed / 1e9;
+	double bytes = (double)count * (double)run->block;
+
+	printf("{\"dir\":\"%s\",\"fs\":\"%s\",\"path\":\"%s\",\"op\":\"%s\","
+	       "\"block\":%zu,\"threads\":%zu,\"bytes\":%.0f,"
+	       "\"seconds\":%.6f,\"mb_s\":%.2f,\"iops\":%.0f,"
+	       "\"p50_us\":%.2f,\"p90_us\":%.2f,\"p99_us\":%.2f,"
+	       "\"p999_us\":%.2f,\"max_us\":%.2f}\n",
+	       dir, fs, run->path->name, op, run->block, run->threads, bytes,
+	       seconds, bytes / seconds / (1024.0 * 1024.0),
+	       (double)count / seconds,
+	       bench_percentile(latency, count, 0.50),
+	       bench_percentile(latency, count, 0.90),
+	       bench_percentile(latency, count, 0.99),
+	       bench_percentile(latency, count, 0.999),
+	       (double)latency[count - 1] / 1000.0);
+	fflush(stdout);
+}
+
+static bool bench_run(const char *dir, const char *fs, const char *file_path,
+		      const struct bench_path *path, const char *op,
+		      uint64_t file_size, size_t block, size_t threads)
+{
+	bool write = strstr(op, "write") != NULL;
+	bool random = strncmp(op, "rand", 4) == 0;
+
+	struct bench_run run;
+	memset(&run, 0, sizeof(run));
+
+	run.path = path;
+	run.file_path = file_path;
+	run.random = random;
+	run.file_size = file_size;
+	run.block = block;
+	run.threads = threads;
+
+	if (write)
+		run.op = random ? path->rand_write : path->write;
+	else
+		run.op = random ? path->rand_read : path->read;
+
+	if (run.op == NULL || (threads > 1 && !path->threaded))
+		return true;
+
+	if (!write && !bench_prepare(file_path, file_size))
+		return false;
+
+	size_t total = (size_t)(file_size / block);
+	size_t per_thread = total / threads;
+	if (per_thread == 0)
+		return true;
+
+	struct bench_thread workers[BENCH_MAX_THREADS];
+	ntime_t *latency = malloc(per_thread * threads * sizeof(*latency));
+	char *buffers = malloc(block * threads);
+	if (latency == NULL || buffers == NULL) {
+		free(latency);
+		free(buffers);
+		return false;
+	}
+
+	memset(buffers, 0xa5, block * threads);
+
+	size_t i;
+	for (i = 0; i < threads; i++) {
+		workers[i].run = &run;
+		workers[i].first = (uint64_t)i * per_thread * block;
+		workers[i].ops = per_thread;
+		workers[i].seed = 0x9e3779b97f4a7c15ull * (i + 1);
+		workers[i].buffer = buffers + i * block;
+		workers[i].latency = latency + i * per_thread;
+		workers[i].failed = false;
+	}
+
+	bool ok = bench_open(&run, write);
+	if (ok) {
+		ntime_t start = ntime_get_nsec();
+
+		size_t started = 0;
+		for (i = 1; i < threads; i++) {
+			if (pthread_create(&workers[i].id, NULL, bench_worker,
+					   &workers[i]) != 0)
+				break;
+
+			started++;
+		}
+
+		bench_worker(&workers[0]);
+
+		for (i = 1; i <= started; i++)
+			pthread_join(workers[i].id, NULL);
+
+		ok = bench_close(&run) && started + 1 == threads;
+		ntime_t elapsed = ntime_get_nsec() - start;
+
+		for (i = 0; i < threads; i++)
+			ok = ok && !workers[i].failed;
+
+		if (ok)
+			bench_report(dir, fs, &run, op, elapsed, latency,
+				     per_thread * threads);
+	}
+
+	free(latency);
+	free(buffers);
+	return ok;
+}
+
+static const char *bench_fs_name(const char *dir)
+{
+	struct statfs st;
+	if (statfs(dir, &st) != 0)
+		return "unknown";
+
+	return st.f_type == BENCH_TMPFS_MAGIC ? "tmpfs" : "local";
+}
+
+static bool bench_dir(const char *dir, uint64_t file_size,
+		      const size_t *blocks, size_t block_count,
+		      const size_t *threads, size_t thread_count)
+{
+	static const char *ops[] = { "seq_write", "rand_write", "seq_read",
+				     "rand_read" };
+
+	char file_path[4096];
+	snprintf(file_path, sizeof(file_path), "%s/bench_nfile.bin", dir);
+
+	const char *fs = bench_fs_name(dir);
+	bool ok = true;
+
+	size_t p, o, b, t;
+	for (p = 0; p < sizeof(bench_paths) / sizeof(*bench_paths); p++) {
+		// nfile_read_all copies files below the mapping threshold
+		if (bench_paths[p].read == bench_mapped_read &&
+		    (NFILE_READ_ALL_MAP_SIZE == 0 ||
+		     file_size < NFILE_READ_ALL_MAP_SIZE)) {
+			fprintf(stderr,
+				"mapped skipped in %s: files below %d bytes "
+				"are not mapped\n",
+				dir, NFILE_READ_ALL_MAP_SIZE);
+			continue;
+		}
+
+		for (o = 0; o < sizeof(ops) / sizeof(*ops); o++) {
+			for (b = 0; b < block_count; b++) {
+				for (t = 0; t < thread_count; t++) {
+					if (bench_run(dir, fs, file_path,
+						      &bench_paths[p], ops[o],
+						      file_size, blocks[b],
+						      threads[t]))
+						continue;
+
+					fprintf(stderr,
+						"%s %s block %zu threads %zu "
+						"failed in %s\n",
+						bench_paths[p].name, ops[o],
+						blocks[b], threads[t], dir);
+					ok = false;
+				}
+			}
+		}
+	}
+
+	unlink(file_path);
+	return ok;
+}
+
+static int bench_usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-s size_mib] [-b block]... [-t threads]... "
+		"[-d dir]...\n",
+		name);
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t file_size = 64ull * 1024 * 1024;
+
+	size_t blocks[BENCH_MAX_LIST];
+	size_t block_count = 0;
+
+	size_t threads[BENCH_MAX_LIST];
+	size_t thread_count = 0;
+
+	const char *dirs[BENCH_MAX_LIST];
+	size_t dir_count = 0;
+
+	int i;
+	for (i = 1; i < argc; i += 2) {
+		// Every flag takes a value
+		if (i + 1 == argc)
+			return bench_usage(argv[0]);
+
+		unsigned long long value = strtoull(argv[i + 1], NULL, 0);
+
+		if (strcmp(argv[i], "-s") == 0 && value != 0) {
+			file_size = value * 1024 * 1024;
+		} else if (strcmp(argv[i], "-b") == 0 &&
+			   block_count < BENCH_MAX_LIST &&
+			   value != 0 && value % BENCH_VECTOR_COUNT == 0) {
+			blocks[block_count++] = (size_t)value;
+		} else if (strcmp(argv[i], "-t") == 0 &&
+			   thread_count < BENCH_MAX_LIST && value != 0 &&
+			   value <= BENCH_MAX_THREADS) {
+			threads[thread_count++] = (size_t)value;
+		} else if (strcmp(argv[i], "-d") == 0 &&
+			   dir_count < BENCH_MAX_LIST) {
+			dirs[dir_count++] = argv[i + 1];
+		} else {
+			return bench_usage(argv[0]);
+		}
+	}
+
+	if (block_count == 0) {
+		blocks[block_count++] = 4 * 1024;
+		blocks[block_count++] = 64 * 1024;
+		blocks[block_count++] = 1024 * 1024;
+	}
+
+	if (thread_count == 0) {
+		threads[thread_count++] = 1;
+		threads[thread_count++] = 4;
+	}
+
+	if (dir_count == 0) {
+		if (access("/dev/shm", W_OK) == 0)
+			dirs[dir_count++] = "/dev/shm";
+
+		dirs[dir_count++] = ".";
+	}
+
+	if (HAS_ERR(neptune_init()))
+		return EXIT_FAILURE;
+
+	bool ok = true;
+
+	size_t d;
+	for (d = 0; d < dir_count; d++)
+		ok = bench_dir(dirs[d], file_size, blocks, block_count,
+			       threads, thread_count) &&
+		     ok;
+
+	neptune_destroy();
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif /* ifndef _WIN32 */
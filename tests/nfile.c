@@ -0,0 +1,800 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "neptune.h"
+#include "nfile.h"
+#include "nfile_append.h"
+#include "nfile_cache.h"
+#include "nfile_chunk.h"
+#include "nfile_dir.h"
+#include "nfile_line.h"
+#include "nfile_stream.h"
+#include "nmem.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else /* ifndef _WIN32 */
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* ifndef _WIN32 */
+
+#ifdef _WIN32
+#define TEST_PATH(path) L##path
+#define TEST_MKDIR(path) _wmkdir(path)
+#else /* ifndef _WIN32 */
+#define TEST_PATH(path) path
+#define TEST_MKDIR(path) mkdir(path, 0755)
+#endif /* ifndef _WIN32 */
+
+static int test_stat(void)
+{
+	nfile_path_t path = TEST_PATH("testnfile_stat.bin");
+	char data[] = "neptune nfile_stat check!";
+
+	nfile_t file = nfile_open_wr(path);
+	if (file == NULL)
+		return 10;
+
+	nfile_stat_t stat;
+	if (HAS_ERR(nfile_stat(file, &stat)) || stat.size != 0)
+		return 11;
+
+	nfile_write(file, data, sizeof(data));
+
+	// Write must invalidate a cached size
+	if (HAS_ERR(nfile_stat(file, &stat)) || stat.size != sizeof(data))
+		return 12;
+
+	if (nfile_get_length(file) != sizeof(data))
+		return 13;
+
+	if (stat.block_size == 0 || stat.mtime == 0)
+		return 14;
+
+	if (HAS_ERR(nfile_prealloc(file, 0, 1 << 20, true)) ||
+	    nfile_get_length(file) != sizeof(data))
+		return 15;
+
+	if (HAS_ERR(nfile_prealloc(file, 0, 8192, false)) ||
+	    nfile_get_length(file) != 8192)
+		return 16;
+
+	if (HAS_ERR(nfile_advise(file, 0, 0, NFILE_ADVICE_SEQUENTIAL)) ||
+	    HAS_ERR(nfile_readahead(file, 0, 8192)) ||
+	    HAS_ERR(nfile_advise(file, 0, 0, NFILE_ADVICE_DONTNEED)))
+		return 17;
+
+	NFILE_CLOSE(file);
+	return 0;
+}
+
+struct test_allocator {
+	size_t alloc_count;
+	size_t free_count;
+};
+
+static void *test_alloc(void *ctx, size_t size)
+{
+	((struct test_allocator *)ctx)->alloc_count++;
+	return N_ALLOC(size);
+}
+
+static void test_free(void *ctx, void *ptr)
+{
+	((struct test_allocator *)ctx)->free_count++;
+	N_FREE(ptr);
+}
+
+static int test_read_all(void)
+{
+	nfile_path_t path = TEST_PATH("testnfile_read_all.bin");
+	struct test_allocator counter = { 0 };
+	nmem_allocator_t allocator = { test_alloc, test_free, &counter };
+
+	size_t size = NFILE_READ_ALL_MAP_SIZE + 12345;
+	int8_t *expected = N_ALLOC(size);
+	if (expected == NULL)
+		return 20;
+
+	size_t i;
+	for (i = 0; i < size; i++)
+		expected[i] = (int8_t)(i * 31);
+
+	nfile_t file = nfile_open_w(path);
+	if (file == NULL) {
+		N_FREE(expected);
+		return 21;
+	}
+
+	nfile_write(file, expected, 4096);
+	NFILE_CLOSE(file);
+
+	// Small file: one exact allocation
+	nfile_data_t data;
+	if (HAS_ERR(nfile_read_all(path, &allocator, &data)) ||
+	    data.size != 4096 || data.mapped || counter.alloc_count != 1 ||
+	    memcmp(data.data, expected, data.size) != 0) {
+		N_FREE(expected);
+		return 22;
+	}
+
+	nfile_data_release(&data, &allocator);
+	if (counter.free_count != 1) {
+		N_FREE(expected);
+		return 23;
+	}
+
+	file = nfile_open_w(path);
+	nfile_write(file, expected, size);
+	NFILE_CLOSE(file);
+
+	// Large file: mapped where supported
+	nerror_t error = nfile_read_all(path, NULL, &data);
+	int ret = 0;
+	if (HAS_ERR(error) || data.size != size ||
+	    memcmp(data.data, expected, size) != 0)
+		ret = 24;
+
+	nfile_data_release(&data, NULL);
+	N_FREE(expected);
+
+#if !defined(_WIN32)
+	// procfs reports a zero size and must go through the growth path
+	if (ret == 0) {
+		if (HAS_ERR(nfile_read_all("/proc/self/status", NULL, &data)) ||
+		    data.size == 0 || memcmp(data.data, "Name:", 5) != 0)
+			ret = 25;
+
+		nfile_data_release(&data, NULL);
+	}
+#endif /* if !defined(_WIN32) */
+
+	return ret;
+}
+
+static int test_copy_range(void)
+{
+	nfile_path_t src_path = TEST_PATH("testnfile_copy_src.bin");
+	nfile_path_t dst_path = TEST_PATH("testnfile_copy_dst.bin");
+
+	size_t size = 3 * NFILE_COPY_CHUNK_SIZE + 17;
+	int8_t *expected = N_ALLOC(size);
+	if (expected == NULL)
+		return 30;
+
+	size_t i;
+	for (i = 0; i < size; i++)
+		expected[i] = (int8_t)(i * 7 + 3);
+
+	nfile_t src = nfile_open_wr(src_path);
+	nfile_t dst = nfile_open_wr(dst_path);
+	if (src == NULL || dst == NULL) {
+		N_FREE(expected);
+		return 31;
+	}
+
+	// Left in the stdio buffer on purpose, nfile_copy_range must flush it
+	nfile_write(src, expected, size);
+
+	int ret = 0;
+	size_t length = size - 100;
+	if (nfile_copy_range(src, 100, dst, 10, length) != length)
+		ret = 32;
+
+	// Asking for more than is left stops at end of file
+	if (ret == 0 && nfile_copy_range(src, size - 5, dst, 0, 100) != 5)
+		ret = 33;
+
+	NFILE_CLOSE(dst);
+
+	nfile_data_t data = { 0 };
+	if (ret == 0 && (HAS_ERR(nfile_read_all(dst_path, NULL, &data)) ||
+			 data.size != length + 10 ||
+			 memcmp((int8_t *)data.data + 10, expected + 100,
+				length) != 0))
+		ret = 34;
+
+	nfile_data_release(&data, NULL);
+
+	// Writing into a read-only handle fails before any byte is copied
+	nfile_t read_only = nfile_open_r(dst_path);
+	if (ret == 0 && (read_only == NULL ||
+			 nfile_copy_range(src, 0, read_only, 0, 100) != -1))
+		ret = 37;
+
+	if (read_only != NULL)
+		NFILE_CLOSE(read_only);
+
+#ifndef _WIN32
+	int socks[2];
+	if (ret == 0 && socketpair(AF_UNIX, SOCK_STREAM, 0, socks) == 0) {
+		if (nfile_send(src, 1, socks[0], 1000) != 1000)
+			ret = 35;
+
+		char buffer[1000];
+		if (ret == 0 &&
+		    (recv(socks[1], buffer, sizeof(buffer), MSG_WAITALL) !=
+			     sizeof(buffer) ||
+		     memcmp(buffer, expected + 1, sizeof(buffer)) != 0))
+			ret = 36;
+
+		close(socks[0]);
+		close(socks[1]);
+	}
+#endif /* ifndef _WIN32 */
+
+	NFILE_CLOSE(src);
+	N_FREE(expected);
+	return ret;
+}
+
+#define TEST_APPEND_THREADS 4
+#define TEST_APPEND_RECORDS 50
+
+static char test_append_record[] = "durable record!";
+
+#ifdef _WIN32
+static DWORD WINAPI test_append_worker(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_append_worker(void *param)
+#endif /* ifndef _WIN32 */
+{
+	nfile_appender_t *appender = param;
+
+	int i;
+	for (i = 0; i < TEST_APPEND_RECORDS; i++) {
+		bool durable = (i % 5) != 0;
+		nfile_append(appender, test_append_record,
+			     sizeof(test_append_record), durable);
+	}
+
+	return 0;
+}
+
+static int test_append(void)
+{
+	nfile_path_t path = TEST_PATH("testnfile_append.bin");
+
+	nfile_t file = nfile_open_w(path);
+	if (file == NULL)
+		return 40;
+
+	nfile_write(file, "head", 4);
+	NFILE_CLOSE(file);
+
+	nfile_appender_t appender;
+	if (HAS_ERR(nfile_appender_open(&appender, path)))
+		return 41;
+
+	int i;
+#ifdef _WIN32
+	HANDLE threads[TEST_APPEND_THREADS];
+	for (i = 0; i < TEST_APPEND_THREADS; i++)
+		threads[i] = CreateThread(NULL, 0, test_append_worker,
+					  &appender, 0, NULL);
+
+	WaitForMultipleObjects(TEST_APPEND_THREADS, threads, TRUE, INFINITE);
+	for (i = 0; i < TEST_APPEND_THREADS; i++)
+		CloseHandle(threads[i]);
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_APPEND_THREADS];
+	for (i = 0; i < TEST_APPEND_THREADS; i++)
+		pthread_create(&threads[i], NULL, test_append_worker,
+			       &appender);
+
+	for (i = 0; i < TEST_APPEND_THREADS; i++)
+		pthread_join(threads[i], NULL);
+#endif /* ifndef _WIN32 */
+
+	size_t expected = 4 + TEST_APPEND_THREADS * TEST_APPEND_RECORDS *
+				      sizeof(test_append_record);
+
+	if (appender.size != expected || appender.synced > expected) {
+		nfile_appender_close(&appender);
+		return 42;
+	}
+
+	nfile_appender_close(&appender);
+
+	nfile_data_t data;
+	if (HAS_ERR(nfile_read_all(path, NULL, &data)))
+		return 43;
+
+	int ret = 0;
+	if (data.size != expected || memcmp(data.data, "head", 4) != 0 ||
+	    memcmp((int8_t *)data.data + 4, test_append_record,
+		   sizeof(test_append_record)) != 0)
+		ret = 44;
+
+	nfile_data_release(&data, NULL);
+	return ret;
+}
+
+static int test_lines_check(nfile_line_iter_t *iter, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		nfile_slice_t line;
+		if (!nfile_line_next(iter, &line) || line.length != i % 200)
+			return 1;
+
+		size_t j;
+		for (j = 0; j < line.length; j++) {
+			if (line.data[j] != (char)('a' + (i + j) % 26))
+				return 2;
+		}
+	}
+
+	nfile_slice_t line;
+	if (nfile_line_next(iter, &line))
+		return 3;
+
+	return 0;
+}
+
+static int test_lines(void)
+{
+	nfile_path_t path = TEST_PATH("testnfile_lines.txt");
+	size_t count = 1000;
+
+	nfile_t file = nfile_open_wr(path);
+	if (file == NULL)
+		return 50;
+
+	// Line i holds i % 200 characters, the last one has no delimiter
+	size_t i;
+	for (i = 0; i < count; i++) {
+		size_t j;
+		for (j = 0; j < i % 200; j++) {
+			char c = (char)('a' + (i + j) % 26);
+			nfile_write(file, &c, 1);
+		}
+
+		if (i + 1 < count)
+			nfile_write(file, "\n", 1);
+	}
+
+	nfile_line_iter_t iter;
+	int ret = 0;
+
+	// Buffer smaller than the longest line forces growth and refills
+	if (HAS_ERR(nfile_line_iter_init_file(&iter, file, 64, '\n')))
+		ret = 51;
+	else if (test_lines_check(&iter, count) != 0)
+		ret = 52;
+	else if (HAS_ERR(nfile_line_iter_error(&iter)))
+		ret = 56;
+
+	nfile_line_iter_release(&iter);
+	NFILE_CLOSE(file);
+
+#ifndef _WIN32
+	// Reading a directory fails, which must not look like the end
+	nfile_t dir = nfile_open_r(".");
+	if (ret == 0 && dir != NULL) {
+		nfile_slice_t line;
+		if (HAS_ERR(nfile_line_iter_init_file(&iter, dir, 64, '\n')))
+			ret = 57;
+		else if (nfile_line_next(&iter, &line) ||
+			 !HAS_ERR(nfile_line_iter_error(&iter)))
+			ret = 58;
+
+		nfile_line_iter_release(&iter);
+	}
+
+	if (dir != NULL)
+		NFILE_CLOSE(dir);
+#endif /* ifndef _WIN32 */
+
+	if (ret == 0) {
+		if (HAS_ERR(nfile_line_iter_open(&iter, path, '\n')))
+			return 53;
+
+		if (test_lines_check(&iter, count) != 0)
+			ret = 54;
+
+		nfile_line_iter_release(&iter);
+	}
+
+	const char text[] = "\n\nx";
+	nfile_slice_t line;
+	nfile_line_iter_init(&iter, text, sizeof(text) - 1, '\n');
+	if (ret == 0 && (!nfile_line_next(&iter, &line) || line.length != 0 ||
+			 !nfile_line_next(&iter, &line) || line.length != 0 ||
+			 !nfile_line_next(&iter, &line) || line.length != 1 ||
+			 nfile_line_next(&iter, &line)))
+		ret = 55;
+
+	return ret;
+}
+
+struct test_chunk_ctx {
+	size_t lines;
+	size_t next_index;
+	bool bad_order;
+};
+
+static void *test_chunk_process(void *ctx, const char *data, size_t length,
+				size_t index)
+{
+	// Every chunk must start at a record and end after a delimiter
+	if (length > 0 && (data[0] != 'L' || data[length - 1] != '\n'))
+		return NULL;
+
+	size_t *lines = N_ALLOC(sizeof(size_t));
+	*lines = 0;
+
+	// Each record is "L<i>,<i * i>", so bytes from the wrong offset show
+	const char *ptr = data;
+	while (ptr < data + length) {
+		char *next;
+		if (ptr[0] != 'L' || !isdigit((unsigned char)ptr[1]))
+			break;
+
+		unsigned long long value = strtoull(ptr + 1, &next, 10);
+		if (next[0] != ',' || !isdigit((unsigned char)next[1]))
+			break;
+
+		if (strtoull(next + 1, &next, 10) != value * value ||
+		    next[0] != '\n')
+			break;
+
+		ptr = next + 1;
+		(*lines)++;
+	}
+
+	if (ptr != data + length) {
+		N_FREE(lines);
+		return NULL;
+	}
+
+	return lines;
+}
+
+static void test_chunk_merge(void *ctx, void *result, size_t index)
+{
+	struct test_chunk_ctx *chunk_ctx = ctx;
+
+	if (index != chunk_ctx->next_index++ || result == NULL)
+		chunk_ctx->bad_order = true;
+
+	if (result != NULL) {
+		chunk_ctx->lines += *(size_t *)result;
+		N_FREE(result);
+	}
+}
+
+static int test_chunk(void)
+{
+	nfile_path_t path = TEST_PATH("testnfile_chunk.txt");
+	size_t count = 50000;
+
+	nfile_t file = nfile_open_w(path);
+	if (file == NULL)
+		return 60;
+
+	size_t i;
+	for (i = 0; i < count; i++)
+		nfile_printf(file, "L%zu,%zu\n", i, i * i);
+
+	NFILE_CLOSE(file);
+
+	// With the test's NFILE_CHUNK_MAP_SIZE four threads get chunks small
+	// enough to be read into buffers, a single thread gets mapped ones
+	size_t threads[] = { 4, 1 };
+
+	for (i = 0; i < sizeof(threads) / sizeof(*threads); i++) {
+		struct test_chunk_ctx ctx = { 0 };
+		if (HAS_ERR(nfile_chunk_process(path, threads[i], '\n',
+						test_chunk_process,
+						test_chunk_merge, &ctx)))
+			return 61;
+
+		if (ctx.bad_order || ctx.lines != count || ctx.next_index < 2)
+			return 62;
+	}
+
+	return 0;
+}
+
+static int test_cache_write(const nfile_path_t path, const char *data)
+{
+	nfile_t file = nfile_open_w(path);
+	if (file == NULL)
+		return 1;
+
+	size_t len = strlen(data);
+	ssize_t written = nfile_write(file, data, len);
+	NFILE_CLOSE(file);
+
+	return written == (ssize_t)len ? 0 : 1;
+}
+
+static int test_cache(void)
+{
+	nfile_path_t paths[] = { TEST_PATH("testnfile_cache0.txt"),
+				 TEST_PATH("testnfile_cache1.txt"),
+				 TEST_PATH("testnfile_cache2.txt") };
+
+	size_t i;
+	for (i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+		if (test_cache_write(paths[i], "abc") != 0)
+			return 70;
+	}
+
+	nfile_cache_t cache;
+	if (HAS_ERR(nfile_cache_init(&cache, 2)))
+		return 71;
+
+	nfile_cache_entry_t *first = nfile_cache_acquire(&cache, paths[0]);
+	nfile_cache_entry_t *second = nfile_cache_acquire(&cache, paths[0]);
+	if (first == NULL || first != second)
+		return 72;
+
+	char buffer[8] = { 0 };
+	if (nfile_read_o(first->file, 0, buffer, 3) != 3 ||
+	    memcmp(buffer, "abc", 3) != 0)
+		return 73;
+
+	nfile_cache_release(&cache, first);
+	nfile_cache_release(&cache, second);
+
+	if (test_cache_write(paths[0], "abcdef") != 0)
+		return 74;
+
+	first = nfile_cache_acquire(&cache, paths[0]);
+	if (first == NULL || first->stat.size != 6 ||
+	    nfile_read_o(first->file, 3, buffer, 3) != 3 ||
+	    memcmp(buffer, "def", 3) != 0)
+		return 75;
+
+	nfile_cache_release(&cache, first);
+
+	for (i = 1; i < sizeof(paths) / sizeof(*paths); i++) {
+		first = nfile_cache_acquire(&cache, paths[i]);
+		if (first == NULL)
+			return 76;
+
+		nfile_cache_release(&cache, first);
+	}
+
+	if (cache.count != 2 || cache.lru_tail == NULL ||
+	    cache.lru_tail->stat.size != 3)
+		return 77;
+
+	if (nfile_cache_acquire(&cache, TEST_PATH("testnfile_missing.txt")) !=
+	    NULL)
+		return 78;
+
+	nfile_cache_destroy(&cache);
+	return 0;
+}
+
+struct test_dir_ctx {
+	size_t dirs;
+	size_t files;
+	size_t skipped;
+	bool prune;
+	NMUTEX mutex;
+};
+
+static bool test_dir_visit(void *ctx, const nfile_char_t *dir,
+			   const nfile_dir_entry_t *entry)
+{
+	struct test_dir_ctx *dir_ctx = ctx;
+	bool skip = entry->name[0] == 's';
+
+	NMUTEX_LOCK(dir_ctx->mutex);
+
+	if (entry->type == NFILE_DIR_TYPE_DIR)
+		dir_ctx->dirs++;
+	else if (entry->type == NFILE_DIR_TYPE_FILE)
+		dir_ctx->files++;
+
+	if (skip)
+		dir_ctx->skipped++;
+
+	NMUTEX_UNLOCK(dir_ctx->mutex);
+
+	return !(skip && dir_ctx->prune);
+}
+
+static int test_dir(void)
+{
+	nfile_path_t dirs[] = { TEST_PATH("testnfile_dir"),
+				TEST_PATH("testnfile_dir/a"),
+				TEST_PATH("testnfile_dir/a/b"),
+				TEST_PATH("testnfile_dir/c"),
+				TEST_PATH("testnfile_dir/skip") };
+	nfile_path_t files[] = { TEST_PATH("testnfile_dir/0.txt"),
+				 TEST_PATH("testnfile_dir/a/1.txt"),
+				 TEST_PATH("testnfile_dir/a/b/2.txt"),
+				 TEST_PATH("testnfile_dir/a/b/3.txt"),
+				 TEST_PATH("testnfile_dir/c/4.txt"),
+				 TEST_PATH("testnfile_dir/skip/5.txt") };
+
+	size_t i;
+	for (i = 0; i < sizeof(dirs) / sizeof(*dirs); i++)
+		TEST_MKDIR(dirs[i]);
+
+	for (i = 0; i < sizeof(files) / sizeof(*files); i++) {
+		nfile_t file = nfile_open_w(files[i]);
+		if (file == NULL)
+			return 80;
+
+		NFILE_CLOSE(file);
+	}
+
+	struct test_dir_ctx ctx = { 0 };
+	NMUTEX_INIT(ctx.mutex);
+
+	if (HAS_ERR(nfile_dir_read(dirs[0], test_dir_visit, &ctx)))
+		return 81;
+
+	if (ctx.dirs != 3 || ctx.files != 1 || ctx.skipped != 1)
+		return 82;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.prune = true;
+	NMUTEX_INIT(ctx.mutex);
+
+	if (HAS_ERR(nfile_dir_walk(dirs[0], 4, test_dir_visit, &ctx)))
+		return 83;
+
+	if (ctx.dirs != 4 || ctx.files != 5 || ctx.skipped != 1)
+		return 84;
+
+	if (!HAS_ERR(nfile_dir_walk(TEST_PATH("testnfile_missing"), 2,
+				    test_dir_visit, &ctx)))
+		return 85;
+
+	return 0;
+}
+
+static int test_stream(void)
+{
+	nfile_path_t path = TEST_PATH("testnfile_stream.bin");
+	size_t window = 64 * 1024;
+	size_t dirty_limit = 256 * 1024;
+
+	nfile_stream_t stream;
+	if (HAS_ERR(nfile_stream_open(&stream, path, window, dirty_limit)))
+		return 90;
+
+	uint32_t block[1024];
+	size_t count = 512;
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		size_t j;
+		for (j = 0; j < sizeof(block) / sizeof(*block); j++)
+			block[j] = (uint32_t)(i * 1024 + j);
+
+		if (HAS_ERR(nfile_stream_write(&stream, block, sizeof(block))))
+			return 91;
+
+		if (stream.offset - stream.dropped > dirty_limit)
+			return 92;
+	}
+
+	if (stream.dropped == 0 || stream.started < stream.dropped)
+		return 93;
+
+	if (HAS_ERR(nfile_stream_close(&stream)))
+		return 94;
+
+	nfile_data_t data;
+	if (HAS_ERR(nfile_read_all(path, NULL, &data)))
+		return 95;
+
+	int ret = 0;
+	const uint32_t *words = data.data;
+	if (data.size != count * sizeof(block))
+		ret = 96;
+	else if (words[0] != 0 || words[count * 1024 - 1] != count * 1024 - 1)
+		ret = 97;
+
+	nfile_data_release(&data, NULL);
+	return ret;
+}
+
+int main()
+{
+	if (HAS_ERR(neptune_init()))
+		return EXIT_FAILURE;
+
+	int ret = test_stat();
+	if (ret != 0) {
+		printf("nfile_stat failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_read_all();
+	if (ret != 0) {
+		printf("nfile_read_all failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_copy_range();
+	if (ret != 0) {
+		printf("nfile_copy_range failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_append();
+	if (ret != 0) {
+		printf("nfile_append failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_lines();
+	if (ret != 0) {
+		printf("nfile_line failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_chunk();
+	if (ret != 0) {
+		printf("nfile_chunk failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_cache();
+	if (ret != 0) {
+		printf("nfile_cache failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_dir();
+	if (ret != 0) {
+		printf("nfile_dir failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_stream();
+	if (ret != 0) {
+		printf("nfile_stream failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	neptune_destroy();
+
+	printf("Everything is OK!!!\n");
+	return EXIT_SUCCESS;
+}
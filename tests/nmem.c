@@ -0,0 +1,655 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "neptune.h"
+#include "nmem.h"
+#include "nmem_arena.h"
+#include "nmem_pool.h"
+#include "nmem_tcache.h"
+#include "nmem_trace.h"
+#include "nstrbuf.h"
+#include "nvec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int test_arena(void)
+{
+	char inline_block[256];
+
+	nmem_arena_t arena;
+	NMEM_ARENA_INIT_INLINE(&arena, inline_block);
+
+	char *small = nmem_arena_alloc(&arena, 100);
+	if (small < inline_block || small + 100 > inline_block + 256)
+		return 10;
+
+	if ((uintptr_t)small % NMEM_ARENA_ALIGN != 0)
+		return 11;
+
+	nmem_arena_mark_t mark = nmem_arena_mark(&arena);
+
+	// Spills into heap chunks, one of them larger than a regular chunk
+	size_t i;
+	for (i = 0; i < 64; i++) {
+		char *buffer = nmem_arena_alloc(&arena, 4000);
+		if (buffer == NULL)
+			return 12;
+
+		memset(buffer, (int)i, 4000);
+	}
+
+	char *large = nmem_arena_alloc(&arena, NMEM_ARENA_CHUNK_SIZE * 2);
+	if (large == NULL || arena.chunk == NULL)
+		return 13;
+
+	memset(large, 0xff, NMEM_ARENA_CHUNK_SIZE * 2);
+
+	char *aligned = nmem_arena_alloc_aligned(&arena, 64, 4096);
+	if (aligned == NULL || (uintptr_t)aligned % 4096 != 0)
+		return 14;
+
+	nmem_arena_rewind(&arena, mark);
+	if (arena.chunk != NULL || arena.spare == NULL)
+		return 15;
+
+	char *again = nmem_arena_alloc(&arena, 100);
+	if (again != small + 112)
+		return 16;
+
+	nmem_allocator_t allocator = nmem_arena_allocator(&arena);
+	void *through = NMEM_ALLOCATOR_ALLOC(&allocator, 32);
+	if (through == NULL)
+		return 17;
+
+	NMEM_ALLOCATOR_FREE(&allocator, through);
+
+	nmem_arena_reset(&arena);
+	if (nmem_arena_alloc(&arena, 8) != inline_block)
+		return 18;
+
+	nmem_arena_destroy(&arena);
+
+	// Heap only arena
+	nmem_arena_init(&arena, NULL, 0, 1024);
+	for (i = 0; i < 100; i++) {
+		if (nmem_arena_alloc(&arena, 300) == NULL)
+			return 19;
+	}
+
+	nmem_arena_reset(&arena);
+	nmem_arena_destroy(&arena);
+
+	return 0;
+}
+
+#define TEST_POOL_THREADS 4
+#define TEST_POOL_OBJECTS 1000
+#define TEST_POOL_ROUNDS 200
+
+struct test_pool_object {
+	size_t owner;
+	size_t index;
+	char payload[40];
+};
+
+struct test_pool_worker {
+	nmem_pool_t *pool;
+	size_t id;
+	void **handoff; // Objects allocated by another thread to free here
+	size_t handoff_count;
+	bool failed;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI test_pool_run(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_pool_run(void *param)
+#endif /* ifndef _WIN32 */
+{
+	struct test_pool_worker *worker = param;
+	struct test_pool_object *objects[TEST_POOL_OBJECTS];
+
+	size_t i;
+	for (i = 0; i < worker->handoff_count; i++)
+		nmem_pool_free(worker->pool, worker->handoff[i]);
+
+	size_t round;
+	for (round = 0; round < TEST_POOL_ROUNDS; round++) {
+		size_t count = 1 + (round * 37) % TEST_POOL_OBJECTS;
+
+		for (i = 0; i < count; i++) {
+			objects[i] = nmem_pool_alloc(worker->pool);
+			if (objects[i] == NULL) {
+				worker->failed = true;
+				return 0;
+			}
+
+			objects[i]->owner = worker->id;
+			objects[i]->index = i;
+		}
+
+		for (i = 0; i < count; i++) {
+			if (objects[i]->owner != worker->id ||
+			    objects[i]->index != i)
+				worker->failed = true;
+
+			nmem_pool_free(worker->pool, objects[i]);
+		}
+	}
+
+	return 0;
+}
+
+static int test_pool(void)
+{
+	nmem_pool_t pool;
+	if (HAS_ERR(nmem_pool_init(&pool, "test_pool",
+				   sizeof(struct test_pool_object))))
+		return 20;
+
+	void *first = nmem_pool_alloc(&pool);
+	void *second = nmem_pool_alloc(&pool);
+	if (first == NULL || second == NULL || first == second ||
+	    (uintptr_t)first % NMEM_POOL_ALIGN != 0)
+		return 21;
+
+	nmem_pool_free(&pool, second);
+	if (nmem_pool_alloc(&pool) != second)
+		return 22;
+
+	nmem_pool_free(&pool, first);
+	nmem_pool_free(&pool, second);
+	nmem_pool_free(&pool, NULL);
+
+	static void *handoff[TEST_POOL_THREADS][TEST_POOL_OBJECTS];
+	struct test_pool_worker workers[TEST_POOL_THREADS];
+
+	size_t i, j;
+	for (i = 0; i < TEST_POOL_THREADS; i++) {
+		workers[i].pool = &pool;
+		workers[i].id = i;
+		workers[i].handoff = handoff[i];
+		workers[i].handoff_count = TEST_POOL_OBJECTS;
+		workers[i].failed = false;
+
+		for (j = 0; j < TEST_POOL_OBJECTS; j++) {
+			handoff[i][j] = nmem_pool_alloc(&pool);
+			if (handoff[i][j] == NULL)
+				return 23;
+		}
+	}
+
+#ifdef _WIN32
+	HANDLE threads[TEST_POOL_THREADS];
+	for (i = 0; i < TEST_POOL_THREADS; i++)
+		threads[i] = CreateThread(NULL, 0, test_pool_run, &workers[i],
+					  0, NULL);
+
+	WaitForMultipleObjects(TEST_POOL_THREADS, threads, TRUE, INFINITE);
+	for (i = 0; i < TEST_POOL_THREADS; i++)
+		CloseHandle(threads[i]);
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_POOL_THREADS];
+	for (i = 0; i < TEST_POOL_THREADS; i++)
+		pthread_create(&threads[i], NULL, test_pool_run, &workers[i]);
+
+	for (i = 0; i < TEST_POOL_THREADS; i++)
+		pthread_join(threads[i], NULL);
+#endif /* ifndef _WIN32 */
+
+	for (i = 0; i < TEST_POOL_THREADS; i++) {
+		if (workers[i].failed)
+			return 24;
+	}
+
+	// Every object went back, the live peak bounds what was carved
+	size_t peak = TEST_POOL_THREADS * TEST_POOL_OBJECTS * 2;
+	if ((size_t)pool.page_count * pool.page_objects >
+	    peak + pool.page_objects * (TEST_POOL_THREADS + 1))
+		return 25;
+
+	nmem_pool_destroy(&pool);
+	return 0;
+}
+
+#define TEST_TCACHE_THREADS 4
+#define TEST_TCACHE_BLOCKS 2000
+
+static void *test_tcache_blocks[TEST_TCACHE_THREADS][TEST_TCACHE_BLOCKS];
+
+#ifdef _WIN32
+static DWORD WINAPI test_tcache_run(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_tcache_run(void *param)
+#endif /* ifndef _WIN32 */
+{
+	size_t id = (size_t)param;
+	size_t next = (id + 1) % TEST_TCACHE_THREADS;
+
+	// Free what the neighbor allocated, then churn locally
+	size_t i;
+	for (i = 0; i < TEST_TCACHE_BLOCKS; i++)
+		nmem_tcache_free(test_tcache_blocks[next][i]);
+
+	for (i = 0; i < TEST_TCACHE_BLOCKS * 20; i++) {
+		size_t size = (i * 7919) % 3000;
+		unsigned char *block = nmem_tcache_alloc(size);
+		if (block == NULL)
+			return (void *)1;
+
+		memset(block, (int)id, size);
+		nmem_tcache_free(block);
+	}
+
+	return 0;
+}
+
+static int test_tcache(void)
+{
+	size_t size;
+	for (size = 0; size <= 70000; size += size < 512 ? 1 : 97) {
+		unsigned char *block = nmem_tcache_alloc(size);
+		if (block == NULL || (uintptr_t)block % (2 * sizeof(void *)))
+			return 30;
+
+		memset(block, 0xab, size);
+
+		unsigned char *grown = nmem_tcache_realloc(block, size * 2 + 1);
+		if (grown == NULL)
+			return 31;
+
+		size_t i;
+		for (i = 0; i < size; i++) {
+			if (grown[i] != 0xab)
+				return 32;
+		}
+
+		nmem_tcache_free(grown);
+	}
+
+	if (nmem_tcache_realloc(nmem_tcache_alloc(8), 0) != NULL)
+		return 33;
+
+	size_t t, i;
+	for (t = 0; t < TEST_TCACHE_THREADS; t++) {
+		for (i = 0; i < TEST_TCACHE_BLOCKS; i++) {
+			test_tcache_blocks[t][i] = nmem_tcache_alloc(i % 500);
+			if (test_tcache_blocks[t][i] == NULL)
+				return 34;
+		}
+	}
+
+	bool failed = false;
+
+#ifdef _WIN32
+	HANDLE threads[TEST_TCACHE_THREADS];
+	for (t = 0; t < TEST_TCACHE_THREADS; t++)
+		threads[t] = CreateThread(NULL, 0, test_tcache_run, (LPVOID)t,
+					  0, NULL);
+
+	for (t = 0; t < TEST_TCACHE_THREADS; t++) {
+		DWORD code;
+		WaitForSingleObject(threads[t], INFINITE);
+		if (GetExitCodeThread(threads[t], &code) && code != 0)
+			failed = true;
+
+		CloseHandle(threads[t]);
+	}
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_TCACHE_THREADS];
+	for (t = 0; t < TEST_TCACHE_THREADS; t++)
+		pthread_create(&threads[t], NULL, test_tcache_run, (void *)t);
+
+	for (t = 0; t < TEST_TCACHE_THREADS; t++) {
+		void *ret;
+		pthread_join(threads[t], &ret);
+		if (ret != NULL)
+			failed = true;
+	}
+#endif /* ifndef _WIN32 */
+
+	return failed ? 35 : 0;
+}
+
+#define TEST_TRACE_THREADS 4
+#define TEST_TRACE_BLOCKS 1000
+
+static const char test_trace_file[] = "test_trace";
+static nmem_trace_stat_t test_trace_stats[NMEM_TRACE_MAX_SITES];
+
+static const nmem_trace_stat_t *test_trace_find(int line)
+{
+	size_t count = nmem_trace_snapshot(test_trace_stats,
+					   NMEM_TRACE_MAX_SITES);
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		if (test_trace_stats[i].file == test_trace_file &&
+		    test_trace_stats[i].line == line)
+			return &test_trace_stats[i];
+	}
+
+	return NULL;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI test_trace_run(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_trace_run(void *param)
+#endif /* ifndef _WIN32 */
+{
+	size_t i;
+	for (i = 0; i < TEST_TRACE_BLOCKS; i++)
+		nmem_trace_free(nmem_trace_alloc(64, test_trace_file, 3));
+
+	return 0;
+}
+
+static int test_trace(void)
+{
+	void *blocks[10];
+
+	size_t i;
+	for (i = 0; i < 10; i++) {
+		blocks[i] = nmem_trace_alloc(100, test_trace_file, 1);
+		if (blocks[i] == NULL)
+			return 40;
+	}
+
+	for (i = 0; i < 6; i++)
+		nmem_trace_free(blocks[i]);
+
+	blocks[6] = nmem_trace_realloc(blocks[6], 5000, test_trace_file, 2);
+	if (blocks[6] == NULL)
+		return 41;
+
+	const nmem_trace_stat_t *stat = test_trace_find(1);
+	if (stat == NULL || stat->allocs != 10 || stat->frees != 7 ||
+	    stat->bytes != 1000 || stat->live != 300 ||
+	    stat->live_blocks != 3 || stat->peak != 1000 ||
+	    stat->histogram[2] != 10)
+		return 42;
+
+	stat = test_trace_find(2);
+	if (stat == NULL || stat->allocs != 1 || stat->live != 5000)
+		return 43;
+
+	for (i = 6; i < 10; i++)
+		nmem_trace_free(blocks[i]);
+
+	stat = test_trace_find(1);
+	if (stat == NULL || stat->live != 0 || stat->live_blocks != 0)
+		return 44;
+
+	size_t t;
+
+#ifdef _WIN32
+	HANDLE threads[TEST_TRACE_THREADS];
+	for (t = 0; t < TEST_TRACE_THREADS; t++)
+		threads[t] = CreateThread(NULL, 0, test_trace_run, NULL, 0,
+					  NULL);
+
+	for (t = 0; t < TEST_TRACE_THREADS; t++) {
+		WaitForSingleObject(threads[t], INFINITE);
+		CloseHandle(threads[t]);
+	}
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_TRACE_THREADS];
+	for (t = 0; t < TEST_TRACE_THREADS; t++)
+		pthread_create(&threads[t], NULL, test_trace_run, NULL);
+
+	for (t = 0; t < TEST_TRACE_THREADS; t++)
+		pthread_join(threads[t], NULL);
+#endif /* ifndef _WIN32 */
+
+	stat = test_trace_find(3);
+	if (stat == NULL ||
+	    stat->allocs != TEST_TRACE_THREADS * TEST_TRACE_BLOCKS ||
+	    stat->frees != stat->allocs || stat->live != 0 || stat->peak == 0)
+		return 45;
+
+	return 0;
+}
+
+static int test_large(void)
+{
+	if (nmem_alloc_large(0, 0) != NULL)
+		return 50;
+
+	size_t sizes[] = { 100, 3 * NMEM_LARGE_HUGE_SIZE + 5 };
+
+	size_t i;
+	for (i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		size_t size = sizes[i];
+		unsigned char *block =
+			nmem_alloc_large(size, NMEM_LARGE_PREFAULT);
+		if (block == NULL)
+			return 51;
+
+		if (size >= NMEM_LARGE_HUGE_SIZE &&
+		    (uintptr_t)block % NMEM_LARGE_HUGE_SIZE != 0)
+			return 52;
+
+		if (block[0] != 0 || block[size - 1] != 0)
+			return 53;
+
+		memset(block, 0x5a, size);
+		if (block[size / 2] != 0x5a)
+			return 54;
+
+		nmem_free_large(block, size);
+	}
+
+	return 0;
+}
+
+struct test_aligned_counter {
+	uint64_t value;
+	NMEM_CACHE_PAD(pad, sizeof(uint64_t));
+};
+
+static int test_aligned(void)
+{
+	if (sizeof(struct test_aligned_counter) != NMEM_CACHE_LINE)
+		return 60;
+
+	if (N_ALLOC_ALIGNED(16, 24) != NULL)
+		return 61;
+
+	size_t align;
+	for (align = 1; align <= 4096; align <<= 1) {
+		unsigned char *block = N_ALLOC_ALIGNED(align * 3 + 1, align);
+		if (block == NULL || (uintptr_t)block % align != 0)
+			return 62;
+
+		memset(block, 0xcd, align * 3 + 1);
+		N_FREE_ALIGNED(block);
+	}
+
+	struct test_aligned_counter *counters =
+		N_ALLOC_ALIGNED(4 * sizeof(*counters), NMEM_CACHE_LINE);
+	if (counters == NULL || (uintptr_t)&counters[1] % NMEM_CACHE_LINE != 0)
+		return 63;
+
+	N_FREE_ALIGNED(counters);
+	return 0;
+}
+
+NVEC_DEFINE(test_vec, int)
+
+static int test_vec(void)
+{
+	int inline_block[8];
+
+	test_vec_t vec;
+	NVEC_INIT_INLINE(test_vec, &vec, inline_block);
+
+	int i;
+	for (i = 0; i < 8; i++) {
+		if (HAS_ERR(test_vec_push(&vec, i)))
+			return 70;
+	}
+
+	if (vec.data != inline_block)
+		return 71;
+
+	for (i = 8; i < 10000; i++) {
+		if (HAS_ERR(test_vec_push(&vec, i)))
+			return 72;
+	}
+
+	if (NVEC_LENGTH(&vec) != 10000 || vec.capacity > 2 * 10000)
+		return 73;
+
+	int expected = 0;
+	int *it;
+	NVEC_FOREACH(&vec, it)
+	{
+		if (*it != expected++)
+			return 74;
+	}
+
+	test_vec_destroy(&vec);
+
+	test_vec_t heap = NVEC_INIT;
+	if (HAS_ERR(test_vec_reserve(&heap, 100)) || heap.capacity < 100 ||
+	    NVEC_LENGTH(&heap) != 0)
+		return 75;
+
+	int *slot = test_vec_emplace(&heap);
+	if (slot == NULL || NVEC_LENGTH(&heap) != 1)
+		return 76;
+
+	test_vec_destroy(&heap);
+	return 0;
+}
+
+static int test_strbuf(void)
+{
+	nstrbuf_t sb = NSTRBUF_INIT;
+
+	if (HAS_ERR(nstrbuf_append_str(&sb, "hello")) ||
+	    HAS_ERR(nstrbuf_append_char(&sb, ' ')) ||
+	    HAS_ERR(nstrbuf_printf(&sb, "%d-%s", 42, "x")))
+		return 80;
+
+	if (sb.data != NULL || strcmp(NSTRBUF_DATA(&sb), "hello 42-x") != 0)
+		return 81;
+
+	int i;
+	for (i = 0; i < 1000; i++) {
+		if (HAS_ERR(nstrbuf_printf(&sb, "[%04d]", i)))
+			return 82;
+	}
+
+	if (NSTRBUF_LENGTH(&sb) != 10 + 1000 * 6 ||
+	    strlen(NSTRBUF_DATA(&sb)) != NSTRBUF_LENGTH(&sb) ||
+	    memcmp(NSTRBUF_DATA(&sb) + NSTRBUF_LENGTH(&sb) - 6, "[0999]", 6))
+		return 83;
+
+	// Clearing keeps the heap block for the next round
+	char *data = sb.data;
+	nstrbuf_clear(&sb);
+	if (sb.data != data || NSTRBUF_DATA(&sb)[0] != '\0')
+		return 84;
+
+	if (HAS_ERR(nstrbuf_printf(&sb, "%0*d", 500, 7)) ||
+	    sb.data != data || NSTRBUF_LENGTH(&sb) != 500)
+		return 85;
+
+	nstrbuf_destroy(&sb);
+	if (sb.data != NULL || NSTRBUF_LENGTH(&sb) != 0)
+		return 86;
+
+	return 0;
+}
+
+int main()
+{
+	if (HAS_ERR(neptune_init()))
+		return EXIT_FAILURE;
+
+	int ret = test_arena();
+	if (ret != 0) {
+		printf("nmem_arena failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_pool();
+	if (ret != 0) {
+		printf("nmem_pool failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_tcache();
+	if (ret != 0) {
+		printf("nmem_tcache failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_trace();
+	if (ret != 0) {
+		printf("nmem_trace failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_large();
+	if (ret != 0) {
+		printf("nmem_large failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_aligned();
+	if (ret != 0) {
+		printf("nmem_aligned failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_vec();
+	if (ret != 0) {
+		printf("nvec failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_strbuf();
+	if (ret != 0) {
+		printf("nstrbuf failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	neptune_destroy();
+
+	printf("Everything is OK!!!\n");
+	return EXIT_SUCCESS;
+}
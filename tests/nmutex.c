@@ -0,0 +1,586 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "neptune.h"
+#include "natomic.h"
+#include "nmutex.h"
+#include "nrwlock.h"
+#include "nseqlock.h"
+#include "nwait.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_MUTEX_THREADS 4
+#define TEST_MUTEX_ROUNDS 200000
+
+// Never passed to NMUTEX_INIT, static initialization must be enough
+static NMUTEX_DEFINE(test_mutex_lock);
+static size_t test_mutex_counter;
+
+#ifdef _WIN32
+static DWORD WINAPI test_mutex_run(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_mutex_run(void *param)
+#endif /* ifndef _WIN32 */
+{
+	size_t i;
+	for (i = 0; i < TEST_MUTEX_ROUNDS; i++) {
+		NMUTEX_LOCK(test_mutex_lock);
+
+		// Split read and write so lost updates would show up
+		size_t value = test_mutex_counter;
+		test_mutex_counter = value + 1;
+
+		NMUTEX_UNLOCK(test_mutex_lock);
+	}
+
+	return 0;
+}
+
+static int test_mutex(void)
+{
+	NMUTEX local;
+	NMUTEX_INIT(local);
+	NMUTEX_LOCK(local);
+	NMUTEX_UNLOCK(local);
+#ifdef NMUTEX_DESTROY
+	NMUTEX_DESTROY(local);
+#endif /* ifdef NMUTEX_DESTROY */
+
+	size_t t;
+
+#ifdef _WIN32
+	HANDLE threads[TEST_MUTEX_THREADS];
+	for (t = 0; t < TEST_MUTEX_THREADS; t++)
+		threads[t] = CreateThread(NULL, 0, test_mutex_run, NULL, 0,
+					  NULL);
+
+	for (t = 0; t < TEST_MUTEX_THREADS; t++) {
+		WaitForSingleObject(threads[t], INFINITE);
+		CloseHandle(threads[t]);
+	}
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_MUTEX_THREADS];
+	for (t = 0; t < TEST_MUTEX_THREADS; t++)
+		pthread_create(&threads[t], NULL, test_mutex_run, NULL);
+
+	for (t = 0; t < TEST_MUTEX_THREADS; t++)
+		pthread_join(threads[t], NULL);
+#endif /* ifndef _WIN32 */
+
+	if (test_mutex_counter != TEST_MUTEX_THREADS * TEST_MUTEX_ROUNDS)
+		return 10;
+
+	return 0;
+}
+
+#define TEST_RWLOCK_READERS 3
+#define TEST_RWLOCK_ROUNDS 100000
+
+struct test_rwlock_ctx {
+	NRWLOCK lock;
+	size_t a; // Always equal to b outside the write lock
+	size_t b;
+	bool torn;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI test_rwlock_read(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_rwlock_read(void *param)
+#endif /* ifndef _WIN32 */
+{
+	struct test_rwlock_ctx *ctx = param;
+
+	size_t i;
+	for (i = 0; i < TEST_RWLOCK_ROUNDS; i++) {
+		NRWLOCK_READ_LOCK(ctx->lock);
+		if (ctx->a != ctx->b)
+			ctx->torn = true;
+		NRWLOCK_READ_UNLOCK(ctx->lock);
+	}
+
+	return 0;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI test_rwlock_write(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_rwlock_write(void *param)
+#endif /* ifndef _WIN32 */
+{
+	struct test_rwlock_ctx *ctx = param;
+
+	size_t i;
+	for (i = 0; i < TEST_RWLOCK_ROUNDS; i++) {
+		NRWLOCK_WRITE_LOCK(ctx->lock);
+		ctx->a++;
+		ctx->b++;
+		NRWLOCK_WRITE_UNLOCK(ctx->lock);
+	}
+
+	return 0;
+}
+
+static int test_rwlock_run(bool prefer_writers)
+{
+	struct test_rwlock_ctx ctx;
+	memset(&ctx, 0, sizeof(ctx));
+
+	if (prefer_writers)
+		NRWLOCK_INIT_WRITER(ctx.lock);
+	else
+		NRWLOCK_INIT(ctx.lock);
+
+	size_t t;
+
+#ifdef _WIN32
+	HANDLE threads[TEST_RWLOCK_READERS + 1];
+	for (t = 0; t <= TEST_RWLOCK_READERS; t++)
+		threads[t] = CreateThread(NULL, 0,
+					  t == 0 ? test_rwlock_write :
+						   test_rwlock_read,
+					  &ctx, 0, NULL);
+
+	for (t = 0; t <= TEST_RWLOCK_READERS; t++) {
+		WaitForSingleObject(threads[t], INFINITE);
+		CloseHandle(threads[t]);
+	}
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_RWLOCK_READERS + 1];
+	for (t = 0; t <= TEST_RWLOCK_READERS; t++)
+		pthread_create(&threads[t], NULL,
+			       t == 0 ? test_rwlock_write : test_rwlock_read,
+			       &ctx);
+
+	for (t = 0; t <= TEST_RWLOCK_READERS; t++)
+		pthread_join(threads[t], NULL);
+#endif /* ifndef _WIN32 */
+
+#ifdef NRWLOCK_DESTROY
+	NRWLOCK_DESTROY(ctx.lock);
+#endif /* ifdef NRWLOCK_DESTROY */
+
+	if (ctx.torn)
+		return 20;
+
+	if (ctx.a != TEST_RWLOCK_ROUNDS)
+		return 21;
+
+	return 0;
+}
+
+static int test_rwlock(void)
+{
+	int ret = test_rwlock_run(false);
+	if (ret != 0)
+		return ret;
+
+	ret = test_rwlock_run(true);
+	return ret != 0 ? ret + 2 : 0;
+}
+
+#define TEST_SEQLOCK_READERS 3
+#define TEST_SEQLOCK_ROUNDS 100000
+
+struct test_seqlock_data {
+	size_t value;
+	size_t twice; // Always twice value for a consistent copy
+};
+
+static NSEQLOCK_DEFINE(test_seqlock_lock);
+static struct test_seqlock_data test_seqlock_shared;
+static volatile bool test_seqlock_torn;
+
+#ifdef _WIN32
+static DWORD WINAPI test_seqlock_read(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_seqlock_read(void *param)
+#endif /* ifndef _WIN32 */
+{
+	size_t i;
+	for (i = 0; i < TEST_SEQLOCK_ROUNDS; i++) {
+		struct test_seqlock_data copy;
+		unsigned seq;
+
+		do {
+			seq = NSEQLOCK_READ_BEGIN(test_seqlock_lock);
+			copy = test_seqlock_shared;
+		} while (NSEQLOCK_READ_RETRY(test_seqlock_lock, seq));
+
+		if (copy.twice != copy.value * 2)
+			test_seqlock_torn = true;
+	}
+
+	return 0;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI test_seqlock_write(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_seqlock_write(void *param)
+#endif /* ifndef _WIN32 */
+{
+	size_t i;
+	for (i = 1; i <= TEST_SEQLOCK_ROUNDS; i++) {
+		NSEQLOCK_WRITE_LOCK(test_seqlock_lock);
+		test_seqlock_shared.value = i;
+		test_seqlock_shared.twice = i * 2;
+		NSEQLOCK_WRITE_UNLOCK(test_seqlock_lock);
+	}
+
+	return 0;
+}
+
+static int test_seqlock(void)
+{
+	size_t t;
+
+#ifdef _WIN32
+	HANDLE threads[TEST_SEQLOCK_READERS + 1];
+	for (t = 0; t <= TEST_SEQLOCK_READERS; t++)
+		threads[t] = CreateThread(NULL, 0,
+					  t == 0 ? test_seqlock_write :
+						   test_seqlock_read,
+					  NULL, 0, NULL);
+
+	for (t = 0; t <= TEST_SEQLOCK_READERS; t++) {
+		WaitForSingleObject(threads[t], INFINITE);
+		CloseHandle(threads[t]);
+	}
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_SEQLOCK_READERS + 1];
+	for (t = 0; t <= TEST_SEQLOCK_READERS; t++)
+		pthread_create(&threads[t], NULL,
+			       t == 0 ? test_seqlock_write : test_seqlock_read,
+			       NULL);
+
+	for (t = 0; t <= TEST_SEQLOCK_READERS; t++)
+		pthread_join(threads[t], NULL);
+#endif /* ifndef _WIN32 */
+
+	if (test_seqlock_torn)
+		return 30;
+
+	if (test_seqlock_shared.value != TEST_SEQLOCK_ROUNDS)
+		return 31;
+
+	return 0;
+}
+
+#define TEST_ATOMIC_THREADS 4
+#define TEST_ATOMIC_ROUNDS 100000
+
+static natomic32_t test_atomic_added = NATOMIC32_INIT(0);
+static natomic64_t test_atomic_swapped = NATOMIC64_INIT(0);
+
+#ifdef _WIN32
+static DWORD WINAPI test_atomic_run(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_atomic_run(void *param)
+#endif /* ifndef _WIN32 */
+{
+	size_t i;
+	for (i = 0; i < TEST_ATOMIC_ROUNDS; i++) {
+		natomic32_fetch_add(&test_atomic_added, 1, NATOMIC_RELAXED);
+
+		// A failed swap reloads the value, so the loop needs no load
+		uint64_t value = 0;
+		while (!natomic64_cas(&test_atomic_swapped, &value, value + 1,
+				      NATOMIC_ACQ_REL))
+			NATOMIC_PAUSE();
+	}
+
+	return 0;
+}
+
+static int test_atomic(void)
+{
+	natomic32_t word = NATOMIC32_INIT(7);
+	if (natomic32_exchange(&word, 9, NATOMIC_SEQ_CST) != 7 ||
+	    natomic32_load(&word, NATOMIC_ACQUIRE) != 9)
+		return 50;
+
+	uint32_t expected = 8;
+	if (natomic32_cas(&word, &expected, 10, NATOMIC_SEQ_CST) ||
+	    expected != 9)
+		return 51;
+
+	int target;
+	natomic_ptr_t ptr = NATOMIC_PTR_INIT(NULL);
+	void *seen = NULL;
+	if (!natomic_ptr_cas(&ptr, &seen, &target, NATOMIC_RELEASE) ||
+	    natomic_ptr_exchange(&ptr, NULL, NATOMIC_ACQ_REL) != &target)
+		return 52;
+
+	size_t t;
+
+#ifdef _WIN32
+	HANDLE threads[TEST_ATOMIC_THREADS];
+	for (t = 0; t < TEST_ATOMIC_THREADS; t++)
+		threads[t] = CreateThread(NULL, 0, test_atomic_run, NULL, 0,
+					  NULL);
+
+	for (t = 0; t < TEST_ATOMIC_THREADS; t++) {
+		WaitForSingleObject(threads[t], INFINITE);
+		CloseHandle(threads[t]);
+	}
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_ATOMIC_THREADS];
+	for (t = 0; t < TEST_ATOMIC_THREADS; t++)
+		pthread_create(&threads[t], NULL, test_atomic_run, NULL);
+
+	for (t = 0; t < TEST_ATOMIC_THREADS; t++)
+		pthread_join(threads[t], NULL);
+#endif /* ifndef _WIN32 */
+
+	uint64_t total = TEST_ATOMIC_THREADS * TEST_ATOMIC_ROUNDS;
+	if (natomic32_load(&test_atomic_added, NATOMIC_RELAXED) != total)
+		return 53;
+
+	if (natomic64_load(&test_atomic_swapped, NATOMIC_RELAXED) != total)
+		return 54;
+
+	return 0;
+}
+
+#define TEST_WAIT_THREADS 3
+#define TEST_WAIT_ITEMS 10000
+
+static NEVENT_DEFINE(test_wait_start);
+static natomic32_t test_wait_word = NATOMIC32_INIT(0);
+static natomic32_t test_wait_started = NATOMIC32_INIT(0);
+
+static NMUTEX_DEFINE(test_wait_lock);
+static NCOND_DEFINE(test_wait_cond);
+static size_t test_wait_queued; // Items produced and not consumed yet
+static size_t test_wait_consumed;
+
+#ifdef _WIN32
+static DWORD WINAPI test_wait_run(LPVOID param)
+#else /* ifndef _WIN32 */
+static void *test_wait_run(void *param)
+#endif /* ifndef _WIN32 */
+{
+	NEVENT_WAIT(test_wait_start);
+	natomic32_fetch_add(&test_wait_started, 1, NATOMIC_RELEASE);
+
+	uint32_t word;
+	while ((word = natomic32_load(&test_wait_word, NATOMIC_ACQUIRE)) == 0)
+		nwait_on_address(&test_wait_word, word);
+
+	// Consume until every item has been taken by some thread
+	NMUTEX_LOCK(test_wait_lock);
+	while (test_wait_consumed < TEST_WAIT_ITEMS) {
+		if (test_wait_queued == 0) {
+			NCOND_WAIT(test_wait_cond, test_wait_lock);
+			continue;
+		}
+
+		test_wait_queued--;
+		test_wait_consumed++;
+	}
+	NMUTEX_UNLOCK(test_wait_lock);
+
+	return 0;
+}
+
+static int test_wait(void)
+{
+	if (NEVENT_IS_SET(test_wait_start))
+		return 60;
+
+	size_t t;
+
+#ifdef _WIN32
+	HANDLE threads[TEST_WAIT_THREADS];
+	for (t = 0; t < TEST_WAIT_THREADS; t++)
+		threads[t] = CreateThread(NULL, 0, test_wait_run, NULL, 0,
+					  NULL);
+#else /* ifndef _WIN32 */
+	pthread_t threads[TEST_WAIT_THREADS];
+	for (t = 0; t < TEST_WAIT_THREADS; t++)
+		pthread_create(&threads[t], NULL, test_wait_run, NULL);
+#endif /* ifndef _WIN32 */
+
+	if (natomic32_load(&test_wait_started, NATOMIC_ACQUIRE) != 0)
+		return 61;
+
+	NEVENT_SET(test_wait_start);
+	NEVENT_WAIT(test_wait_start);
+
+	natomic32_store(&test_wait_word, 1, NATOMIC_RELEASE);
+	nwake_all(&test_wait_word);
+
+	size_t i;
+	for (i = 0; i < TEST_WAIT_ITEMS; i++) {
+		NMUTEX_LOCK(test_wait_lock);
+		test_wait_queued++;
+		NMUTEX_UNLOCK(test_wait_lock);
+
+		if (i % 2 == 0)
+			NCOND_SIGNAL(test_wait_cond);
+		else
+			NCOND_BROADCAST(test_wait_cond);
+	}
+
+	// Consumers still asleep must see that nothing more is coming
+	NCOND_BROADCAST(test_wait_cond);
+
+#ifdef _WIN32
+	for (t = 0; t < TEST_WAIT_THREADS; t++) {
+		WaitForSingleObject(threads[t], INFINITE);
+		CloseHandle(threads[t]);
+	}
+#else /* ifndef _WIN32 */
+	for (t = 0; t < TEST_WAIT_THREADS; t++)
+		pthread_join(threads[t], NULL);
+#endif /* ifndef _WIN32 */
+
+	if (natomic32_load(&test_wait_started, NATOMIC_RELAXED) !=
+	    TEST_WAIT_THREADS)
+		return 62;
+
+	if (test_wait_consumed != TEST_WAIT_ITEMS || test_wait_queued != 0)
+		return 63;
+
+	NEVENT_RESET(test_wait_start);
+	if (NEVENT_IS_SET(test_wait_start))
+		return 64;
+
+	return 0;
+}
+
+#ifdef NMUTEX_PROFILE
+
+static nmutex_profile_stat_t test_profile_stats[NMUTEX_PROFILE_MAX_SITES];
+
+static int test_profile(void)
+{
+	NMUTEX_DEFINE(profile_lock);
+
+	int i;
+	for (i = 0; i < 100; i++) {
+		NMUTEX_LOCK(profile_lock);
+		NMUTEX_UNLOCK(profile_lock);
+	}
+
+	size_t count = nmutex_profile_snapshot(test_profile_stats,
+					       NMUTEX_PROFILE_MAX_SITES);
+
+	bool seen_profile = false, seen_counter = false;
+
+	size_t s;
+	for (s = 0; s < count; s++) {
+		nmutex_profile_stat_t *stat = &test_profile_stats[s];
+		if (strcmp(stat->file, __FILE__) != 0)
+			continue;
+
+		uint64_t holds = 0;
+
+		size_t b;
+		for (b = 0; b < NMUTEX_PROFILE_BUCKETS; b++)
+			holds += stat->hold_histogram[b];
+
+		if (holds != stat->acquires || stat->contended > stat->acquires)
+			return 40;
+
+		if (strcmp(stat->name, "profile_lock") == 0) {
+			if (stat->acquires != 100 || stat->contended != 0)
+				return 41;
+
+			seen_profile = true;
+		} else if (strcmp(stat->name, "test_mutex_lock") == 0) {
+			if (stat->acquires !=
+			    TEST_MUTEX_THREADS * TEST_MUTEX_ROUNDS)
+				return 42;
+
+			seen_counter = true;
+		}
+	}
+
+	if (!seen_profile || !seen_counter)
+		return 43;
+
+	return 0;
+}
+
+#endif /* ifdef NMUTEX_PROFILE */
+
+int main()
+{
+	if (HAS_ERR(neptune_init()))
+		return EXIT_FAILURE;
+
+	int ret = test_mutex();
+	if (ret != 0) {
+		printf("nmutex failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_rwlock();
+	if (ret != 0) {
+		printf("nrwlock failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_seqlock();
+	if (ret != 0) {
+		printf("nseqlock failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_atomic();
+	if (ret != 0) {
+		printf("natomic failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_wait();
+	if (ret != 0) {
+		printf("nwait failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+#ifdef NMUTEX_PROFILE
+	ret = test_profile();
+	if (ret != 0) {
+		printf("nmutex_profile failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+#endif /* ifdef NMUTEX_PROFILE */
+
+	neptune_destroy();
+
+	printf("Everything is OK!!!\n");
+	return EXIT_SUCCESS;
+}
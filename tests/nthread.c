@@ -0,0 +1,385 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2024, 2025 Serkan Aksoy
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "neptune.h"
+#include "natomic.h"
+#include "nqueue.h"
+#include "nthread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sched.h>
+#endif /* ifndef _WIN32 */
+
+#define TEST_SUBMIT_TASKS 10000
+
+static natomic32_t test_submit_counter = NATOMIC32_INIT(0);
+
+static void test_submit_run(void *ctx)
+{
+	natomic32_fetch_add(&test_submit_counter, (uint32_t)(uintptr_t)ctx,
+			    NATOMIC_RELAXED);
+}
+
+static int test_submit(void)
+{
+	if (nthread_workers() != NTHREAD_WORKERS)
+		return 10;
+
+	nthread_group_t group = NTHREAD_GROUP_INIT;
+
+	size_t i;
+	for (i = 0; i < TEST_SUBMIT_TASKS; i++)
+		nthread_submit(&group, test_submit_run, (void *)(uintptr_t)1);
+
+	nthread_wait(&group);
+
+	if (natomic32_load(&test_submit_counter, NATOMIC_RELAXED) !=
+	    TEST_SUBMIT_TASKS)
+		return 11;
+
+	// Waiting on a finished or empty group returns at once
+	nthread_wait(&group);
+	return 0;
+}
+
+#define TEST_TREE_DEPTH 12
+
+struct test_tree_node {
+	size_t depth;
+	size_t leaves;
+};
+
+// Every node waits on its children, which workers steal from each other
+static void test_tree_run(void *ctx)
+{
+	struct test_tree_node *node = ctx;
+	if (node->depth == 0) {
+		node->leaves = 1;
+		return;
+	}
+
+	struct test_tree_node left = { node->depth - 1, 0 };
+	struct test_tree_node right = { node->depth - 1, 0 };
+
+	nthread_group_t group = NTHREAD_GROUP_INIT;
+	nthread_submit(&group, test_tree_run, &left);
+	nthread_submit(&group, test_tree_run, &right);
+	nthread_wait(&group);
+
+	node->leaves = left.leaves + right.leaves;
+}
+
+static int test_tree(void)
+{
+	struct test_tree_node root = { TEST_TREE_DEPTH, 0 };
+
+	nthread_group_t group = NTHREAD_GROUP_INIT;
+	nthread_submit(&group, test_tree_run, &root);
+	nthread_wait(&group);
+
+	if (root.leaves != (size_t)1 << TEST_TREE_DEPTH)
+		return 20;
+
+	return 0;
+}
+
+#define TEST_FOR_LENGTH 100003
+
+static uint8_t test_for_marks[TEST_FOR_LENGTH];
+
+static void test_for_run(void *ctx, size_t begin, size_t end)
+{
+	if (begin >= end)
+		*(bool *)ctx = true;
+
+	size_t i;
+	for (i = begin; i < end; i++)
+		test_for_marks[i]++;
+}
+
+static void test_for_called(void *ctx, size_t begin, size_t end)
+{
+	*(bool *)ctx = true;
+}
+
+static int test_for_grain(size_t begin, size_t grain)
+{
+	memset(test_for_marks, 0, sizeof(test_for_marks));
+
+	bool empty = false;
+	nthread_parallel_for(begin, TEST_FOR_LENGTH, grain, test_for_run,
+			     &empty);
+	if (empty)
+		return 30;
+
+	size_t i;
+	for (i = 0; i < TEST_FOR_LENGTH; i++) {
+		if (test_for_marks[i] != (i >= begin ? 1 : 0))
+			return 31;
+	}
+
+	return 0;
+}
+
+static int test_for(void)
+{
+	int ret = test_for_grain(0, 0);
+	if (ret != 0)
+		return ret;
+
+	ret = test_for_grain(5, 7);
+	if (ret != 0)
+		return ret;
+
+	ret = test_for_grain(0, TEST_FOR_LENGTH * 2);
+	if (ret != 0)
+		return ret;
+
+	bool called = false;
+	nthread_parallel_for(10, 10, 0, test_for_called, &called);
+	if (called)
+		return 32;
+
+	return 0;
+}
+
+#define TEST_QUEUE_ITEMS 100000
+#define TEST_QUEUE_PRODUCERS 2
+
+static nspsc_t test_spsc;
+
+// Lets the other side run when both share a core
+static void test_queue_yield(void)
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else /* ifndef _WIN32 */
+	sched_yield();
+#endif /* ifndef _WIN32 */
+}
+
+// Pushes 1..TEST_QUEUE_ITEMS in batches of varying size
+static void test_spsc_produce(void *ctx)
+{
+	void *batch[7];
+	size_t next = 1;
+
+	while (next <= TEST_QUEUE_ITEMS) {
+		size_t count = next % 7 + 1;
+		if (count > TEST_QUEUE_ITEMS + 1 - next)
+			count = TEST_QUEUE_ITEMS + 1 - next;
+
+		size_t i;
+		for (i = 0; i < count; i++)
+			batch[i] = (void *)(uintptr_t)(next + i);
+
+		size_t done = 0;
+		while (done < count) {
+			size_t pushed = nspsc_push_batch(
+				&test_spsc, batch + done, count - done);
+			if (pushed == 0)
+				test_queue_yield();
+			done += pushed;
+		}
+
+		next += count;
+	}
+}
+
+static int test_spsc_run(void)
+{
+	if (HAS_ERR(nspsc_init(&test_spsc, 50)))
+		return 40;
+
+	nthread_group_t group = NTHREAD_GROUP_INIT;
+	nthread_submit(&group, test_spsc_produce, NULL);
+
+	void *batch[5];
+	size_t expected = 1;
+	int ret = 0;
+
+	while (expected <= TEST_QUEUE_ITEMS && ret == 0) {
+		size_t count = 0;
+		if (expected % 2 == 0)
+			count = nspsc_pop_batch(&test_spsc, batch, 5);
+		else if (nspsc_pop(&test_spsc, &batch[0]))
+			count = 1;
+
+		if (count == 0)
+			test_queue_yield();
+
+		size_t i;
+		for (i = 0; i < count; i++) {
+			if ((uintptr_t)batch[i] != expected++)
+				ret = 41;
+		}
+	}
+
+	nthread_wait(&group);
+
+	if (ret == 0 && nspsc_pop(&test_spsc, &batch[0]))
+		ret = 42;
+
+	nspsc_destroy(&test_spsc);
+	return ret;
+}
+
+static nmpmc_t test_mpmc;
+static natomic32_t test_mpmc_taken = NATOMIC32_INIT(0);
+static natomic64_t test_mpmc_sum = NATOMIC64_INIT(0);
+static natomic32_t test_mpmc_unordered = NATOMIC32_INIT(0);
+
+// Items carry their producer in the top byte and a sequence below
+static void test_mpmc_produce(void *ctx)
+{
+	uintptr_t producer = (uintptr_t)ctx << 24;
+
+	uintptr_t i;
+	for (i = 1; i <= TEST_QUEUE_ITEMS; i++) {
+		void *item = (void *)(producer | i);
+
+		if (i % 3 == 0) {
+			while (nmpmc_push_batch(&test_mpmc, &item, 1) == 0)
+				test_queue_yield();
+		} else {
+			while (!nmpmc_push(&test_mpmc, item))
+				test_queue_yield();
+		}
+	}
+}
+
+static void test_mpmc_consume(void *ctx)
+{
+	uintptr_t last[TEST_QUEUE_PRODUCERS] = { 0 };
+	uint32_t total = TEST_QUEUE_PRODUCERS * TEST_QUEUE_ITEMS;
+
+	while (natomic32_load(&test_mpmc_taken, NATOMIC_RELAXED) < total) {
+		void *batch[4];
+		size_t count = nmpmc_pop_batch(&test_mpmc, batch, 4);
+		if (count == 0) {
+			test_queue_yield();
+			continue;
+		}
+
+		size_t i;
+		for (i = 0; i < count; i++) {
+			uintptr_t item = (uintptr_t)batch[i];
+			uintptr_t producer = item >> 24;
+			uintptr_t seq = item & 0xffffff;
+
+			// Each producer's items come out in the order it pushed them
+			if (seq <= last[producer])
+				natomic32_store(&test_mpmc_unordered, 1,
+						NATOMIC_RELAXED);
+			last[producer] = seq;
+
+			natomic64_fetch_add(&test_mpmc_sum, seq,
+					    NATOMIC_RELAXED);
+		}
+
+		natomic32_fetch_add(&test_mpmc_taken, (uint32_t)count,
+				    NATOMIC_RELAXED);
+	}
+}
+
+static int test_mpmc_run(void)
+{
+	if (HAS_ERR(nmpmc_init(&test_mpmc, 100)))
+		return 50;
+
+	nthread_group_t group = NTHREAD_GROUP_INIT;
+
+	uintptr_t p;
+	for (p = 0; p < TEST_QUEUE_PRODUCERS; p++)
+		nthread_submit(&group, test_mpmc_produce, (void *)p);
+	nthread_submit(&group, test_mpmc_consume, NULL);
+
+	test_mpmc_consume(NULL);
+	nthread_wait(&group);
+
+	int ret = 0;
+	uint64_t sum = (uint64_t)TEST_QUEUE_ITEMS * (TEST_QUEUE_ITEMS + 1) / 2;
+	if (natomic64_load(&test_mpmc_sum, NATOMIC_RELAXED) !=
+	    sum * TEST_QUEUE_PRODUCERS)
+		ret = 51;
+	else if (natomic32_load(&test_mpmc_unordered, NATOMIC_RELAXED) != 0)
+		ret = 52;
+
+	void *item;
+	if (ret == 0 && nmpmc_pop(&test_mpmc, &item))
+		ret = 53;
+
+	nmpmc_destroy(&test_mpmc);
+	return ret;
+}
+
+int main()
+{
+	if (HAS_ERR(neptune_init()))
+		return EXIT_FAILURE;
+
+	int ret = test_submit();
+	if (ret != 0) {
+		printf("nthread_submit failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_tree();
+	if (ret != 0) {
+		printf("nthread_wait failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_for();
+	if (ret != 0) {
+		printf("nthread_parallel_for failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_spsc_run();
+	if (ret != 0) {
+		printf("nspsc failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	ret = test_mpmc_run();
+	if (ret != 0) {
+		printf("nmpmc failed (%d)\n", ret);
+		neptune_destroy();
+		return ret;
+	}
+
+	neptune_destroy();
+
+	printf("Everything is OK!!!\n");
+	return EXIT_SUCCESS;
+}